@@ -68,7 +68,7 @@ AddonsManager::AddonsManager() : m_addons_list(std::vector<Addon>() ),
     m_addons_list.lock();
     // Clear the list in case that a reinit is being done.
     m_addons_list.getData().clear();
-    loadInstalledAddons();
+    loadInstalledAddons(&m_addons_list.getData());
     m_addons_list.unlock();
 }   // AddonsManager
 
@@ -141,117 +141,117 @@ void AddonsManager::init(const XMLNode *xml,
     else
         Log::info("addons", "Using cached addons.xml.");
 
-    const XMLNode* xml_addons = NULL;
     try
     {
-        xml_addons = new XMLNode(filename);
+        addons_manager->initAddons(filename);
     }
     catch (std::exception& e)
     {
         Log::error("addons", "Error %s", e.what());
-    }
-    if (!xml_addons)
         return;
-    addons_manager->initAddons(xml_addons);   // will free xml_addons
+    }
     if(UserConfigParams::logAddons())
         Log::info("addons", "Addons manager list downloaded.");
 }   // init
 
 // ----------------------------------------------------------------------------
-/** This initialises the online portion of the addons manager. It uses the
- *  downloaded list of available addons. It is called from init(), which is
- *  called from a separate thread, so blocking download requests can be used
- *  without blocking the GUI. This function will update the state variable.
- *  \param xml The xml tree of addons.xml with information about all available
- *         addons.
+/** Adds or updates the addon described by one node of addons.xml.
+ *  \param node The xml node of the addon.
+ *  \param list The list of addons to update.
  */
-void AddonsManager::initAddons(const XMLNode *xml)
+void AddonsManager::addAddon(const XMLNode &node, std::vector<Addon> *list)
 {
-    m_addons_list.lock();
-    // Clear the list in case that a reinit is being done.
-    m_addons_list.getData().clear();
-    loadInstalledAddons();
-    m_addons_list.unlock();
+    const std::string &name = node.getName();
+    // Ignore news/redirect, which is handled by the NewsManager
+    if(name=="include" || name=="message")
+        return;
+    if(name!="track" && name!="kart" && name!="arena")
+    {
+        Log::error("addons", "Found invalid node '%s' while downloading addons.",
+                name.c_str());
+        Log::error("addons", "Ignored.");
+        return;
+    }
 
-    for(unsigned int i=0; i<xml->getNumNodes(); i++)
+    Addon addon(node);
+    int index = findAddon(*list, addon.getId());
+
+    int stk_version=0;
+    node.get("format", &stk_version);
+    int   testing=-1;
+    node.get("testing", &testing);
+
+    bool wrong_version=false;
+
+    if(addon.getType()=="kart")
+        wrong_version = stk_version <stk_config->m_min_kart_version ||
+                        stk_version >stk_config->m_max_kart_version   ;
+    else
+        wrong_version = stk_version <stk_config->m_min_track_version ||
+                        stk_version >stk_config->m_max_track_version   ;
+    // If the add-on is included, behave like it is a wrong version
+    if (addon.testIncluded(addon.getMinIncludeVer(), addon.getMaxIncludeVer()))
+        wrong_version = true;
+
+    // Check which version to use: only for this stk version,
+    // and not addons that are marked as hidden (testing=0)
+    if(wrong_version|| testing==0)
     {
-        const XMLNode *node = xml->getNode(i);
-        const std::string &name = node->getName();
-        // Ignore news/redirect, which is handled by the NewsManager
-        if(name=="include" || name=="message")
-            continue;
-        if(node->getName()=="track" || node->getName()=="kart" ||
-            node->getName()=="arena"                                 )
+        // If the version is too old (e.g. after an update of stk)
+        // remove a cached icon.
+        std::string full_path =
+            file_manager->getAddonsFile("icons/"+addon.getIconBasename());
+        if(file_manager->fileExists(full_path))
         {
-            Addon addon(*node);
-            int index = getAddonIndex(addon.getId());
-
-            int stk_version=0;
-            node->get("format", &stk_version);
-            int   testing=-1;
-            node->get("testing", &testing);
-
-            bool wrong_version=false;
-
-            if(addon.getType()=="kart")
-                wrong_version = stk_version <stk_config->m_min_kart_version ||
-                                stk_version >stk_config->m_max_kart_version   ;
-            else
-                wrong_version = stk_version <stk_config->m_min_track_version ||
-                                stk_version >stk_config->m_max_track_version   ;
-            // If the add-on is included, behave like it is a wrong version
-            if (addon.testIncluded(addon.getMinIncludeVer(), addon.getMaxIncludeVer()))
-                wrong_version = true;
-
-            // Check which version to use: only for this stk version,
-            // and not addons that are marked as hidden (testing=0)
-            if(wrong_version|| testing==0)
-            {
-                // If the version is too old (e.g. after an update of stk)
-                // remove a cached icon.
-                std::string full_path =
-                    file_manager->getAddonsFile("icons/"
-                                                +addon.getIconBasename());
-                if(file_manager->fileExists(full_path))
-                {
-                    if(UserConfigParams::logAddons())
-                        Log::warn("addons", "Removing cached icon '%s'.",
-                               addon.getIconBasename().c_str());
-                    file_manager->removeFile(full_path);
-                }
-                continue;
-            }
+            if(UserConfigParams::logAddons())
+                Log::warn("addons", "Removing cached icon '%s'.",
+                       addon.getIconBasename().c_str());
+            file_manager->removeFile(full_path);
+        }
+        return;
+    }
 
-            m_addons_list.lock();
-            if(index>=0)
-            {
-                Addon& tmplist_addon = m_addons_list.getData()[index];
+    if(index>=0)
+    {
+        Addon& tmplist_addon = (*list)[index];
 
-                // Only copy the data if a newer revision is found (ignore unapproved
-                // revisions unless player is in the mode to see them)
-                if (tmplist_addon.getRevision() < addon.getRevision() &&
-                    (addon.testStatus(Addon::AS_APPROVED) || UserConfigParams::m_artist_debug_mode))
-                {
-                    m_addons_list.getData()[index].copyInstallData(addon);
-                }
-            }
-            else
-            {
-                m_addons_list.getData().push_back(addon);
-                index = (int) m_addons_list.getData().size()-1;
-            }
-            // Mark that this addon still exists on the server
-            m_addons_list.getData()[index].setStillExists();
-            m_addons_list.unlock();
-        }
-        else
+        // Only copy the data if a newer revision is found (ignore unapproved
+        // revisions unless player is in the mode to see them)
+        if (tmplist_addon.getRevision() < addon.getRevision() &&
+            (addon.testStatus(Addon::AS_APPROVED) || UserConfigParams::m_artist_debug_mode))
         {
-            Log::error("addons", "Found invalid node '%s' while downloading addons.",
-                    node->getName().c_str());
-            Log::error("addons", "Ignored.");
+            tmplist_addon.copyInstallData(addon);
         }
-    }   // for i<xml->getNumNodes
-    delete xml;
+    }
+    else
+    {
+        list->push_back(addon);
+        index = (int) list->size()-1;
+    }
+    // Mark that this addon still exists on the server
+    (*list)[index].setStillExists();
+}   // addAddon
+
+// ----------------------------------------------------------------------------
+/** This initialises the online portion of the addons manager. It uses the
+ *  downloaded list of available addons. It is called from init(), which is
+ *  called from a separate thread, so blocking download requests can be used
+ *  without blocking the GUI. This function will update the state variable.
+ *  The file is streamed, so each addon is added as soon as it is read
+ *  instead of building the xml tree of all available addons first.
+ *  \param filename Name of the addons.xml file with information about all
+ *         available addons.
+ *  \throw runtime_error if the file is not found.
+ */
+void AddonsManager::initAddons(const std::string &filename)
+{
+    // Build the new list separately, so the current list is kept if
+    // parsing the file throws an exception
+    std::vector<Addon> list;
+    loadInstalledAddons(&list);
+
+    XMLNode xml(filename, /*stream_depth*/1,
+                [this, &list](const XMLNode &node) { addAddon(node, &list); });
 
     // Now remove all items from the addons-installed list, that are not
     // on the server anymore (i.e. not in the addons.xml file), and not
@@ -259,13 +259,11 @@ void AddonsManager::initAddons(const XMLNode *xml)
     // Note that if (due to a bug) an icon is shared (i.e. same icon on
     // an addon that's still on the server and an invalid entry in the
     // addons installed file), it will be re-downloaded later.
-    m_addons_list.lock();
-    unsigned int count = (unsigned int) m_addons_list.getData().size();
+    unsigned int count = (unsigned int) list.size();
 
     for(unsigned int i=0; i<count;)
     {
-        if(m_addons_list.getData()[i].getStillExists() ||
-            m_addons_list.getData()[i].isInstalled())
+        if(list[i].getStillExists() || list[i].isInstalled())
         {
             i++;
             continue;
@@ -275,18 +273,20 @@ void AddonsManager::initAddons(const XMLNode *xml)
         if(UserConfigParams::logAddons())
             Log::warn(
                 "addons", "Removing '%s' which is not on the server anymore.",
-                m_addons_list.getData()[i].getId().c_str() );
-        const std::string &icon = m_addons_list.getData()[i].getIconBasename();
+                list[i].getId().c_str() );
+        const std::string &icon = list[i].getIconBasename();
         std::string icon_file =file_manager->getAddonsFile("icons/"+icon);
         if(file_manager->fileExists(icon_file))
         {
             file_manager->removeFile(icon_file);
             // Ignore errors silently.
         }
-        m_addons_list.getData()[i] = m_addons_list.getData()[count-1];
-        m_addons_list.getData().pop_back();
+        list[i] = list[count-1];
+        list.pop_back();
         count--;
     }
+    m_addons_list.lock();
+    m_addons_list.getData().swap(list);
     m_addons_list.unlock();
 
     m_state.setAtomic(STATE_READY);
@@ -414,8 +414,9 @@ void AddonsManager::downloadIcons()
 
 // ----------------------------------------------------------------------------
 /** Loads the installed addons from .../addons/addons_installed.xml.
+ *  \param list The list to add the installed addons to.
  */
-void AddonsManager::loadInstalledAddons()
+void AddonsManager::loadInstalledAddons(std::vector<Addon> *list)
 {
     /* checking for installed addons */
     if(UserConfigParams::logAddons())
@@ -434,7 +435,7 @@ void AddonsManager::loadInstalledAddons()
             node->getName()=="track"    )
         {
             Addon addon(*node);
-            m_addons_list.getData().push_back(addon);
+            list->push_back(addon);
         }
     }   // for i <= xml->getNumNodes()
 
@@ -459,15 +460,27 @@ const Addon* AddonsManager::getAddon(const std::string &id) const
  */
 int AddonsManager::getAddonIndex(const std::string &id) const
 {
-    for(unsigned int i = 0; i < m_addons_list.getData().size(); i++)
+    return findAddon(m_addons_list.getData(), id);
+}   // getAddonIndex
+
+// ----------------------------------------------------------------------------
+/** Returns the index of the addon with the given id in a list of addons, or
+ *  -1 if no such addon exist.
+ *  \param list The list of addons to search.
+ *  \param id The (unique) identifier of the addon.
+ */
+int AddonsManager::findAddon(const std::vector<Addon> &list,
+                             const std::string &id)
+{
+    for(unsigned int i = 0; i < list.size(); i++)
     {
-        if(m_addons_list.getData()[i].getId()== id)
+        if(list[i].getId()== id)
         {
             return i;
         }
     }
     return -1;
-}   // getAddonIndex
+}   // findAddon
 // ----------------------------------------------------------------------------
 bool AddonsManager::anyAddonsInstalled() const
 {
@@ -54,14 +54,17 @@ private:
     Synchronised<STATE_TYPE> m_state;
 
     void  saveInstalled();
-    void  loadInstalledAddons();
+    void  loadInstalledAddons(std::vector<Addon> *list);
+    void  addAddon(const XMLNode &node, std::vector<Addon> *list);
+    static int findAddon(const std::vector<Addon> &list,
+                         const std::string &id);
     void  downloadIcons();
 
 public:
                  AddonsManager();
                 ~AddonsManager();
     void         init(const XMLNode *xml, bool force_refresh);
-    void         initAddons(const XMLNode *xml);
+    void         initAddons(const std::string &filename);
     void         checkInstalledAddons();
     const Addon* getAddon(const std::string &id) const;
     int          getAddonIndex(const std::string &id) const;
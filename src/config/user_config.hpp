@@ -945,6 +945,14 @@ namespace UserConfigParams
                                                "wasn't asked, 1: allowed, 2: "
                                                "not allowed") );
 
+    PARAM_PREFIX IntUserConfigParam        m_max_http_requests
+            PARAM_DEFAULT(  IntUserConfigParam(4, "max_http_requests",
+                                               "Maximum number of http "
+                                               "requests (e.g. downloads) "
+                                               "running at the same time, "
+                                               "requests with high priority "
+                                               "can use one more.") );
+
     PARAM_PREFIX GroupUserConfigParam       m_hw_report_group
             PARAM_DEFAULT( GroupUserConfigParam("HWReport",
                                           "Everything related to hardware configuration.") );
@@ -1019,6 +1027,14 @@ namespace UserConfigParams
                         "Enable all karts and tracks: 0 = disabled, "
                         "1 = everything except final race, 2 = everything") );
 
+    PARAM_PREFIX IntUserConfigParam        m_ai_threads
+            PARAM_DEFAULT( IntUserConfigParam(0, "ai_threads",
+                        "Number of extra threads used to compute the "
+                        "decisions of the AI karts in parallel in local "
+                        "races, 0 to disable. Any other value changes the "
+                        "order in which karts are updated, so AI karts can "
+                        "behave differently.") );
+
     PARAM_PREFIX StringUserConfigParam      m_commandline
             PARAM_DEFAULT( StringUserConfigParam("", "commandline",
                              "Allows to set commandline args in config file") );
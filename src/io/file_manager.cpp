@@ -247,6 +247,7 @@ FileManager::FileManager()
     checkAndCreateScreenshotDir();
     checkAndCreateReplayDir();
     checkAndCreateCachedTexturesDir();
+    checkAndCreateCachedNavmeshDir();
     checkAndCreateGPDir();
 
     redirectOutput();
@@ -475,8 +476,14 @@ XMLNode *FileManager::createXMLTree(const std::string &filename)
 //-----------------------------------------------------------------------------
 /** Reads in XML from a string and converts it into a XMLNode tree.
  *  \param content the string containing the XML content.
+ *  \param stream_depth Depth of the elements which are passed to
+ *         node_function one at a time instead of being added to the tree,
+ *         0 to read the full tree.
+ *  \param node_function Called for each streamed element.
  */
-XMLNode *FileManager::createXMLTreeFromString(const std::string & content)
+XMLNode *FileManager::createXMLTreeFromString(const std::string & content,
+                                  unsigned stream_depth,
+                                  const XMLNode::NodeFunction &node_function)
 {
     try
     {
@@ -487,7 +494,7 @@ XMLNode *FileManager::createXMLTreeFromString(const std::string & content)
             m_file_system->createMemoryReadFile(b, (int)content.size(),
                                                 "tempfile", true);
         io::IXMLReader * reader = m_file_system->createXMLReader(ireadfile);
-        XMLNode* node = new XMLNode(reader);
+        XMLNode* node = new XMLNode(reader, stream_depth, node_function);
         reader->drop();
         ireadfile->drop();
         return node;
@@ -724,6 +731,15 @@ std::string FileManager::getCachedTexturesDir() const
     return m_cached_textures_dir;
 }   // getCachedTexturesDir
 
+//-----------------------------------------------------------------------------
+/** Returns the directory in which the shortest paths of arena navmeshes
+ *  should be cached.
+ */
+std::string FileManager::getCachedNavmeshDir() const
+{
+    return m_cached_navmesh_dir;
+}   // getCachedNavmeshDir
+
 //-----------------------------------------------------------------------------
 /** Returns the directory in which user-defined grand prix should be stored.
  */
@@ -1062,6 +1078,31 @@ void FileManager::checkAndCreateCachedTexturesDir()
 
 }   // checkAndCreateCachedTexturesDir
 
+// ----------------------------------------------------------------------------
+/** Creates the directory for the cached shortest paths of arena navmeshes.
+ *  This will set m_cached_navmesh_dir with the appropriate path.
+ */
+void FileManager::checkAndCreateCachedNavmeshDir()
+{
+#if defined(WIN32) || defined(__CYGWIN__)
+    m_cached_navmesh_dir = m_user_config_dir + "cached-navmesh/";
+#elif defined(__APPLE__)
+    m_cached_navmesh_dir = getenv("HOME");
+    m_cached_navmesh_dir += "/Library/Application Support/SuperTuxKart/CachedNavmesh/";
+#else
+    m_cached_navmesh_dir = checkAndCreateLinuxDir("XDG_CACHE_HOME", "supertuxkart", ".cache/", ".");
+    m_cached_navmesh_dir += "cached-navmesh/";
+#endif
+
+    if (!checkAndCreateDirectory(m_cached_navmesh_dir))
+    {
+        Log::error("FileManager", "Can not create cached navmesh directory '%s', "
+            "falling back to '.'.", m_cached_navmesh_dir.c_str());
+        m_cached_navmesh_dir = "./";
+    }
+
+}   // checkAndCreateCachedNavmeshDir
+
 // ----------------------------------------------------------------------------
 /** Creates the directories for user-defined grand prix. This will set m_gp_dir
  *  with the appropriate path.
@@ -1484,3 +1525,13 @@ bool FileManager::fileIsNewer(const std::string& f1, const std::string& f2) cons
     stat(f2.c_str(), &stat2);
     return stat1.st_mtime > stat2.st_mtime;
 }   // fileIsNewer
+
+// ----------------------------------------------------------------------------
+/** Returns the modification time of a file, or 0 if the file doesn't exist.
+ */
+uint64_t FileManager::getFileModificationTime(const std::string& path) const
+{
+    struct stat mystat;
+    if (stat(path.c_str(), &mystat) < 0) return 0;
+    return (uint64_t)mystat.st_mtime;
+}   // getFileModificationTime
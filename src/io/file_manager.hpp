@@ -25,6 +25,7 @@
  * Contains generic utility classes for file I/O (especially XML handling).
  */
 
+#include <cstdint>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -99,6 +100,9 @@ private:
     /** Directory where resized textures are cached. */
     std::string       m_cached_textures_dir;
 
+    /** Directory where the shortest paths of arena navmeshes are cached. */
+    std::string       m_cached_navmesh_dir;
+
     /** Directory where user-defined grand prix are stored. */
     std::string       m_gp_dir;
 
@@ -126,6 +130,7 @@ private:
     void              checkAndCreateScreenshotDir();
     void              checkAndCreateReplayDir();
     void              checkAndCreateCachedTexturesDir();
+    void              checkAndCreateCachedNavmeshDir();
     void              checkAndCreateGPDir();
     void              discoverPaths();
 #if !defined(WIN32) && !defined(__CYGWIN__) && !defined(__APPLE__)
@@ -144,11 +149,15 @@ public:
     static void       setStdoutDir(const std::string &dir);
     io::IXMLReader   *createXMLReader(const std::string &filename);
     XMLNode          *createXMLTree(const std::string &filename);
-    XMLNode          *createXMLTreeFromString(const std::string & content);
+    XMLNode          *createXMLTreeFromString(const std::string & content,
+                                unsigned stream_depth = 0,
+                                const XMLNode::NodeFunction &node_function
+                                                                  = nullptr);
 
     std::string       getScreenshotDir() const;
     std::string       getReplayDir() const;
     std::string       getCachedTexturesDir() const;
+    std::string       getCachedNavmeshDir() const;
     std::string       getGPDir() const;
     bool              checkAndCreateDirectory(const std::string &path);
     bool              checkAndCreateDirectoryP(const std::string &path);
@@ -204,6 +213,7 @@ public:
     void       redirectOutput();
 
     bool       fileIsNewer(const std::string& f1, const std::string& f2) const;
+    uint64_t   getFileModificationTime(const std::string& path) const;
     // ------------------------------------------------------------------------
     const std::string& getUserConfigDir() const   { return m_user_config_dir; }
     // ------------------------------------------------------------------------
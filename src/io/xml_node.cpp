@@ -23,19 +23,37 @@
 
 #include <stdexcept>
 
-XMLNode::XMLNode(io::IXMLReader *xml)
+// ----------------------------------------------------------------------------
+/** Reads the next element from a XML reader and converts it into a XMLNode
+ *  tree. If stream_depth is not 0, the elements at that depth below this
+ *  node are not added to the tree: each of them is passed to node_function
+ *  as soon as it is read completely and deleted afterwards. This way only
+ *  one of them exists at any time when reading long lists (e.g. servers or
+ *  addons), and the caller can use each entry before the rest of the data
+ *  is parsed.
+ *  \param xml The XML reader.
+ *  \param stream_depth Depth of the elements to stream, 1 are the children
+ *         of this node, 0 reads the full tree.
+ *  \param node_function Called for each streamed element.
+ */
+XMLNode::XMLNode(io::IXMLReader *xml, unsigned stream_depth,
+                 const NodeFunction &node_function)
 {
     m_file_name = "[unknown]";
 
     while(xml->getNodeType()!=io::EXN_ELEMENT && xml->read());
-    readXML(xml);
+    readXML(xml, stream_depth, node_function);
 }   // XMLNode
 
 // ----------------------------------------------------------------------------
 /** Reads a XML file and convert it into a XMLNode tree.
  *  \param filename Name of the XML file to read.
+ *  \param stream_depth Depth of the elements to stream instead of adding
+ *         them to the tree, see XMLNode(io::IXMLReader*, ...).
+ *  \param node_function Called for each streamed element.
  */
-XMLNode::XMLNode(const std::string &filename)
+XMLNode::XMLNode(const std::string &filename, unsigned stream_depth,
+                 const NodeFunction &node_function)
 {
     m_file_name = filename;
 
@@ -59,7 +77,7 @@ XMLNode::XMLNode(const std::string &filename)
                                 "More than one root element in '%s' - ignored.",
                             filename.c_str());
                 }
-                readXML(xml);
+                readXML(xml, stream_depth, node_function);
                 is_first_element = false;
                 break;
             }
@@ -87,8 +105,12 @@ XMLNode::~XMLNode()
 // ----------------------------------------------------------------------------
 /** Stores all attributes, and reads in all children.
  *  \param xml The XML reader.
+ *  \param stream_depth Depth of the elements to pass to node_function
+ *         instead of adding them to the tree, 0 to read the full tree.
+ *  \param node_function Called for each streamed element.
  */
-void XMLNode::readXML(io::IXMLReader *xml)
+void XMLNode::readXML(io::IXMLReader *xml, unsigned stream_depth,
+                      const NodeFunction &node_function)
 {
     m_name = std::string(core::stringc(xml->getNodeName()).c_str());
 
@@ -110,7 +132,15 @@ void XMLNode::readXML(io::IXMLReader *xml)
         {
         case io::EXN_ELEMENT:
             {
-                XMLNode* n = new XMLNode(xml);
+                if (stream_depth == 1)
+                {
+                    XMLNode n(xml);
+                    n.m_file_name = m_file_name;
+                    node_function(n);
+                    break;
+                }
+                XMLNode* n = new XMLNode(xml, stream_depth > 1 ?
+                                         stream_depth - 1 : 0, node_function);
                 n->m_file_name = m_file_name;
                 m_nodes.push_back(n);
                 break;
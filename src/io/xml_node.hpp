@@ -19,6 +19,7 @@
 #ifndef HEADER_XML_NODE_HPP
 #define HEADER_XML_NODE_HPP
 
+#include <functional>
 #include <string>
 #include <map>
 #include <vector>
@@ -47,6 +48,11 @@ class Vec3;
   */
 class XMLNode : public NoCopy
 {
+public:
+    /** Called for each element found at the streaming depth, see
+     *  XMLNode(io::IXMLReader*, unsigned, const NodeFunction&). */
+    typedef std::function<void(const XMLNode &node)> NodeFunction;
+
 private:
     /** Name of this element. */
     std::string                          m_name;
@@ -55,16 +61,19 @@ private:
     /** List of all sub nodes. */
     std::vector<XMLNode *>               m_nodes;
 
-    void readXML(io::IXMLReader *xml);
+    void readXML(io::IXMLReader *xml, unsigned stream_depth,
+                 const NodeFunction &node_function);
 
     std::string                          m_file_name;
 
 public:
          LEAK_CHECK();
-         XMLNode(io::IXMLReader *xml);
+         XMLNode(io::IXMLReader *xml, unsigned stream_depth = 0,
+                 const NodeFunction &node_function = nullptr);
 
          /** \throw runtime_error if the file is not found */
-         XMLNode(const std::string &filename);
+         XMLNode(const std::string &filename, unsigned stream_depth = 0,
+                 const NodeFunction &node_function = nullptr);
 
         ~XMLNode();
 
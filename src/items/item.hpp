@@ -407,6 +407,11 @@ public:
     /** Returns the index of the graph node this item is on. */
     virtual int getGraphNode() const OVERRIDE { return m_graph_node; }
     // ------------------------------------------------------------------------
+    /** Returns the distance from this item beyond which hitKart is always
+     *  false. The vertical distance is halved in hitKart, so this is twice
+     *  the collection radius. */
+    float getMaxHitDistance() const        { return 2.0f*sqrtf(m_distance_2); }
+    // ------------------------------------------------------------------------
     /** Returns the distance from center: negative means left of center,
      *  positive means right of center. */
     virtual float getDistanceFromCenter() const OVERRIDE
@@ -38,11 +38,21 @@
 #include <IMesh.h>
 #include <IAnimatedMesh.h>
 
+#include <algorithm>
 #include <assert.h>
+#include <cmath>
 #include <stdexcept>
 #include <sstream>
 #include <string>
 
+namespace
+{
+    /** Size of a cell of ItemManager::m_items_in_grid. It is larger than the
+     *  distance at which an item can be hit, so a kart needs to test at most
+     *  2x2 cells. */
+    const float GRID_CELL_SIZE = 5.0f;
+}   // namespace
+
 
 std::vector<scene::IMesh *>  ItemManager::m_item_mesh;
 std::vector<scene::IMesh *>  ItemManager::m_item_lowres_mesh;
@@ -169,6 +179,7 @@ ItemManager::ItemManager()
     for(unsigned int i=ItemState::ITEM_FIRST; i<ItemState::ITEM_COUNT; i++)
         m_switch_to.push_back((ItemState::ItemType)i);
     setSwitchItems(stk_config->m_switch_items);
+    m_max_hit_distance = 0.0f;
 
     if(Graph::get())
     {
@@ -242,7 +253,8 @@ unsigned int ItemManager::insertItem(Item *item)
 
 //-----------------------------------------------------------------------------
 /** Insert into the appropriate quad list, if there is a quad list
- *  (i.e. race mode has a quad graph).
+ *  (i.e. race mode has a quad graph), and into the grid used for item
+ *  collection.
  */
 void ItemManager::insertItemInQuad(Item *item)
 {
@@ -253,10 +265,18 @@ void ItemManager::insertItemInQuad(Item *item)
         if(graph_node > -1)
         {
             (*m_items_in_quads)[graph_node].push_back(item);
+            m_quads_with_items.insert(graph_node);
         }
         else  // otherwise store it in the 'outside' index
             (*m_items_in_quads)[m_items_in_quads->size()-1].push_back(item);
     }   // if m_items_in_quads
+
+    const Vec3 &xyz = item->getXYZ();
+    int x = (int)floorf(xyz.getX() / GRID_CELL_SIZE);
+    int z = (int)floorf(xyz.getZ() / GRID_CELL_SIZE);
+    m_items_in_grid[getGridCell(x, z)].push_back(item);
+    m_max_hit_distance = std::max(m_max_hit_distance,
+                                  item->getMaxHitDistance());
 }   // insertItemInQuad
 
 //-----------------------------------------------------------------------------
@@ -375,14 +395,11 @@ void ItemManager::collectedItem(ItemState *item, AbstractKart *kart)
  */
 void  ItemManager::checkItemHit(AbstractKart* kart)
 {
-    // We could use m_items_in_quads to to check for item hits: take the quad
-    // of the graph node of the kart, and only check items in that quad. But
-    // then we also need to check for any adjacent quads (since an item just
-    // on the order of one quad might get hit from an adjacent quad). Then
-    // it is possible that a quad is that short that we need to test adjacent
-    // of adjacent quads. And check for items outside of the track.
-    // Since at this stace item detection is by far not a bottle neck,
-    // the original, simple and stable algorithm is left in place.
+    // Using m_items_in_quads would require to also check adjacent quads
+    // (and adjacent of adjacent quads for short quads), and items outside
+    // of the track. Instead all items are stored in a uniform grid, and
+    // only the cells which can contain an item close enough to the kart
+    // are tested.
 
     /** Disable item collection detection for debug purposes. */
     if(m_disable_item_collection) return;
@@ -390,8 +407,35 @@ void  ItemManager::checkItemHit(AbstractKart* kart)
     // Spare tire karts don't collect items
     if ( dynamic_cast<SpareTireAI*>(kart->getController()) ) return;
 
-    for(AllItemTypes::iterator i =m_all_items.begin();
-                               i!=m_all_items.end();  i++)
+    const Vec3 &xyz = kart->getXYZ();
+    int min_x = (int)floorf((xyz.getX() - m_max_hit_distance)/GRID_CELL_SIZE);
+    int max_x = (int)floorf((xyz.getX() + m_max_hit_distance)/GRID_CELL_SIZE);
+    int min_z = (int)floorf((xyz.getZ() - m_max_hit_distance)/GRID_CELL_SIZE);
+    int max_z = (int)floorf((xyz.getZ() + m_max_hit_distance)/GRID_CELL_SIZE);
+    AllItemTypes candidates;
+    for (int x = min_x; x <= max_x; x++)
+    {
+        for (int z = min_z; z <= max_z; z++)
+        {
+            auto cell = m_items_in_grid.find(getGridCell(x, z));
+            if (cell != m_items_in_grid.end())
+            {
+                candidates.insert(candidates.end(), cell->second.begin(),
+                                  cell->second.end());
+            }
+        }
+    }
+    // Collect items in the same order as they are stored in m_all_items,
+    // which keeps the result identical on server and clients if a kart
+    // hits more than one item at the same time.
+    std::sort(candidates.begin(), candidates.end(),
+              [](const ItemState *a, const ItemState *b)
+              {
+                  return a->getItemId() < b->getItemId();
+              });
+
+    for(AllItemTypes::iterator i =candidates.begin();
+                               i!=candidates.end();  i++)
     {
         // Ignore items that have been collected or are not available atm
         if ((!*i) || !(*i)->isAvailable() || (*i)->isUsedUp()) continue;
@@ -411,7 +455,7 @@ void  ItemManager::checkItemHit(AbstractKart* kart)
         {
             collectedItem(*i, kart);
         }   // if hit
-    }   // for m_all_items
+    }   // for candidates
 }   // checkItemHit
 
 //-----------------------------------------------------------------------------
@@ -522,7 +566,7 @@ void ItemManager::deleteItem(ItemState *item)
 }   // delete item
 
 //-----------------------------------------------------------------------------
-/** Removes an items from the items-in-quad list only
+/** Removes an items from the items-in-quad list and the grid only
  *  \param The item to delete.
  */
 void ItemManager::deleteItemInQuad(ItemState* item)
@@ -537,7 +581,21 @@ void ItemManager::deleteItemInQuad(ItemState* item)
         AllItemTypes::iterator it = std::find(items.begin(), items.end(),item);
         assert(it!=items.end());
         items.erase(it);
+        if (items.empty())
+            m_quads_with_items.erase(indx);
     }   // if m_items_in_quads
+
+    const Vec3 &xyz = item->getXYZ();
+    int x = (int)floorf(xyz.getX() / GRID_CELL_SIZE);
+    int z = (int)floorf(xyz.getZ() / GRID_CELL_SIZE);
+    auto cell = m_items_in_grid.find(getGridCell(x, z));
+    assert(cell != m_items_in_grid.end());
+    AllItemTypes::iterator it = std::find(cell->second.begin(),
+                                          cell->second.end(), item);
+    assert(it != cell->second.end());
+    cell->second.erase(it);
+    if (cell->second.empty())
+        m_items_in_grid.erase(cell);
 }   // deleteItemInQuad
 
 //-----------------------------------------------------------------------------
@@ -29,10 +29,13 @@
 #include <SColor.h>
 
 #include <assert.h>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <random>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Kart;
@@ -110,6 +113,19 @@ private:
      *  field is undefined if no Graph exist, e.g. arena without navmesh. */
     std::vector< AllItemTypes > *m_items_in_quads;
 
+    /** The indices of all quads in m_items_in_quads which contain at least
+     *  one item (not including the 'outside' entry). */
+    std::set<unsigned int> m_quads_with_items;
+
+    /** All items sorted into a uniform grid in the x/z plane, so that
+     *  checkItemHit only needs to test the items close to a kart. The key
+     *  is computed by getGridCell. */
+    std::unordered_map<uint64_t, AllItemTypes> m_items_in_grid;
+
+    /** The largest distance at which any item in m_items_in_grid can be
+     *  hit, which determines the grid cells to test for a kart. */
+    float m_max_hit_distance;
+
     /** Stores all item models. */
     static std::vector<scene::IMesh *> m_item_mesh;
 
@@ -127,6 +143,13 @@ protected:
     void setSwitchItems(const std::vector<int> &switch_items);
     void insertItemInQuad(Item *item);
     void deleteItemInQuad(ItemState *item);
+    // ------------------------------------------------------------------------
+    /** Returns the key in m_items_in_grid of the given grid coordinates. */
+    static uint64_t getGridCell(int x, int z)
+    {
+        return ((uint64_t)(uint32_t)x << 32) | (uint32_t)z;
+    }   // getGridCell
+    // ------------------------------------------------------------------------
              ItemManager();
 public:
     virtual ~ItemManager();
@@ -193,6 +216,13 @@ public:
               ? NULL 
              : dynamic_cast<Item*>((*m_items_in_quads)[n].front());
     }   // getFirstItemInQuad
+    // ------------------------------------------------------------------------
+    /** Returns the indices of all quads which contain at least one item, in
+     *  increasing order. */
+    const std::set<unsigned int>& getQuadsWithItems() const
+    {
+        return m_quads_with_items;
+    }   // getQuadsWithItems
 };   // ItemManager
 
 #endif
@@ -488,7 +488,16 @@ void NetworkItemManager::restoreState(BareNetworkString *buffer, int count)
         // ... will be copied from item state to item
         if (is && item)
         {
-            *(ItemState*)item = *is;
+            // The grid of items is sorted by position, so an item that
+            // moved needs to be inserted again
+            if (item->getXYZ() != is->getXYZ())
+            {
+                deleteItemInQuad(item);
+                *(ItemState*)item = *is;
+                insertItemInQuad(static_cast<Item*>(item));
+            }
+            else
+                *(ItemState*)item = *is;
         }
         else if (is && !item)
         {
@@ -249,6 +249,14 @@ public:
     /** Returns the controller of this kart (const version). */
     virtual const Controller* getController() const = 0;
     // ------------------------------------------------------------------------
+    /** Does the part of update() before the controller is updated. Together
+     *  with updateAfterController() this allows to update the controllers
+     *  of several karts at the same time. */
+    virtual void updateBeforeController(int ticks) = 0;
+    // ------------------------------------------------------------------------
+    /** Does the part of update() after the controller is updated. */
+    virtual void updateAfterController(int ticks) = 0;
+    // ------------------------------------------------------------------------
     /** Returns the skidding object for this kart (which can be used to query
      *  skidding related values). */
     virtual const Skidding *getSkidding() const = 0;
@@ -42,6 +42,7 @@ AIBaseController::AIBaseController(AbstractKart *kart)
     m_kart_width    = m_kart->getKartWidth();
     m_ai_properties = m_kart->getKartProperties()
                             ->getAIPropertiesForDifficulty();
+    m_saved_stuck = false;
 }   // AIBaseController
 
 //-----------------------------------------------------------------------------
@@ -51,6 +52,7 @@ void AIBaseController::reset()
     m_enabled_network_ai = false;
     m_stuck = false;
     m_collision_ticks.clear();
+    m_decided_controls.reset();
 }   // reset
 
 //-----------------------------------------------------------------------------
@@ -60,6 +62,68 @@ void AIBaseController::update(int ticks)
     m_stuck = false;
 }
 
+//-----------------------------------------------------------------------------
+/** Called by computeDecisions() of a derived class before the decisions are
+ *  computed: m_controls points to a copy of the kart controls until
+ *  endDecisions() is called, so the kart itself is not changed.
+ */
+void AIBaseController::beginDecisions()
+{
+    saveDecisionState();
+    m_controls = m_decided_controls.begin(m_controls);
+}   // beginDecisions
+
+//-----------------------------------------------------------------------------
+/** Restores the kart controls after the decisions were computed.
+ */
+void AIBaseController::endDecisions()
+{
+    m_controls = m_decided_controls.end();
+}   // endDecisions
+
+//-----------------------------------------------------------------------------
+/** Copies the controls computed in computeDecisions() to the kart. This is
+ *  called at the start of update() by the derived classes.
+ *  \return False if no decisions were computed for this time step, or if a
+ *          kart animation was started by an earlier kart after they were
+ *          computed. update() must then do all work itself.
+ */
+bool AIBaseController::applyDecisions()
+{
+    switch (m_decided_controls.apply(m_controls,
+                                     m_kart->getKartAnimation() != NULL))
+    {
+    case DecidedControls::DC_APPLIED:
+        return true;
+    case DecidedControls::DC_DISCARDED:
+        // Undo all changes of computing the discarded decisions, so the AI
+        // continues as if they were never computed. The kart controls were
+        // not changed, see DecidedControls::unitTesting().
+        restoreDecisionState();
+        return false;
+    default:
+        return false;
+    }
+}   // applyDecisions
+
+//-----------------------------------------------------------------------------
+/** Saves the data of this AI which can be changed when computing the
+ *  decisions, so that restoreDecisionState() can undo the changes if the
+ *  decisions are discarded. Derived classes with such data must extend it.
+ */
+void AIBaseController::saveDecisionState()
+{
+    m_saved_stuck = m_stuck;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+/** Restores the data saved with saveDecisionState().
+ */
+void AIBaseController::restoreDecisionState()
+{
+    m_stuck = m_saved_stuck;
+}   // restoreDecisionState
+
 //-----------------------------------------------------------------------------
 /** In debug mode when the user specified --ai-debug on the command line set
  *  the name of the controller as on-screen text, so that the different AI
@@ -20,6 +20,8 @@
 #define HEADER_AI_BASE_CONTROLLER_HPP
 
 #include "karts/controller/controller.hpp"
+#include "karts/controller/decided_controls.hpp"
+#include "karts/controller/kart_control.hpp"
 #include "utils/cpp2011.hpp"
 
 class AIProperties;
@@ -42,6 +44,13 @@ private:
     *  this kart is stuck and needs to be rescued. */
     bool m_stuck;
 
+    /** The controls computed in computeDecisions(), which are copied to the
+     *  kart in applyDecisions(). */
+    DecidedControls m_decided_controls;
+
+    /** m_stuck before the decisions were computed. */
+    bool m_saved_stuck;
+
 protected:
     bool m_enabled_network_ai;
 
@@ -80,6 +89,16 @@ protected:
     // ------------------------------------------------------------------------
     /** Return true if AI can skid now. */
     virtual bool canSkid(float steer_fraction) = 0;
+    // ------------------------------------------------------------------------
+    void         beginDecisions();
+    void         endDecisions();
+    bool         applyDecisions();
+    virtual void saveDecisionState();
+    virtual void restoreDecisionState();
+    // ------------------------------------------------------------------------
+    /** Returns if the decisions for the next update() were computed. */
+    bool         areDecisionsComputed() const
+                                    { return m_decided_controls.isComputed(); }
 
 public:
              AIBaseController(AbstractKart *kart);
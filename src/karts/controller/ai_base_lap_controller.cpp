@@ -86,6 +86,7 @@ in all AIs, e.g.:
 AIBaseLapController::AIBaseLapController(AbstractKart *kart)
                    : AIBaseController(kart)
 {
+    m_saved_track_node = Graph::UNKNOWN_SECTOR;
 
     if (!race_manager->isBattleMode() &&
         race_manager->getMinorMode()!=RaceManager::MINOR_MODE_SOCCER)
@@ -115,6 +116,20 @@ void AIBaseLapController::reset()
     AIBaseController::reset();
 }   // reset
 
+//-----------------------------------------------------------------------------
+void AIBaseLapController::saveDecisionState()
+{
+    AIBaseController::saveDecisionState();
+    m_saved_track_node = m_track_node;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+void AIBaseLapController::restoreDecisionState()
+{
+    AIBaseController::restoreDecisionState();
+    m_track_node = m_saved_track_node;
+}   // restoreDecisionState
+
 
 
 //-----------------------------------------------------------------------------
@@ -38,6 +38,9 @@ protected:
      *  chosen by the AI). */
     int   m_track_node;
 
+    /** m_track_node before the decisions were computed. */
+    int   m_saved_track_node;
+
     /** Keep a pointer to world. */
     LinearWorld *m_world;
 
@@ -54,6 +57,8 @@ protected:
     std::vector<std::vector<int> > m_all_look_aheads;
 
     virtual void update(int ticks);
+    virtual void saveDecisionState();
+    virtual void restoreDecisionState();
     virtual unsigned int getNextSector(unsigned int index);
     virtual void  newLap(int lap);
     //virtual void setControllerName(const std::string &name);
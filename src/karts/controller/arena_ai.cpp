@@ -77,6 +77,11 @@ void ArenaAI::reset()
  */
 void ArenaAI::update(int ticks)
 {
+    // The decisions might have been computed already in parallel with the
+    // other AI karts, see World::update()
+    if (applyDecisions())
+        return;
+
     if (!m_graph)
         return;
 
@@ -96,14 +101,7 @@ void ArenaAI::update(int ticks)
         return;
     }
 
-    if (!isKartOnRoad() && m_kart->isOnGround())
-    {
-        m_ticks_since_off_road += ticks;
-    }
-    else if (m_ticks_since_off_road != 0)
-    {
-        m_ticks_since_off_road = 0;
-    }
+    m_ticks_since_off_road = getTicksSinceOffRoad(ticks);
 
     // If the kart needs to be rescued, do it now (and nothing else)
     if (m_ticks_since_off_road > stk_config->time2Ticks(5.0f) &&
@@ -120,6 +118,107 @@ void ArenaAI::update(int ticks)
         AIBaseController::update(ticks);
         return;
     }
+    decide(ticks);
+}   // update
+
+//-----------------------------------------------------------------------------
+/** Computes the controls for the next update() while the other AI karts do
+ *  the same in parallel. A kart which is rescued or waiting is handled by
+ *  update() itself.
+ */
+void ArenaAI::computeDecisions(int ticks)
+{
+    if (!m_graph || m_kart->getKartAnimation() || isWaiting())
+        return;
+
+    const int ticks_since_off_road = getTicksSinceOffRoad(ticks);
+    if (ticks_since_off_road > stk_config->time2Ticks(5.0f) &&
+        m_kart->isOnGround())
+        return;
+
+    beginDecisions();
+    m_controls->setLookBack(false);
+    m_controls->setNitro(false);
+    m_controls->setAccel(0.0f);
+    m_controls->setBrake(false);
+    m_mini_skid = false;
+    m_ticks_since_off_road = ticks_since_off_road;
+    decide(ticks);
+    endDecisions();
+}   // computeDecisions
+
+//-----------------------------------------------------------------------------
+/** Saves the data changed by decide(), see
+ *  AIBaseController::saveDecisionState().
+ */
+void ArenaAI::saveDecisionState()
+{
+    AIBaseController::saveDecisionState();
+    m_saved_state.m_closest_kart          = m_closest_kart;
+    m_saved_state.m_closest_kart_node     = m_closest_kart_node;
+    m_saved_state.m_closest_kart_point    = m_closest_kart_point;
+    m_saved_state.m_target_node           = m_target_node;
+    m_saved_state.m_target_point          = m_target_point;
+    m_saved_state.m_mini_skid             = m_mini_skid;
+    m_saved_state.m_target_point_lc       = m_target_point_lc;
+    m_saved_state.m_reverse_point         = m_reverse_point;
+    m_saved_state.m_is_stuck              = m_is_stuck;
+    m_saved_state.m_is_uturn              = m_is_uturn;
+    m_saved_state.m_on_node               = m_on_node;
+    m_saved_state.m_time_since_last_shot  = m_time_since_last_shot;
+    m_saved_state.m_ticks_since_reversing = m_ticks_since_reversing;
+    m_saved_state.m_time_since_driving    = m_time_since_driving;
+    m_saved_state.m_time_since_uturn      = m_time_since_uturn;
+    m_saved_state.m_ticks_since_off_road  = m_ticks_since_off_road;
+    m_saved_state.m_turn_radius           = m_turn_radius;
+    m_saved_state.m_steering_angle        = m_steering_angle;
+    m_saved_state.m_current_forward_point = m_current_forward_point;
+    m_saved_state.m_current_forward_node  = m_current_forward_node;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+void ArenaAI::restoreDecisionState()
+{
+    AIBaseController::restoreDecisionState();
+    m_closest_kart          = m_saved_state.m_closest_kart;
+    m_closest_kart_node     = m_saved_state.m_closest_kart_node;
+    m_closest_kart_point    = m_saved_state.m_closest_kart_point;
+    m_target_node           = m_saved_state.m_target_node;
+    m_target_point          = m_saved_state.m_target_point;
+    m_mini_skid             = m_saved_state.m_mini_skid;
+    m_target_point_lc       = m_saved_state.m_target_point_lc;
+    m_reverse_point         = m_saved_state.m_reverse_point;
+    m_is_stuck              = m_saved_state.m_is_stuck;
+    m_is_uturn              = m_saved_state.m_is_uturn;
+    m_on_node               = m_saved_state.m_on_node;
+    m_time_since_last_shot  = m_saved_state.m_time_since_last_shot;
+    m_ticks_since_reversing = m_saved_state.m_ticks_since_reversing;
+    m_time_since_driving    = m_saved_state.m_time_since_driving;
+    m_time_since_uturn      = m_saved_state.m_time_since_uturn;
+    m_ticks_since_off_road  = m_saved_state.m_ticks_since_off_road;
+    m_turn_radius           = m_saved_state.m_turn_radius;
+    m_steering_angle        = m_saved_state.m_steering_angle;
+    m_current_forward_point = m_saved_state.m_current_forward_point;
+    m_current_forward_node  = m_saved_state.m_current_forward_node;
+}   // restoreDecisionState
+
+//-----------------------------------------------------------------------------
+/** Returns for how many ticks the kart has been driving off road, including
+ *  the current time step.
+ */
+int ArenaAI::getTicksSinceOffRoad(int ticks) const
+{
+    if (!isKartOnRoad() && m_kart->isOnGround())
+        return m_ticks_since_off_road + ticks;
+    return 0;
+}   // getTicksSinceOffRoad
+
+//-----------------------------------------------------------------------------
+/** Determines steering, speed and item usage for this time step. This only
+ *  changes the controls and the data of this AI.
+ */
+void ArenaAI::decide(int ticks)
+{
     float dt = stk_config->ticks2Time(ticks);
     checkIfStuck(dt);
     if (gettingUnstuck(ticks))
@@ -161,7 +260,7 @@ void ArenaAI::update(int ticks)
 
     AIBaseController::update(ticks);
 
-}   // update
+}   // decide
 
 //-----------------------------------------------------------------------------
 /** Update aiming position, use path finding if necessary.
@@ -589,7 +688,8 @@ void ArenaAI::tryCollectItem(Vec3* aim_point, int* target_node) const
         return;
     }
 
-    for (unsigned int i = 0; i < m_graph->getNumNodes(); i++)
+    // Only test the nodes which contain an item
+    for (unsigned int i : ItemManager::get()->getQuadsWithItems())
     {
         Item* cur_item = ItemManager::get()->getFirstItemInQuad(i);
         if (cur_item == NULL) continue;
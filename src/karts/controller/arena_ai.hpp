@@ -80,6 +80,10 @@ protected:
      *  \param consider_difficulty If take current difficulty into account.
      *  \param find_sta If find \ref SpareTireAI only. */
     virtual void  findClosestKart(bool consider_difficulty, bool find_sta) = 0;
+    // ------------------------------------------------------------------------
+    virtual void  saveDecisionState() OVERRIDE;
+    // ------------------------------------------------------------------------
+    virtual void  restoreDecisionState() OVERRIDE;
 
 private:
     /** Local coordinates of current target point. */
@@ -130,12 +134,42 @@ private:
     /** The \ref ArenaNode at which the forward point located on. */
     int m_current_forward_node;
 
+    /** The data changed by decide(), saved by saveDecisionState() before
+     *  the decisions are computed in parallel. */
+    struct DecisionState
+    {
+        AbstractKart  *m_closest_kart;
+        int            m_closest_kart_node;
+        Vec3           m_closest_kart_point;
+        int            m_target_node;
+        Vec3           m_target_point;
+        bool           m_mini_skid;
+        Vec3           m_target_point_lc;
+        Vec3           m_reverse_point;
+        bool           m_is_stuck;
+        bool           m_is_uturn;
+        std::set<int>  m_on_node;
+        float          m_time_since_last_shot;
+        float          m_ticks_since_reversing;
+        float          m_time_since_driving;
+        float          m_time_since_uturn;
+        int            m_ticks_since_off_road;
+        float          m_turn_radius;
+        float          m_steering_angle;
+        Vec3           m_current_forward_point;
+        int            m_current_forward_node;
+    } m_saved_state;
+
     void          configSpeed();
     // ------------------------------------------------------------------------
     void          configSteering();
     // ------------------------------------------------------------------------
     void          checkIfStuck(const float dt);
     // ------------------------------------------------------------------------
+    void          decide(int ticks);
+    // ------------------------------------------------------------------------
+    int           getTicksSinceOffRoad(int ticks) const;
+    // ------------------------------------------------------------------------
     void          determinePath(int forward, std::vector<int>* path);
     // ------------------------------------------------------------------------
     void          doSkiddingTest();
@@ -185,6 +219,10 @@ public:
     // ------------------------------------------------------------------------
     virtual void update(int ticks) OVERRIDE;
     // ------------------------------------------------------------------------
+    virtual void computeDecisions(int ticks) OVERRIDE;
+    // ------------------------------------------------------------------------
+    virtual bool canComputeDecisions() const OVERRIDE { return true; }
+    // ------------------------------------------------------------------------
     virtual void reset() OVERRIDE;
     // ------------------------------------------------------------------------
     virtual void newLap(int lap) OVERRIDE {}
@@ -100,6 +100,16 @@ public:
     /** Called whan this controller's kart finishes the last lap. */
     virtual void  finishedRace(float time) = 0;
     // ------------------------------------------------------------------------
+    /** Returns if this controller can compute the controls for the next
+     *  update() in advance with computeDecisions(). */
+    virtual bool  canComputeDecisions() const { return false; }
+    // ------------------------------------------------------------------------
+    /** Computes the controls for the next call of update(). This is called
+     *  for several karts at the same time from different threads (see
+     *  World::update()), so it must only read the world state and only
+     *  change data of this controller. */
+    virtual void  computeDecisions(int ticks) {}
+    // ------------------------------------------------------------------------
     /** Get a pointer on the kart controls. */
     virtual KartControl* getControls() { return m_controls; }
     // ------------------------------------------------------------------------
@@ -0,0 +1,147 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "karts/controller/decided_controls.hpp"
+
+#include <assert.h>
+#include <cstddef>
+#include <initializer_list>
+
+// ----------------------------------------------------------------------------
+DecidedControls::DecidedControls()
+{
+    m_kart_controls = NULL;
+    m_computed      = false;
+}   // DecidedControls
+
+// ----------------------------------------------------------------------------
+/** Starts computing decisions.
+ *  \param kart_controls The controls of the kart.
+ *  \return The copy of the kart controls the AI must change instead.
+ */
+KartControl* DecidedControls::begin(KartControl *kart_controls)
+{
+    m_decided_controls = *kart_controls;
+    m_kart_controls    = kart_controls;
+    return &m_decided_controls;
+}   // begin
+
+// ----------------------------------------------------------------------------
+/** Finishes computing decisions.
+ *  \return The controls of the kart passed to begin().
+ */
+KartControl* DecidedControls::end()
+{
+    m_computed = true;
+    return m_kart_controls;
+}   // end
+
+// ----------------------------------------------------------------------------
+/** Copies the decided controls to the kart, unless they are discarded.
+ *  \param kart_controls The controls of the kart.
+ *  \param discard True if the decisions must not be used, e.g. because a
+ *         kart animation was started after they were computed.
+ */
+DecidedControls::ApplyResult DecidedControls::apply(KartControl *kart_controls,
+                                                    bool discard)
+{
+    if (!m_computed)
+        return DC_NONE;
+    m_computed = false;
+    if (discard)
+        return DC_DISCARDED;
+    *kart_controls = m_decided_controls;
+    return DC_APPLIED;
+}   // apply
+
+// ----------------------------------------------------------------------------
+/** Tests that computing the decisions in advance gives the same controls
+ *  and AI state as the serial update, both if the decisions are applied and
+ *  if they are discarded because a kart animation started in between. The
+ *  AI is a simplified version of SkiddingAI::update().
+ */
+void DecidedControls::unitTesting()
+{
+    struct TestAI
+    {
+        int m_state, m_saved_state;
+        void decide(KartControl *controls)
+        {
+            m_state++;
+            controls->setSteer(0.1f * (m_state % 10));
+            controls->setAccel(1.0f);
+            controls->setNitro(m_state % 3 == 0);
+            controls->setFire(m_state % 4 == 0);
+        }
+        void update(KartControl *controls, bool animation)
+        {
+            controls->setRescue(false);
+            controls->setLookBack(false);
+            controls->setNitro(false);
+            if (animation)
+                return;
+            decide(controls);
+        }
+    };
+
+    for (int i = 0; i < 20; i++)
+    {
+        for (bool animation : { false, true })
+        {
+            KartControl initial;
+            initial.setSteer(-0.5f);
+            initial.setNitro(true);
+            initial.setLookBack(i % 2 == 0);
+
+            // Serial update, like with 0 AI threads
+            KartControl serial_controls = initial;
+            TestAI serial_ai;
+            serial_ai.m_state = i;
+            serial_ai.update(&serial_controls, animation);
+
+            // Decisions computed in advance before the animation started
+            KartControl kart_controls = initial;
+            TestAI ai;
+            ai.m_state = i;
+            DecidedControls decided;
+            ai.m_saved_state = ai.m_state;
+            KartControl *controls = decided.begin(&kart_controls);
+            controls->setRescue(false);
+            controls->setLookBack(false);
+            controls->setNitro(false);
+            ai.decide(controls);
+            controls = decided.end();
+            assert(controls == &kart_controls);
+            assert(kart_controls == initial);
+            assert(decided.isComputed());
+
+            ApplyResult result = decided.apply(&kart_controls, animation);
+            assert(result == (animation ? DC_DISCARDED : DC_APPLIED));
+            if (result == DC_DISCARDED)
+            {
+                // Undo the AI changes and do the serial update
+                ai.m_state = ai.m_saved_state;
+                ai.update(&kart_controls, animation);
+            }
+            assert(kart_controls == serial_controls);
+            assert(ai.m_state == serial_ai.m_state);
+            assert(!decided.isComputed());
+            assert(decided.apply(&kart_controls, false) == DC_NONE);
+        }
+    }
+}   // unitTesting
@@ -0,0 +1,68 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_DECIDED_CONTROLS_HPP
+#define HEADER_DECIDED_CONTROLS_HPP
+
+#include "karts/controller/kart_control.hpp"
+
+/** The controls an AI computed in advance for its next update, see
+ *  Controller::computeDecisions(). While the decisions are computed, the AI
+ *  changes a copy of the kart controls, so that the kart is not changed if
+ *  the decisions are discarded later.
+ *  \ingroup controller
+ */
+class DecidedControls
+{
+public:
+    /** The result of apply(). */
+    enum ApplyResult
+    {
+        /** No decisions were computed. */
+        DC_NONE,
+        /** The decided controls were copied to the kart. */
+        DC_APPLIED,
+        /** The decisions were discarded, the kart controls are unchanged. */
+        DC_DISCARDED
+    };
+
+private:
+    /** The controls changed while computing the decisions. */
+    KartControl  m_decided_controls;
+
+    /** The controls of the kart while the decisions are computed. */
+    KartControl *m_kart_controls;
+
+    /** True if decisions were computed and not applied yet. */
+    bool         m_computed;
+
+public:
+    DecidedControls();
+    KartControl* begin(KartControl *kart_controls);
+    KartControl* end();
+    ApplyResult  apply(KartControl *kart_controls, bool discard);
+    static void  unitTesting();
+    // ------------------------------------------------------------------------
+    /** Forgets decisions which were computed but not applied. */
+    void         reset()                               { m_computed = false; }
+    // ------------------------------------------------------------------------
+    /** Returns if decisions were computed and not applied yet. */
+    bool         isComputed() const                     { return m_computed; }
+};   // class DecidedControls
+
+#endif
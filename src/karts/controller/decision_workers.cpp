@@ -0,0 +1,181 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "karts/controller/decision_workers.hpp"
+
+#include "karts/controller/controller.hpp"
+#include "utils/vs.hpp"
+
+#include <assert.h>
+#include <functional>
+
+// ----------------------------------------------------------------------------
+/** Starts the worker threads.
+ *  \param num_threads Number of threads besides the calling thread.
+ */
+DecisionWorkers::DecisionWorkers(unsigned num_threads)
+{
+    m_job = NULL;
+    m_job_size = 0;
+    m_next_index.store(0);
+    m_running = 0;
+    m_job_id = 0;
+    m_exit = false;
+    for (unsigned i = 0; i < num_threads; i++)
+        m_threads.emplace_back(std::bind(&DecisionWorkers::mainLoop, this));
+}   // DecisionWorkers
+
+// ----------------------------------------------------------------------------
+DecisionWorkers::~DecisionWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}   // ~DecisionWorkers
+
+// ----------------------------------------------------------------------------
+/** Waits for a new job, and runs the indices of it not taken by other
+ *  threads yet.
+ */
+void DecisionWorkers::mainLoop()
+{
+    VS::setThreadName("DecisionWorkers");
+    uint64_t last_job_id = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            m_start_cv.wait(ul, [this, last_job_id]()
+                {
+                    return m_exit || m_job_id != last_job_id;
+                });
+            if (m_exit)
+                return;
+            last_job_id = m_job_id;
+        }
+        runNextIndices();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running--;
+        }
+        m_done_cv.notify_all();
+    }
+}   // mainLoop
+
+// ----------------------------------------------------------------------------
+/** Runs the indices of the current job which have not been taken by another
+ *  thread, until there are none left.
+ */
+void DecisionWorkers::runNextIndices()
+{
+    for (unsigned i = m_next_index.fetch_add(1); i < m_job_size;
+         i = m_next_index.fetch_add(1))
+    {
+        (*m_job)(i);
+    }
+}   // runNextIndices
+
+// ----------------------------------------------------------------------------
+/** Calls a function for each index using all workers and the calling thread,
+ *  and returns when all are done.
+ *  \param size Number of indices.
+ *  \param job The function to call with each index.
+ */
+void DecisionWorkers::run(unsigned size,
+                          const std::function<void(unsigned)>& job)
+{
+    // Waking up the workers is not worth it for a single index
+    if (m_threads.empty() || size < 2)
+    {
+        for (unsigned i = 0; i < size; i++)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_job_size = size;
+        m_next_index.store(0);
+        m_running = (unsigned)m_threads.size();
+        m_job_id++;
+    }
+    m_start_cv.notify_all();
+    runNextIndices();
+
+    std::unique_lock<std::mutex> ul(m_mutex);
+    m_done_cv.wait(ul, [this]() { return m_running == 0; });
+}   // run
+
+// ----------------------------------------------------------------------------
+/** Calls Controller::computeDecisions() of all given controllers using all
+ *  workers and the calling thread.
+ *  \param controllers The controllers, which must all be different.
+ *  \param ticks Number of physics time steps of the next update.
+ */
+void DecisionWorkers::computeDecisions(
+                              const std::vector<Controller*>& controllers,
+                              int ticks)
+{
+    run((unsigned)controllers.size(), [&controllers, ticks](unsigned i)
+        {
+            controllers[i]->computeDecisions(ticks);
+        });
+}   // computeDecisions
+
+// ----------------------------------------------------------------------------
+/** Tests that each index of a job is run exactly once, and that the results
+ *  do not depend on the number of threads.
+ */
+void DecisionWorkers::unitTesting()
+{
+    const unsigned size = 100;
+    std::vector<uint64_t> expected;
+    for (unsigned threads : { 0u, 1u, 3u, 7u })
+    {
+        DecisionWorkers workers(threads);
+        for (unsigned job_size : { 0u, 1u, 2u, size })
+        {
+            std::vector<std::atomic<unsigned> > calls(job_size);
+            std::vector<uint64_t> results(job_size, 0);
+            for (unsigned i = 0; i < job_size; i++)
+                calls[i].store(0);
+            workers.run(job_size, [&calls, &results](unsigned i)
+                {
+                    calls[i].fetch_add(1);
+                    // Each index only changes its own data, like a
+                    // controller computing its decisions
+                    uint64_t value = i + 1;
+                    for (unsigned j = 0; j < 1000; j++)
+                        value = value * 6364136223846793005ULL + 1;
+                    results[i] = value;
+                });
+            for (unsigned i = 0; i < job_size; i++)
+                assert(calls[i].load() == 1);
+            if (job_size != size)
+                continue;
+            if (expected.empty())
+                expected = results;
+            assert(results == expected);
+        }
+    }
+}   // unitTesting
@@ -0,0 +1,86 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_DECISION_WORKERS_HPP
+#define HEADER_DECISION_WORKERS_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Controller;
+
+/** A small pool of threads used by the world to call
+ *  Controller::computeDecisions() of all AI karts in parallel. The calling
+ *  thread takes part in the work, and computeDecisions() only returns when
+ *  all controllers are done. Each controller only changes its own data, so
+ *  the result does not depend on the number of threads.
+ *  \ingroup controller
+ */
+class DecisionWorkers : public NoCopy
+{
+private:
+    std::vector<std::thread> m_threads;
+
+    /** Protects m_running, m_job_id and m_exit. */
+    std::mutex m_mutex;
+
+    /** Wakes up the workers when there are new decisions to compute. */
+    std::condition_variable m_start_cv;
+
+    /** Wakes up the caller of computeDecisions() when all workers are
+     *  finished. */
+    std::condition_variable m_done_cv;
+
+    /** The function of the current job, called once for each index from 0
+     *  to m_job_size - 1. */
+    const std::function<void(unsigned)>* m_job;
+
+    unsigned m_job_size;
+
+    /** Next index of the current job which still needs to be done. */
+    std::atomic<unsigned> m_next_index;
+
+    /** Number of workers which did not finish the current job. */
+    unsigned m_running;
+
+    /** Increased for each job, so a worker knows if there is a new one. */
+    uint64_t m_job_id;
+
+    bool m_exit;
+
+    void mainLoop();
+    void runNextIndices();
+    void run(unsigned size, const std::function<void(unsigned)>& job);
+
+public:
+    DecisionWorkers(unsigned num_threads);
+    ~DecisionWorkers();
+    void computeDecisions(const std::vector<Controller*>& controllers,
+                          int ticks);
+    static void unitTesting();
+
+};   // class DecisionWorkers
+
+#endif
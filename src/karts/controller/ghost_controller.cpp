@@ -21,6 +21,8 @@
 #include "karts/controller/kart_control.hpp"
 #include "modes/world.hpp"
 
+#include <algorithm>
+
 GhostController::GhostController(AbstractKart *kart, core::stringw display_name)
                 : Controller(kart)
 {
@@ -41,10 +43,17 @@ void GhostController::update(int ticks)
     // Find (if necessary) the next index to use
     if (m_current_time != 0.0f)
     {
-        while (m_current_index + 1 < m_all_times.size() &&
-               m_current_time >= m_all_times[m_current_index + 1])
+        // Binary search for the last event not after the current time, so
+        // jumping in time doesn't walk through all events in between
+        if ((m_current_index + 1 < m_all_times.size() &&
+             m_current_time >= m_all_times[m_current_index + 1]) ||
+            (m_current_index < m_all_times.size() &&
+             m_current_time < m_all_times[m_current_index]))
         {
-            m_current_index++;
+            auto it = std::upper_bound(m_all_times.begin(), m_all_times.end(),
+                                       m_current_time);
+            m_current_index = it == m_all_times.begin() ?
+                0 : (unsigned int)(it - m_all_times.begin() - 1);
         }
     }
 
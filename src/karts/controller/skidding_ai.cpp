@@ -176,6 +176,10 @@ void SkiddingAI::reset()
     m_skid_probability_state     = SKID_PROBAB_NOT_YET;
     m_last_item_random           = NULL;
     m_burster                    = false;
+    m_speed_cap                  = 1.0f;
+    m_rescue_requested           = false;
+    m_random_skid.seed(rand());
+    m_random_collect_item.seed(rand());
 
     AIBaseLapController::reset();
     m_track_node               = Graph::UNKNOWN_SECTOR;
@@ -221,7 +225,14 @@ unsigned int SkiddingAI::getNextSector(unsigned int index)
  */
 void SkiddingAI::update(int ticks)
 {
-    float dt = stk_config->ticks2Time(ticks);
+    // The decisions might have been computed already in parallel with the
+    // other AI karts, see World::update()
+    if (applyDecisions())
+    {
+        applyKartChanges();
+        return;
+    }
+
     m_controls->setRescue(false);
 
     // This is used to enable firing an item backwards.
@@ -312,6 +323,106 @@ void SkiddingAI::update(int ticks)
         return;
     }
 
+    decide(ticks);
+    applyKartChanges();
+}   // update
+
+//-----------------------------------------------------------------------------
+/** Computes the controls for the next update() while the other AI karts do
+ *  the same in parallel. The nolok boss, a stuck kart and the race start
+ *  change the kart directly, so in these cases update() does all work.
+ */
+void SkiddingAI::computeDecisions(int ticks)
+{
+    if (m_kart->getKartAnimation() ||
+        m_superpower == RaceManager::SUPERPOWER_NOLOK_BOSS ||
+        isStuck() || m_world->isStartPhase())
+        return;
+
+    beginDecisions();
+    m_controls->setRescue(false);
+    m_controls->setLookBack(false);
+    m_controls->setNitro(false);
+    decide(ticks);
+    endDecisions();
+}   // computeDecisions
+
+//-----------------------------------------------------------------------------
+/** Saves the data changed by decide(), see
+ *  AIBaseController::saveDecisionState().
+ */
+void SkiddingAI::saveDecisionState()
+{
+    AIBaseLapController::saveDecisionState();
+    m_saved_state.m_crashes                    = m_crashes;
+    m_saved_state.m_kart_ahead                 = m_kart_ahead;
+    m_saved_state.m_distance_ahead             = m_distance_ahead;
+    m_saved_state.m_kart_behind                = m_kart_behind;
+    m_saved_state.m_distance_behind            = m_distance_behind;
+    m_saved_state.m_distance_leader            = m_distance_leader;
+    m_saved_state.m_time_since_last_shot       = m_time_since_last_shot;
+    m_saved_state.m_time_since_stuck           = m_time_since_stuck;
+    m_saved_state.m_start_kart_crash_direction = m_start_kart_crash_direction;
+    m_saved_state.m_current_track_direction    = m_current_track_direction;
+    m_saved_state.m_current_curve_radius       = m_current_curve_radius;
+    m_saved_state.m_curve_center               = m_curve_center;
+    m_saved_state.m_last_direction_node        = m_last_direction_node;
+    m_saved_state.m_item_to_collect            = m_item_to_collect;
+    m_saved_state.m_avoid_item_close           = m_avoid_item_close;
+    m_saved_state.m_distance_to_player         = m_distance_to_player;
+    m_saved_state.m_num_players_ahead          = m_num_players_ahead;
+    m_saved_state.m_burster                    = m_burster;
+    m_saved_state.m_random_skid                = m_random_skid;
+    m_saved_state.m_skid_probability_state     = m_skid_probability_state;
+    m_saved_state.m_last_item_random           = m_last_item_random;
+    m_saved_state.m_really_collect_item        = m_really_collect_item;
+    m_saved_state.m_random_collect_item        = m_random_collect_item;
+    m_saved_state.m_speed_cap                  = m_speed_cap;
+    m_saved_state.m_rescue_requested           = m_rescue_requested;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+void SkiddingAI::restoreDecisionState()
+{
+    AIBaseLapController::restoreDecisionState();
+    m_crashes                    = m_saved_state.m_crashes;
+    m_kart_ahead                 = m_saved_state.m_kart_ahead;
+    m_distance_ahead             = m_saved_state.m_distance_ahead;
+    m_kart_behind                = m_saved_state.m_kart_behind;
+    m_distance_behind            = m_saved_state.m_distance_behind;
+    m_distance_leader            = m_saved_state.m_distance_leader;
+    m_time_since_last_shot       = m_saved_state.m_time_since_last_shot;
+    m_time_since_stuck           = m_saved_state.m_time_since_stuck;
+    m_start_kart_crash_direction = m_saved_state.m_start_kart_crash_direction;
+    m_current_track_direction    = m_saved_state.m_current_track_direction;
+    m_current_curve_radius       = m_saved_state.m_current_curve_radius;
+    m_curve_center               = m_saved_state.m_curve_center;
+    m_last_direction_node        = m_saved_state.m_last_direction_node;
+    m_item_to_collect            = m_saved_state.m_item_to_collect;
+    m_avoid_item_close           = m_saved_state.m_avoid_item_close;
+    m_distance_to_player         = m_saved_state.m_distance_to_player;
+    m_num_players_ahead          = m_saved_state.m_num_players_ahead;
+    m_burster                    = m_saved_state.m_burster;
+    m_random_skid                = m_saved_state.m_random_skid;
+    m_skid_probability_state     = m_saved_state.m_skid_probability_state;
+    m_last_item_random           = m_saved_state.m_last_item_random;
+    m_really_collect_item        = m_saved_state.m_really_collect_item;
+    m_random_collect_item        = m_saved_state.m_random_collect_item;
+    m_speed_cap                  = m_saved_state.m_speed_cap;
+    m_rescue_requested           = m_saved_state.m_rescue_requested;
+}   // restoreDecisionState
+
+//-----------------------------------------------------------------------------
+/** Determines steering, accelerating/braking and firing for this time step.
+ *  This only changes the controls and the data of this AI: changes of the
+ *  kart itself are stored and done in applyKartChanges(), so this can be
+ *  called from computeDecisions().
+ */
+void SkiddingAI::decide(int ticks)
+{
+    float dt = stk_config->ticks2Time(ticks);
+    m_rescue_requested = false;
+
     // Get information that is needed by more than 1 of the handling funcs
     computeNearestKarts();
 
@@ -321,12 +432,8 @@ void SkiddingAI::update(int ticks)
     if (m_kart->getBoostAI())
         position_among_ai = 1;
 
-    float speed_cap = m_ai_properties->getSpeedCap(m_distance_to_player,
-                                                   position_among_ai,
-                                                   num_ai);
-
-    m_kart->setSlowdown(MaxSpeed::MS_DECREASE_AI,
-                        speed_cap, /*fade_in_time*/0);
+    m_speed_cap = m_ai_properties->getSpeedCap(m_distance_to_player,
+                                               position_among_ai, num_ai);
 
     //Detect if we are going to crash with the track and/or kart
     checkCrashes(m_kart->getXYZ());
@@ -347,7 +454,18 @@ void SkiddingAI::update(int ticks)
 
     /*And obviously general kart stuff*/
     AIBaseLapController::update(ticks);
-}   // update
+}   // decide
+
+//-----------------------------------------------------------------------------
+/** Applies the speed cap and a rescue determined in decide() to the kart.
+ */
+void SkiddingAI::applyKartChanges()
+{
+    m_kart->setSlowdown(MaxSpeed::MS_DECREASE_AI,
+                        m_speed_cap, /*fade_in_time*/0);
+    if (m_rescue_requested)
+        RescueAnimation::create(m_kart);
+}   // applyKartChanges
 
 //-----------------------------------------------------------------------------
 /** Decides in which direction to steer. If the kart is off track, it will
@@ -660,7 +778,7 @@ void SkiddingAI::handleItemCollectionAndAvoidance(Vec3 *aim_point,
         {
             int p = (int)(100.0f*m_ai_properties->
                           getItemCollectProbability(m_distance_to_player));
-            m_really_collect_item = m_random_collect_item.get(100)<p;
+            m_really_collect_item = (int)(m_random_collect_item()%100)<p;
             m_last_item_random = items_to_collect[0];
         }
         if(!m_really_collect_item)
@@ -1099,7 +1217,8 @@ void SkiddingAI::handleItems(const float dt, const Vec3 *aim_point, int last_nod
             else
             {
                 // to make things less predictable :)
-                m_time_since_last_shot = (rand() % 1000) / 1000.0f * 3.0f - 2.0f;
+                m_time_since_last_shot =
+                    (m_random_skid() % 1000) / 1000.0f * 3.0f - 2.0f;
             }
         }
         else
@@ -1121,7 +1240,7 @@ void SkiddingAI::handleItems(const float dt, const Vec3 *aim_point, int last_nod
     if(item_skill == 1)
     {
         int random_t = 0;
-        random_t = m_random_skid.get(6); //Reuse the random skid generator
+        random_t = m_random_skid() % 6; //Reuse the random skid generator
         random_t = random_t + 5;
           
         if( m_time_since_last_shot > random_t )
@@ -2159,7 +2278,7 @@ void SkiddingAI::handleRescue(const float dt)
             if (m_enabled_network_ai)
                 m_controls->setRescue(true);
             else
-                RescueAnimation::create(m_kart);
+                m_rescue_requested = true;
             m_time_since_stuck=0.0f;
         }   // m_time_since_stuck > 2.0f
     }
@@ -3027,7 +3146,7 @@ void SkiddingAI::setSteering(float angle, float dt)
         {
             int prob = (int)(100.0f*m_ai_properties
                                ->getSkiddingProbability(m_distance_to_player));
-            int r = m_random_skid.get(100);
+            int r = m_random_skid() % 100;
             m_skid_probability_state = (r<prob)
                                      ? SKID_PROBAB_SKID
                                      : SKID_PROBAB_NO_SKID;
@@ -46,9 +46,9 @@
 #include "karts/controller/ai_base_lap_controller.hpp"
 #include "race/race_manager.hpp"
 #include "tracks/drive_node.hpp"
-#include "utils/random_generator.hpp"
 
 #include <line3d.h>
+#include <random>
 
 class ItemState;
 class LinearWorld;
@@ -193,8 +193,10 @@ private:
     /** This bool allows to make the AI use nitro by series of two bursts */
     bool m_burster;
 
-    /** A random number generator to decide if the AI should skid or not. */
-    RandomGenerator m_random_skid;
+    /** A random number generator to decide if the AI should skid or not.
+     *  Each AI has its own generators, so the decisions do not depend on
+     *  the order in which they are computed. */
+    std::mt19937 m_random_skid;
 
     /** This implements a simple finite state machine: it starts in
      *  NOT_YET. The first time the AI decides to skid, the state is changed
@@ -204,7 +206,8 @@ private:
      *  not to skid. In which case the state is set to NOT_YET again.
      *  This guarantees that for each 'skidable' section of the track
      *  the random decision is only done once. */
-    enum {SKID_PROBAB_NOT_YET, SKID_PROBAB_NO_SKID, SKID_PROBAB_SKID}
+    enum SkidProbabilityState
+         {SKID_PROBAB_NOT_YET, SKID_PROBAB_NO_SKID, SKID_PROBAB_SKID}
           m_skid_probability_state;
 
     /** This is used by computeSkill to know what skill is used */
@@ -218,7 +221,7 @@ private:
     bool m_really_collect_item;
 
     /** A random number generator for collecting items. */
-    RandomGenerator m_random_collect_item;
+    std::mt19937 m_random_collect_item;
 
     /** \brief Determines the algorithm to use to select the point-to-aim-for
      *  There are two different Point Selection Algorithms:
@@ -234,6 +237,45 @@ private:
     enum {PSA_DEFAULT, PSA_NEW}
           m_point_selection_algorithm;
 
+    /** The maximum speed fraction for rubber-banding determined in
+     *  decide(), which is applied to the kart in update(). */
+    float m_speed_cap;
+
+    /** Set by handleRescue() if the kart should be rescued, which is done
+     *  in update(). */
+    bool m_rescue_requested;
+
+    /** The data changed by decide(), saved by saveDecisionState() before
+     *  the decisions are computed in parallel. */
+    struct DecisionState
+    {
+        CrashTypes                 m_crashes;
+        AbstractKart              *m_kart_ahead;
+        float                      m_distance_ahead;
+        AbstractKart              *m_kart_behind;
+        float                      m_distance_behind;
+        float                      m_distance_leader;
+        float                      m_time_since_last_shot;
+        float                      m_time_since_stuck;
+        int                        m_start_kart_crash_direction;
+        DriveNode::DirectionType   m_current_track_direction;
+        float                      m_current_curve_radius;
+        Vec3                       m_curve_center;
+        unsigned int               m_last_direction_node;
+        const ItemState           *m_item_to_collect;
+        bool                       m_avoid_item_close;
+        float                      m_distance_to_player;
+        int                        m_num_players_ahead;
+        bool                       m_burster;
+        std::mt19937               m_random_skid;
+        SkidProbabilityState       m_skid_probability_state;
+        const ItemState           *m_last_item_random;
+        bool                       m_really_collect_item;
+        std::mt19937               m_random_collect_item;
+        float                      m_speed_cap;
+        bool                       m_rescue_requested;
+    } m_saved_state;
+
 #ifdef AI_DEBUG
     /** For skidding debugging: shows the estimated turn shape. */
     ShowCurve **m_curve;
@@ -253,6 +295,8 @@ private:
      *variable, except handle_race_start() that isn't associated with any
      *specific action (more like, associated with inaction).
      */
+    void  decide(int ticks);
+    void  applyKartChanges();
     void  handleRaceStart();
     void  handleAccelerationAndBraking(int ticks);
     void  handleSteering(float dt);
@@ -295,12 +339,16 @@ private:
 
 protected:
     virtual unsigned int getNextSector(unsigned int index);
+    virtual void saveDecisionState();
+    virtual void restoreDecisionState();
 
 public:
                  SkiddingAI(AbstractKart *kart);
                 ~SkiddingAI();
     virtual void update      (int ticks);
     virtual void reset       ();
+    virtual void computeDecisions(int ticks);
+    virtual bool canComputeDecisions() const { return true; }
     virtual const irr::core::stringw& getNamePostfix() const;
 };
 
@@ -115,10 +115,14 @@ void SoccerAI::update(int ticks)
     m_red_sphere->setPosition(red.toIrrVector());
     m_blue_sphere->setPosition(blue.toIrrVector());
 #endif
-    m_force_brake = false;
-    m_chasing_ball = false;
-    m_front_transform.setOrigin(m_kart->getFrontXYZ());
-    m_front_transform.setBasis(m_kart->getTrans().getBasis());
+    // Done in computeDecisions() if the decisions were computed in advance
+    if (!areDecisionsComputed())
+    {
+        m_force_brake = false;
+        m_chasing_ball = false;
+        m_front_transform.setOrigin(m_kart->getFrontXYZ());
+        m_front_transform.setBasis(m_kart->getTrans().getBasis());
+    }
 
     if (m_world->isGoalPhase())
     {
@@ -132,6 +136,42 @@ void SoccerAI::update(int ticks)
     ArenaAI::update(ticks);
 }   // update
 
+//-----------------------------------------------------------------------------
+/** Updates \ref m_front_transform before the decisions are computed, which
+ *  is left to update() after a goal.
+ */
+void SoccerAI::computeDecisions(int ticks)
+{
+    if (m_world->isGoalPhase())
+        return;
+
+    m_force_brake = false;
+    m_chasing_ball = false;
+    m_front_transform.setOrigin(m_kart->getFrontXYZ());
+    m_front_transform.setBasis(m_kart->getTrans().getBasis());
+    ArenaAI::computeDecisions(ticks);
+}   // computeDecisions
+
+//-----------------------------------------------------------------------------
+void SoccerAI::saveDecisionState()
+{
+    ArenaAI::saveDecisionState();
+    m_saved_state.m_overtake_ball   = m_overtake_ball;
+    m_saved_state.m_force_brake     = m_force_brake;
+    m_saved_state.m_chasing_ball    = m_chasing_ball;
+    m_saved_state.m_front_transform = m_front_transform;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+void SoccerAI::restoreDecisionState()
+{
+    ArenaAI::restoreDecisionState();
+    m_overtake_ball   = m_saved_state.m_overtake_ball;
+    m_force_brake     = m_saved_state.m_force_brake;
+    m_chasing_ball    = m_saved_state.m_chasing_ball;
+    m_front_transform = m_saved_state.m_front_transform;
+}   // restoreDecisionState
+
 //-----------------------------------------------------------------------------
 /** Find the closest kart around this AI, it won't find the kart with same
  *  team, consider_difficulty and find_sta are not used here.
@@ -65,6 +65,16 @@ private:
      *  to determine point for aiming with ball */
     btTransform m_front_transform;
 
+    /** The data changed when computing the decisions, saved by
+     *  saveDecisionState(). */
+    struct DecisionState
+    {
+        bool        m_overtake_ball;
+        bool        m_force_brake;
+        bool        m_chasing_ball;
+        btTransform m_front_transform;
+    } m_saved_state;
+
     // ------------------------------------------------------------------------
     Vec3  determineBallAimingPosition();
     // ------------------------------------------------------------------------
@@ -97,11 +107,16 @@ private:
     virtual bool  isWaiting() const OVERRIDE;
     // ------------------------------------------------------------------------
     virtual void  resetAfterStop() OVERRIDE        { m_overtake_ball = false; }
+    // ------------------------------------------------------------------------
+    virtual void  saveDecisionState() OVERRIDE;
+    // ------------------------------------------------------------------------
+    virtual void  restoreDecisionState() OVERRIDE;
 
 public:
                  SoccerAI(AbstractKart *kart);
                 ~SoccerAI();
     virtual void update (int ticks) OVERRIDE;
+    virtual void computeDecisions(int ticks) OVERRIDE;
     virtual void reset() OVERRIDE;
 
 };
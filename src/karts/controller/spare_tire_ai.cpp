@@ -103,6 +103,20 @@ void SpareTireAI::findTarget()
     m_target_point = m_graph->getNode(chosen_node)->getCenter();
 }   // findTarget
 
+//-----------------------------------------------------------------------------
+void SpareTireAI::saveDecisionState()
+{
+    BattleAI::saveDecisionState();
+    m_saved_idx = m_idx;
+}   // saveDecisionState
+
+//-----------------------------------------------------------------------------
+void SpareTireAI::restoreDecisionState()
+{
+    BattleAI::restoreDecisionState();
+    m_idx = m_saved_idx;
+}   // restoreDecisionState
+
 //-----------------------------------------------------------------------------
 /** Spawn the SpareTireAI, it will start appearing in the battle mode and
  *  moving around.
@@ -37,9 +37,16 @@ private:
     /** Store the time before calling \ref unspawn. */
     int m_timer;
 
+    /** \ref m_idx before the decisions were computed. */
+    int m_saved_idx;
+
     // ------------------------------------------------------------------------
     virtual void  findTarget() OVERRIDE;
     // ------------------------------------------------------------------------
+    virtual void  saveDecisionState() OVERRIDE;
+    // ------------------------------------------------------------------------
+    virtual void  restoreDecisionState() OVERRIDE;
+    // ------------------------------------------------------------------------
     void          findDefaultPath();
 
 public:
@@ -135,6 +135,7 @@ Kart::Kart (const std::string& ident, unsigned int world_kart_id,
     m_boosted_ai           = false;
     m_type                 = RaceManager::KT_AI;
     m_flying               = false;
+    m_has_animation_before = false;
 
     m_xyz_history_size     = stk_config->time2Ticks(XYZ_HISTORY_TIME);
 
@@ -1351,9 +1352,21 @@ void Kart::eliminate()
 //-----------------------------------------------------------------------------
 /** Updates the kart in each time step. It updates the physics setting,
  *  particle effects, camera position, etc.
- *  \param dt Time step size.
+ *  \param ticks Number of physics time steps.
  */
 void Kart::update(int ticks)
+{
+    updateBeforeController(ticks);
+    m_controller->update(ticks);
+    updateAfterController(ticks);
+}   // update
+
+//-----------------------------------------------------------------------------
+/** Updates the state of the kart which the controller uses: the position
+ *  from the physics or a kart animation, the speed and the powerup.
+ *  \param ticks Number of physics time steps.
+ */
+void Kart::updateBeforeController(int ticks)
 {
     if (m_network_finish_check_ticks > 0 &&
         World::getWorld()->getTicksSinceStart() >
@@ -1405,12 +1418,12 @@ void Kart::update(int ticks)
     }
 
     // This is to avoid a rescue immediately after an explosion
-    const bool has_animation_before = m_kart_animation != NULL;
+    m_has_animation_before = m_kart_animation != NULL;
     // A kart animation can change the xyz position. This needs to be done
     // before updating the graphical position (which is done in
     // Moveable::update() ), otherwise 'stuttering' can happen (caused by
     // graphical and physical position not being the same).
-    if (has_animation_before)
+    if (m_has_animation_before)
     {
         m_kart_animation->update(ticks);
     }
@@ -1471,8 +1484,16 @@ void Kart::update(int ticks)
     // reduce the restitution, meaning the karts will get less of a push
     // based on the collision speed.
     m_body->setRestitution(m_kart_properties->getRestitution(fabsf(m_speed)));
+}   // updateBeforeController
 
-    m_controller->update(ticks);
+//-----------------------------------------------------------------------------
+/** Updates the kart using the controls set by the controller: physics,
+ *  terrain, attachment, slipstream and firing of powerups.
+ *  \param ticks Number of physics time steps.
+ */
+void Kart::updateAfterController(int ticks)
+{
+    const bool has_animation_before = m_has_animation_before;
 
 #ifndef SERVER_ONLY
 #undef DEBUG_CAMERA_SHAKE
@@ -1834,7 +1855,7 @@ void Kart::update(int ticks)
         }
     }
 
-}   // update
+}   // updateAfterController
 
 //-----------------------------------------------------------------------------
 /** Updates the local speed based on the current physical velocity. The value
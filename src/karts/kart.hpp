@@ -100,6 +100,9 @@ protected:
 
     bool m_enabled_network_spectator;
 
+    /** True if the kart had an animation at the start of update(). */
+    bool m_has_animation_before;
+
     /** The sign of torque to apply after hitting a bubble gum. */
     bool        m_bubblegum_torque_sign;
 
@@ -342,6 +345,8 @@ public:
     virtual void   crashed          (const Material *m, const Vec3 &normal) OVERRIDE;
     virtual float  getHoT           () const OVERRIDE;
     virtual void   update           (int ticks) OVERRIDE;
+    virtual void   updateBeforeController(int ticks) OVERRIDE;
+    virtual void   updateAfterController(int ticks) OVERRIDE;
     virtual void   finishedRace     (float time, bool from_server=false) OVERRIDE;
     virtual void   setPosition      (int p) OVERRIDE;
     virtual void   beep             () OVERRIDE;
@@ -56,11 +56,11 @@ void KartWithStats::reset()
 // ----------------------------------------------------------------------------
 /** This function is called each timestep, and it collects most of the
  *  statistics for this kart.
- *  \param dt Time step size.
+ *  \param ticks Number of physics time steps.
  */
-void KartWithStats::update(int ticks)
+void KartWithStats::updateAfterController(int ticks)
 {
-    Kart::update(ticks);
+    Kart::updateAfterController(ticks);
     if(getSpeed()>m_top_speed        ) m_top_speed = getSpeed();
     float dt = stk_config->ticks2Time(ticks);
     if(getControls().getSkidControl()) m_skidding_time += dt;
@@ -68,7 +68,7 @@ void KartWithStats::update(int ticks)
     LinearWorld *world = dynamic_cast<LinearWorld*>(World::getWorld());
     if(world && !world->isOnRoad(getWorldKartId()))
         m_off_track_count ++;
-}   // update
+}   // updateAfterController
 
 // ----------------------------------------------------------------------------
 /** Overloading setKartAnimation with a kind of listener function in order
@@ -76,7 +76,7 @@ public:
                                int position,
                                const btTransform& init_transform,
                                PerPlayerDifficulty difficulty);
-    virtual void update(int ticks) OVERRIDE;
+    virtual void updateAfterController(int ticks) OVERRIDE;
     virtual void reset() OVERRIDE;
     virtual void collectedItem(ItemState *item_state) OVERRIDE;
     virtual void setKartAnimation(AbstractKartAnimation *ka) OVERRIDE;
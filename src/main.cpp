@@ -157,7 +157,9 @@
 #    include <direct.h>
 #  endif
 #else
+#  include <errno.h>
 #  include <signal.h>
+#  include <sys/wait.h>
 #  include <unistd.h>
 #endif
 #include <stdexcept>
@@ -208,26 +210,34 @@
 #include "items/projectile_manager.hpp"
 #include "karts/combined_characteristic.hpp"
 #include "karts/controller/ai_base_lap_controller.hpp"
+#include "karts/controller/decided_controls.hpp"
+#include "karts/controller/decision_workers.hpp"
 #include "karts/kart_model.hpp"
 #include "karts/kart_properties.hpp"
 #include "karts/kart_properties_manager.hpp"
 #include "modes/cutscene_world.hpp"
 #include "modes/demo_world.hpp"
 #include "modes/profile_world.hpp"
+#include "network/protocol_manager.hpp"
 #include "network/protocols/connect_to_server.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/protocols/server_lobby.hpp"
+#include "network/ban_index.hpp"
 #include "network/network_config.hpp"
+#include "network/network_simulator.hpp"
 #include "network/network_string.hpp"
 #include "network/rewind_manager.hpp"
 #include "network/rewind_queue.hpp"
+#include "network/send_workers.hpp"
 #include "network/server.hpp"
 #include "network/server_config.hpp"
+#include "network/server_metrics.hpp"
 #include "network/servers_manager.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
 #include "online/profile_manager.hpp"
 #include "online/request_manager.hpp"
+#include "physics/triangle_mesh.hpp"
 #include "race/grand_prix_manager.hpp"
 #include "race/highscore_manager.hpp"
 #include "race/history.hpp"
@@ -602,6 +612,13 @@ void cmdLineHelp()
     // "    --disable-item-collection Disable item collection. Useful for\n"
     // "                          debugging client/server item management.\n"
     // "    --network-item-debugging Print item handling debug information.\n"
+    "       --network-desync-debugging Log the rewinders whose state differs\n"
+    "                          between server and client simulation.\n"
+    "       --network-latency=n Simulate n ms latency for received packets.\n"
+    "       --network-jitter=n Simulate n ms jitter for received packets.\n"
+    "       --network-loss=n   Simulate n%% loss of received packets.\n"
+    "       --network-reorder=n Let n%% of received packets skip the latency.\n"
+    "       --network-bandwidth=n Limit received packets to n kbit/s per peer.\n"
     "       --server-config=file Specify the server_config.xml for server hosting, it will create\n"
     "                            one if not found.\n"
     "       --network-console  Enable network console.\n"
@@ -631,6 +648,8 @@ void cmdLineHelp()
     "       --no-team-choosing Disable choosing team in lobby for team game.\n"
     "       --network-gp=n     Specify number of tracks used in network grand prix.\n"
     "       --graphical-server Enable graphical view in server.\n"
+    "       --server-instances=n Run n servers sharing the loaded karts and tracks, each\n"
+    "                          using the next port and its own log file (not on Windows).\n"
     "       --no-validation    Allow non validated and unencrypted connection in wan.\n"
     "       --ranked           Server will submit ranking to stk addons server.\n"
     "       --no-ranked        Server will not submit ranking to stk addons server.\n"
@@ -1207,6 +1226,21 @@ int handleCmdLine(bool has_server_config, bool has_parent_process)
 
     if (CommandLine::has("--network-item-debugging"))
         NetworkItemManager::m_network_item_debugging = true;
+
+    if (CommandLine::has("--network-desync-debugging"))
+        RewindManager::m_desync_debugging = true;
+
+    if (CommandLine::has("--network-latency", &n))
+        NetworkSimulator::m_cmd_latency = n;
+    if (CommandLine::has("--network-jitter", &n))
+        NetworkSimulator::m_cmd_jitter = n;
+    float f;
+    if (CommandLine::has("--network-loss", &f))
+        NetworkSimulator::m_cmd_loss = f;
+    if (CommandLine::has("--network-reorder", &f))
+        NetworkSimulator::m_cmd_reorder = f;
+    if (CommandLine::has("--network-bandwidth", &n))
+        NetworkSimulator::m_cmd_bandwidth = n;
     
     std::string server_password;
     if (CommandLine::has("--server-password", &s))
@@ -1712,7 +1746,10 @@ void initRest()
     // The rest will be read later (since the rest needs the unlock- and
     // achievement managers to be created, which can only be created later).
     PlayerManager::create();
-    Online::RequestManager::get()->startNetworkThread();
+    // With server instances the thread is started in each forked process,
+    // as threads are not copied by fork
+    if (!CommandLine::has("--server-instances"))
+        Online::RequestManager::get()->startNetworkThread();
 #ifndef SERVER_ONLY
     if (!ProfileWorld::isNoGraphics())
         NewsManager::get();   // this will create the news manager
@@ -1775,6 +1812,75 @@ void initRest()
 
 }   // initRest
 
+//=============================================================================
+#if !defined(WIN32) && !defined(ANDROID)
+/** Process ids of all forked server instances, used by the parent process to
+ *  forward SIGTERM. */
+static std::vector<pid_t> g_server_instances;
+
+// ----------------------------------------------------------------------------
+/** Forks the server into the given number of instances once all karts and
+ *  tracks are loaded, so all instances share this read-only data copy on
+ *  write instead of each server process loading it again. Each instance
+ *  gets its own log file, server uid (for its database tables), port and
+ *  name, see ServerConfig::loadServerLobbyFromConfig. The parent process
+ *  only waits for all instances to exit.
+ *  \param instances Number of server instances.
+ *  \return False in the parent process after all instances exited, true
+ *          in each server instance.
+ */
+static bool forkServerInstances(int instances)
+{
+    for (int i = 1; i <= instances; i++)
+    {
+        pid_t pid = fork();
+        if (pid == -1)
+        {
+            Log::error("main", "Failed to fork server instance %d.", i);
+            continue;
+        }
+        if (pid == 0)
+        {
+            g_server_instances.clear();
+            ServerConfig::m_server_instance = i;
+            ServerConfig::m_server_uid += "_" + StringUtils::toString(i);
+            FileManager::setStdoutName(StringUtils::removeExtension(
+                FileManager::getStdoutName()) + "_" +
+                StringUtils::toString(i) + ".log");
+            Log::closeOutputFiles();
+            file_manager->redirectOutput();
+            Online::RequestManager::get()->startNetworkThread();
+            return true;
+        }
+        Log::info("main", "Started server instance %d with pid %d.", i,
+            (int)pid);
+        g_server_instances.push_back(pid);
+    }
+
+    signal(SIGTERM, [](int signum)
+        {
+            for (pid_t pid : g_server_instances)
+                kill(pid, SIGTERM);
+        });
+    unsigned exited = 0;
+    while (exited < g_server_instances.size())
+    {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        Log::info("main", "Server instance with pid %d exited with status "
+            "%d.", (int)pid, status);
+        exited++;
+    }
+    return false;
+}   // forkServerInstances
+#endif
+
 //=============================================================================
 void askForInternetPermission()
 {
@@ -2034,6 +2140,28 @@ int main(int argc, char *argv[] )
         GUIEngine::addLoadingIcon( irr_driver->getTexture(FileManager::GUI_ICON,
                                                           "banana.png")    );
 
+        int server_instances = 0;
+        if (CommandLine::has("--server-instances", &server_instances))
+        {
+#if !defined(WIN32) && !defined(ANDROID)
+            if (!NetworkConfig::get()->isServer() || server_instances < 1)
+            {
+                Log::warn("main", "--server-instances requires a positive "
+                    "number and a server, ignored.");
+                Online::RequestManager::get()->startNetworkThread();
+            }
+            else if (!forkServerInstances(server_instances))
+            {
+                Log::flushBuffers();
+                exit(0);
+            }
+#else
+            Log::warn("main", "--server-instances is not supported on this "
+                "platform, ignored.");
+            Online::RequestManager::get()->startNetworkThread();
+#endif
+        }
+
         //handleCmdLine() needs InitTuxkart() so it can't be called first
         if (!handleCmdLine(!server_config.empty(), has_parent_process))
             exit(0);
@@ -2053,8 +2181,7 @@ int main(int argc, char *argv[] )
                 {
                     try
                     {
-                        const XMLNode *xml = new XMLNode(xml_file);
-                        addons_manager->initAddons(xml);
+                        addons_manager->initAddons(xml_file);
                     }
                     catch (std::runtime_error& e)
                     {
@@ -2442,6 +2569,20 @@ void runUnitTests()
     NetworkString::unitTesting();
     Log::info("UnitTest", "TransportAddress");
     TransportAddress::unitTesting();
+    Log::info("UnitTest", "ServerMetrics");
+    ServerMetrics::unitTesting();
+    Log::info("UnitTest", "SendWorkers");
+    SendWorkers::unitTesting();
+    Log::info("UnitTest", "ProtocolManager");
+    ProtocolManager::unitTesting();
+    Log::info("UnitTest", "BanIndex");
+    BanIndex::unitTesting();
+    Log::info("UnitTest", "RewindManager");
+    RewindManager::unitTesting();
+    Log::info("UnitTest", "DecisionWorkers");
+    DecisionWorkers::unitTesting();
+    Log::info("UnitTest", "DecidedControls");
+    DecidedControls::unitTesting();
     Log::info("UnitTest", "StringUtils::versionToInt");
     StringUtils::unitTesting();
 
@@ -2485,6 +2626,9 @@ void runUnitTests()
     Log::info("UnitTest", "Arena Graph");
     ArenaGraph::unitTesting();
 
+    Log::info("UnitTest", "TriangleMesh ray casts");
+    TriangleMesh::unitTesting();
+
     Log::info("UnitTest", "Fonts for translation");
     font_manager->unitTesting();
 
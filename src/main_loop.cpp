@@ -38,6 +38,7 @@
 #include "network/protocol_manager.hpp"
 #include "network/race_event_manager.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/server_metrics.hpp"
 #include "network/stk_host.hpp"
 #include "online/request_manager.hpp"
 #include "race/history.hpp"
@@ -498,6 +499,14 @@ void MainLoop::run()
                                        World::getWorld()->getTicksSinceStart());
                 }
 
+                // Only the ticks of a running game are measured for the
+                // server metrics, the lobby ticks are much shorter
+                ServerMetrics* metrics = ServerMetrics::get();
+                const bool profile_tick =
+                    metrics->isEnabled() && World::getWorld();
+                const uint64_t tick_start =
+                    profile_tick ? StkTime::getMonoTimeUs() : 0;
+
                 PROFILER_PUSH_CPU_MARKER("Protocol manager update",
                                          0x7F, 0x00, 0x7F);
                 if (auto pm = ProtocolManager::lock())
@@ -506,6 +515,8 @@ void MainLoop::run()
                 }
                 PROFILER_POP_CPU_MARKER();
 
+                const uint64_t world_start =
+                    profile_tick ? StkTime::getMonoTimeUs() : 0;
                 PROFILER_PUSH_CPU_MARKER("Update race", 0, 255, 255);
                 if (World::getWorld())
                 {
@@ -513,6 +524,16 @@ void MainLoop::run()
                 }
                 PROFILER_POP_CPU_MARKER();
 
+                if (profile_tick)
+                {
+                    const uint64_t tick_end = StkTime::getMonoTimeUs();
+                    metrics->addTickPhase(ServerMetrics::TP_PROTOCOLS,
+                        world_start - tick_start);
+                    metrics->addTickPhase(ServerMetrics::TP_WORLD,
+                        tick_end - world_start);
+                    metrics->addTick(tick_end - tick_start);
+                }
+
                 // We need to check again because update_race may have requested
                 // the main loop to abort; and it's not a good idea to continue
                 // since the GUI engine is no more to be called then.
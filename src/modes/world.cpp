@@ -37,6 +37,7 @@
 #include "input/keyboard_device.hpp"
 #include "items/projectile_manager.hpp"
 #include "karts/controller/battle_ai.hpp"
+#include "karts/controller/decision_workers.hpp"
 #include "karts/ghost_kart.hpp"
 #include "karts/controller/end_controller.hpp"
 #include "karts/controller/local_player_controller.hpp"
@@ -56,6 +57,7 @@
 #include "network/protocols/client_lobby.hpp"
 #include "network/network_config.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/server_config.hpp"
 #include "physics/btKart.hpp"
 #include "physics/physics.hpp"
 #include "physics/triangle_mesh.hpp"
@@ -272,6 +274,18 @@ void World::init()
     for (unsigned int i = 0; i < kart_amount; i++)
         initTeamArrows(m_karts[i].get());
 
+    // Clients of a network game update the karts in the same order as the
+    // server, which only computes AI decisions in parallel if configured
+    int ai_threads = UserConfigParams::m_ai_threads;
+    if (NetworkConfig::get()->isNetworking())
+    {
+        ai_threads = NetworkConfig::get()->isServer() ?
+            (int)ServerConfig::m_ai_threads : 0;
+    }
+    m_decision_workers.reset();
+    if (ai_threads > 0)
+        m_decision_workers.reset(new DecisionWorkers(ai_threads));
+
     main_loop->renderGUI(7300);
 }   // init
 
@@ -1064,6 +1078,16 @@ void World::updateGraphics(float dt)
     Track::getCurrentTrack()->updateGraphics(dt);
 }   // updateGraphics
 
+// ----------------------------------------------------------------------------
+/** Returns if a kart needs to be updated in this time step.
+ */
+static bool needsUpdate(AbstractKart* kart)
+{
+    SpareTireAI* sta = dynamic_cast<SpareTireAI*>(kart->getController());
+    // Update all karts that are not eliminated
+    return !kart->isEliminated() || (sta && sta->isMoving());
+}   // needsUpdate
+
 //-----------------------------------------------------------------------------
 /** Updates the physics, all karts, the track, and projectile manager.
  *  \param ticks Number of physics time steps - should be 1.
@@ -1102,16 +1126,18 @@ void World::update(int ticks)
     // Update all the karts. This in turn will also update the controller,
     // which causes all AI steering commands set. So in the following 
     // physics update the new steering is taken into account.
-    const int kart_amount = (int)m_karts.size();
-    for (int i = 0 ; i < kart_amount; ++i)
+    if (m_decision_workers)
+        updateKartsWithDecisions(ticks);
+    else
     {
-        SpareTireAI* sta =
-            dynamic_cast<SpareTireAI*>(m_karts[i]->getController());
-        // Update all karts that are not eliminated
-        if(!m_karts[i]->isEliminated() || (sta && sta->isMoving()))
-            m_karts[i]->update(ticks);
-        if (isStartPhase())
-            m_karts[i]->makeKartRest();
+        const int kart_amount = (int)m_karts.size();
+        for (int i = 0 ; i < kart_amount; ++i)
+        {
+            if (needsUpdate(m_karts[i].get()))
+                m_karts[i]->update(ticks);
+            if (isStartPhase())
+                m_karts[i]->makeKartRest();
+        }
     }
     PROFILER_POP_CPU_MARKER();
     if(race_manager->isRecordingRace()) ReplayRecorder::get()->update(ticks);
@@ -1131,6 +1157,56 @@ void World::update(int ticks)
 #endif
 }   // update
 
+// ----------------------------------------------------------------------------
+/** Updates all karts like World::update() does when ai_threads is 0, but
+ *  computes the decisions of the AI karts in parallel. First all karts whose
+ *  controller supports it are updated up to the controller, then the
+ *  decisions of their controllers are computed in parallel, and afterwards
+ *  all karts are updated in order. So unlike the serial update, the "before
+ *  controller" part (e.g. powerup and kart animation ticks) of all AI karts
+ *  is done before any other kart is updated, and each AI decides based on
+ *  the state of all karts at this point, not on karts updated before it in
+ *  the same time step. The result does not depend on the number of threads.
+ *  \param ticks Number of physics time steps.
+ */
+void World::updateKartsWithDecisions(int ticks)
+{
+    const int kart_amount = (int)m_karts.size();
+    m_decision_controllers.clear();
+    m_updated_before_controller.assign(kart_amount, false);
+    for (int i = 0 ; i < kart_amount; ++i)
+    {
+        AbstractKart* kart = m_karts[i].get();
+        if (!needsUpdate(kart) ||
+            !kart->getController()->canComputeDecisions())
+            continue;
+        kart->updateBeforeController(ticks);
+        m_updated_before_controller[i] = true;
+        // The controller can be changed when updating the kart
+        if (kart->getController()->canComputeDecisions())
+            m_decision_controllers.push_back(kart->getController());
+    }
+    m_decision_workers->computeDecisions(m_decision_controllers, ticks);
+
+    for (int i = 0 ; i < kart_amount; ++i)
+    {
+        AbstractKart* kart = m_karts[i].get();
+        // A kart can be eliminated by an earlier kart
+        if (needsUpdate(kart))
+        {
+            if (m_updated_before_controller[i])
+            {
+                kart->getController()->update(ticks);
+                kart->updateAfterController(ticks);
+            }
+            else
+                kart->update(ticks);
+        }
+        if (isStartPhase())
+            kart->makeKartRest();
+    }
+}   // updateKartsWithDecisions
+
 // ----------------------------------------------------------------------------
 /** Only updates the track. The order in which the various parts of STK are
  *  updated is quite important (i.e. the track can't be updated as part of
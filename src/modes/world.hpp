@@ -44,6 +44,7 @@ class AbstractKart;
 class BareNetworkString;
 class btRigidBody;
 class Controller;
+class DecisionWorkers;
 class ItemState;
 class PhysicalObject;
 
@@ -112,6 +113,17 @@ protected:
     KartList                  m_karts;
     RandomGenerator           m_random;
 
+    /** Computes the decisions of the AI karts in parallel, or NULL if all
+     *  karts are updated one after the other. */
+    std::unique_ptr<DecisionWorkers> m_decision_workers;
+
+    /** The controllers whose decisions are computed in update(). Only a
+     *  member to avoid allocating it in each time step. */
+    std::vector<Controller*> m_decision_controllers;
+
+    /** For each kart if it was updated up to its controller in update(). */
+    std::vector<bool> m_updated_before_controller;
+
     AbstractKart* m_fastest_kart;
     /** Number of eliminated karts. */
     int         m_eliminated_karts;
@@ -185,6 +197,7 @@ protected:
     virtual void  update(int ticks) OVERRIDE;
     virtual void  createRaceGUI();
             void  updateTrack(int ticks);
+            void  updateKartsWithDecisions(int ticks);
     // ------------------------------------------------------------------------
     /** Used for AI karts that are still racing when all player kart finished.
      *  Generally it should estimate the arrival time for those karts, but as
@@ -0,0 +1,283 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/ban_index.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+BanIndex::BanIndex()
+{
+    clear();
+}   // BanIndex
+
+// ----------------------------------------------------------------------------
+/** Removes all bans, e.g. before reading the ban tables again. */
+void BanIndex::clear()
+{
+    m_all_ip_bans.clear();
+    m_all_online_id_bans.clear();
+    m_ip_bans.clear();
+    m_max_ip_end.clear();
+    m_online_id_bans.clear();
+    m_update_time = -1;
+    m_next_change_time = -1;
+}   // clear
+
+// ----------------------------------------------------------------------------
+/** Adds a ban of all IPs from ip_start to ip_end (inclusive). */
+void BanIndex::addIPBan(uint32_t ip_start, uint32_t ip_end, const Ban& ban)
+{
+    IPBan ip_ban;
+    ip_ban.m_ip_start = ip_start;
+    ip_ban.m_ip_end = ip_end;
+    ip_ban.m_ban = ban;
+    m_all_ip_bans.push_back(ip_ban);
+    // The active bans point into the vector, so select them again
+    m_update_time = -1;
+}   // addIPBan
+
+// ----------------------------------------------------------------------------
+void BanIndex::addOnlineIdBan(uint32_t online_id, const Ban& ban)
+{
+    m_all_online_id_bans.emplace_back(online_id, ban);
+    m_update_time = -1;
+}   // addOnlineIdBan
+
+// ----------------------------------------------------------------------------
+/** Replaces all bans by the bans of another index, so the copy can be
+ *  updated while the other index is still used. */
+void BanIndex::copyBans(const BanIndex& other)
+{
+    clear();
+    m_all_ip_bans = other.m_all_ip_bans;
+    m_all_online_id_bans = other.m_all_online_id_bans;
+}   // copyBans
+
+// ----------------------------------------------------------------------------
+/** Removes the IP ban with the given rowid in the ban table, if any. */
+void BanIndex::removeIPBan(int row_id)
+{
+    m_all_ip_bans.erase(std::remove_if(m_all_ip_bans.begin(),
+        m_all_ip_bans.end(), [row_id](const IPBan& ip_ban)
+        {
+            return ip_ban.m_ban.m_row_id == row_id;
+        }), m_all_ip_bans.end());
+    m_update_time = -1;
+}   // removeIPBan
+
+// ----------------------------------------------------------------------------
+/** Removes the online id ban with the given rowid in the ban table, if any. */
+void BanIndex::removeOnlineIdBan(int row_id)
+{
+    m_all_online_id_bans.erase(std::remove_if(m_all_online_id_bans.begin(),
+        m_all_online_id_bans.end(),
+        [row_id](const std::pair<uint32_t, Ban>& online_id_ban)
+        {
+            return online_id_ban.second.m_row_id == row_id;
+        }), m_all_online_id_bans.end());
+    m_update_time = -1;
+}   // removeOnlineIdBan
+
+// ----------------------------------------------------------------------------
+/** Same condition as the ban queries used: the ban has started and not
+ *  expired yet. */
+bool BanIndex::isActive(const Ban& ban, int64_t now)
+{
+    return now > ban.m_start_time &&
+        (ban.m_expired_time < 0 || ban.m_expired_time > now);
+}   // isActive
+
+// ----------------------------------------------------------------------------
+/** Selects the bans active at the given time, and finds the time at which
+ *  this selection needs to be done again. */
+void BanIndex::selectActiveBans(int64_t now)
+{
+    m_update_time = now;
+    m_next_change_time = -1;
+    auto update_next_change = [this, now](const Ban& ban)
+    {
+        int64_t change = -1;
+        if (ban.m_start_time >= now)
+            change = ban.m_start_time + 1;
+        else if (ban.m_expired_time >= 0 && ban.m_expired_time > now)
+            change = ban.m_expired_time;
+        if (change != -1 &&
+            (m_next_change_time == -1 || change < m_next_change_time))
+            m_next_change_time = change;
+    };
+
+    m_ip_bans.clear();
+    for (const IPBan& ip_ban : m_all_ip_bans)
+    {
+        update_next_change(ip_ban.m_ban);
+        if (isActive(ip_ban.m_ban, now))
+            m_ip_bans.push_back(&ip_ban);
+    }
+    std::sort(m_ip_bans.begin(), m_ip_bans.end(),
+        [](const IPBan* a, const IPBan* b)
+        {
+            return a->m_ip_start < b->m_ip_start;
+        });
+    m_max_ip_end.resize(m_ip_bans.size());
+    for (unsigned i = 0; i < m_ip_bans.size(); i++)
+    {
+        m_max_ip_end[i] = i == 0 ? m_ip_bans[i]->m_ip_end :
+            std::max(m_max_ip_end[i - 1], m_ip_bans[i]->m_ip_end);
+    }
+
+    m_online_id_bans.clear();
+    for (const auto& online_id_ban : m_all_online_id_bans)
+    {
+        update_next_change(online_id_ban.second);
+        if (isActive(online_id_ban.second, now))
+        {
+            m_online_id_bans.emplace(online_id_ban.first,
+                                     &online_id_ban.second);
+        }
+    }
+}   // selectActiveBans
+
+// ----------------------------------------------------------------------------
+/** Selects the active bans again if bans were added, a ban started or
+ *  expired, or the clock was changed. */
+void BanIndex::checkChanges(int64_t now)
+{
+    if (m_update_time == -1 || now < m_update_time ||
+        (m_next_change_time != -1 && now >= m_next_change_time))
+        selectActiveBans(now);
+}   // checkChanges
+
+// ----------------------------------------------------------------------------
+/** Returns an active ban of the given IP, or NULL if it is not banned.
+ *  \param ip The IP in host byte order.
+ *  \param now Current time in seconds since 1.1.1970.
+ */
+const BanIndex::Ban* BanIndex::findIPBan(uint32_t ip, int64_t now)
+{
+    checkChanges(now);
+    auto it = std::upper_bound(m_ip_bans.begin(), m_ip_bans.end(), ip,
+        [](uint32_t ip, const IPBan* ip_ban)
+        {
+            return ip < ip_ban->m_ip_start;
+        });
+    // All ranges before it start at or before ip. The running maximum of
+    // the ends doesn't decrease, so the first range where it reaches ip is
+    // the first range which ends at or after ip itself.
+    const size_t count = it - m_ip_bans.begin();
+    auto end = std::lower_bound(m_max_ip_end.begin(),
+                                m_max_ip_end.begin() + count, ip);
+    if (end == m_max_ip_end.begin() + count)
+        return NULL;
+    const IPBan* ip_ban = m_ip_bans[end - m_max_ip_end.begin()];
+    assert(ip_ban->m_ip_end >= ip);
+    return &ip_ban->m_ban;
+}   // findIPBan
+
+// ----------------------------------------------------------------------------
+/** Returns an active ban of the given online id, or NULL if it is not
+ *  banned.
+ *  \param now Current time in seconds since 1.1.1970.
+ */
+const BanIndex::Ban* BanIndex::findOnlineIdBan(uint32_t online_id,
+                                               int64_t now)
+{
+    checkChanges(now);
+    auto it = m_online_id_bans.find(online_id);
+    return it == m_online_id_bans.end() ? NULL : it->second;
+}   // findOnlineIdBan
+
+// ----------------------------------------------------------------------------
+void BanIndex::unitTesting()
+{
+    BanIndex index;
+    Ban ban;
+    ban.m_row_id = 1;
+    ban.m_start_time = 100;
+    ban.m_expired_time = -1;
+    index.addIPBan(0x0A000000, 0x0AFFFFFF, ban);
+    ban.m_row_id = 2;
+    index.addIPBan(0x0A010000, 0x0A0100FF, ban);
+    ban.m_row_id = 3;
+    ban.m_expired_time = 200;
+    index.addIPBan(0xC0A80001, 0xC0A80001, ban);
+    ban.m_row_id = 4;
+    ban.m_start_time = 300;
+    ban.m_expired_time = -1;
+    index.addOnlineIdBan(42, ban);
+
+    // Nothing is active before the start time
+    assert(index.findIPBan(0x0A000001, 100) == NULL);
+    assert(index.findIPBan(0x0A000001, 150)->m_row_id == 1);
+    // Any range containing the IP can be returned, like the ban query
+    // without order did
+    assert(index.findIPBan(0x0A010010, 150)->m_row_id == 1);
+    // The end of the first range is reached through the running maximum
+    assert(index.findIPBan(0x0AFFFFFF, 150)->m_row_id == 1);
+    assert(index.findIPBan(0x0B000000, 150) == NULL);
+    assert(index.findIPBan(0x09FFFFFF, 150) == NULL);
+    assert(index.findIPBan(0xC0A80001, 150)->m_row_id == 3);
+    assert(index.findIPBan(0xC0A80002, 150) == NULL);
+    assert(index.findOnlineIdBan(42, 150) == NULL);
+
+    // The third ban expires and the online id ban starts
+    assert(index.findIPBan(0xC0A80001, 200) == NULL);
+    assert(index.findOnlineIdBan(42, 301)->m_row_id == 4);
+    assert(index.findOnlineIdBan(43, 301) == NULL);
+
+    // A copy is updated without changing the original
+    BanIndex copy;
+    copy.copyBans(index);
+    copy.removeIPBan(1);
+    copy.removeOnlineIdBan(4);
+    assert(copy.findIPBan(0x0A000001, 150) == NULL);
+    assert(copy.findIPBan(0x0A010010, 150)->m_row_id == 2);
+    assert(copy.findOnlineIdBan(42, 301) == NULL);
+    assert(index.findIPBan(0x0A000001, 150)->m_row_id == 1);
+    assert(index.findOnlineIdBan(42, 301)->m_row_id == 4);
+    // A changed ban is removed and added again
+    ban.m_row_id = 2;
+    ban.m_start_time = 100;
+    ban.m_expired_time = 120;
+    copy.removeIPBan(2);
+    copy.addIPBan(0x0A010000, 0x0A0100FF, ban);
+    assert(copy.findIPBan(0x0A010010, 110)->m_row_id == 2);
+    assert(copy.findIPBan(0x0A010010, 150) == NULL);
+
+    index.clear();
+    assert(index.findIPBan(0x0A000001, 150) == NULL);
+
+    // Many small ranges inside and after a large one
+    ban.m_start_time = 100;
+    ban.m_expired_time = -1;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        ban.m_row_id = 10 + i;
+        index.addIPBan(0x0A000000 + i * 16, 0x0A000000 + i * 16 + 3, ban);
+        index.addIPBan(0x0B000000 + i * 16, 0x0B000000 + i * 16 + 3, ban);
+    }
+    assert(index.findIPBan(0x0A0000F8, 150) == NULL);
+    ban.m_row_id = 5;
+    index.addIPBan(0x0A000000, 0x0AFFFFFF, ban);
+    assert(index.findIPBan(0x0A0000F8, 150)->m_row_id == 5);
+    assert(index.findIPBan(0x0A000011, 150) != NULL);
+    assert(index.findIPBan(0x0B000011, 150)->m_row_id == 11);
+    assert(index.findIPBan(0x0B000014, 150) == NULL);
+    assert(index.findIPBan(0x0C000000, 150) == NULL);
+}   // unitTesting
@@ -0,0 +1,99 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_BAN_INDEX_HPP
+#define HEADER_BAN_INDEX_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** An in-memory copy of the IP and online id ban tables of the server
+ *  database, so a connecting player can be checked without a query. The
+ *  server fills it from the database once, then copies it and updates only
+ *  the bans which were changed in the tables. Only the
+ *  bans active at a given time are searched: IP ranges are kept sorted by
+ *  their start together with the running maximum of their end, so a lookup
+ *  is a binary search; online ids are kept in a hash map. The active bans
+ *  are selected again when a ban starts or expires.
+ *  \ingroup network
+ */
+class BanIndex : public NoCopy
+{
+public:
+    /** One entry of a ban table. */
+    struct Ban
+    {
+        int m_row_id;
+        std::string m_reason;
+        std::string m_description;
+        /** Seconds since 1.1.1970 when the ban starts. */
+        int64_t m_start_time;
+        /** Seconds since 1.1.1970 when the ban expires, -1 if never. */
+        int64_t m_expired_time;
+    };
+
+private:
+    struct IPBan
+    {
+        uint32_t m_ip_start;
+        uint32_t m_ip_end;
+        Ban m_ban;
+    };
+
+    std::vector<IPBan> m_all_ip_bans;
+
+    std::vector<std::pair<uint32_t, Ban> > m_all_online_id_bans;
+
+    /** The active IP bans sorted by m_ip_start. */
+    std::vector<const IPBan*> m_ip_bans;
+
+    /** For each entry in m_ip_bans, the highest m_ip_end of it and all
+     *  previous entries. */
+    std::vector<uint32_t> m_max_ip_end;
+
+    /** The active online id bans. */
+    std::unordered_map<uint32_t, const Ban*> m_online_id_bans;
+
+    /** Time at which the active bans were selected. */
+    int64_t m_update_time;
+
+    /** Time at which the next ban starts or expires, -1 if none does. */
+    int64_t m_next_change_time;
+
+    static bool isActive(const Ban& ban, int64_t now);
+    void selectActiveBans(int64_t now);
+    void checkChanges(int64_t now);
+
+public:
+    BanIndex();
+    void clear();
+    void addIPBan(uint32_t ip_start, uint32_t ip_end, const Ban& ban);
+    void addOnlineIdBan(uint32_t online_id, const Ban& ban);
+    void copyBans(const BanIndex& other);
+    void removeIPBan(int row_id);
+    void removeOnlineIdBan(int row_id);
+    const Ban* findIPBan(uint32_t ip, int64_t now);
+    const Ban* findOnlineIdBan(uint32_t online_id, int64_t now);
+    static void unitTesting();
+};   // class BanIndex
+
+#endif
@@ -84,6 +84,22 @@ namespace CompressNetworkBody
             .addUInt16(avx).addUInt16(avy).addUInt16(avz);
     }   // compress
     // ------------------------------------------------------------------------
+    /** Writes the same data as compress, but without rounding the values of
+     *  the body itself, e.g. to save a state for comparison only.
+     */
+    inline void write(const btRigidBody* body, BareNetworkString* bns)
+    {
+        const btTransform& t = body->getWorldTransform();
+        const btVector3& lv = body->getLinearVelocity();
+        const btVector3& av = body->getAngularVelocity();
+        bns->addFloat(t.getOrigin().x()).addFloat(t.getOrigin().y())
+            .addFloat(t.getOrigin().z())
+            .addUInt32(compressQuaternion(t.getRotation()));
+        bns->addUInt16(toFloat16(lv.x())).addUInt16(toFloat16(lv.y()))
+            .addUInt16(toFloat16(lv.z())).addUInt16(toFloat16(av.x()))
+            .addUInt16(toFloat16(av.y())).addUInt16(toFloat16(av.z()));
+    }   // write
+    // ------------------------------------------------------------------------
     /* Called during rewind when restoring data from game state. */
     inline void decompress(const BareNetworkString* bns,
                            btRigidBody* body, btMotionState* ms)
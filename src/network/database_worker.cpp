@@ -0,0 +1,256 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifdef ENABLE_SQLITE3
+
+#include "network/database_worker.hpp"
+
+#include "network/server_metrics.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+#include "utils/vs.hpp"
+
+#include <vector>
+
+/** Queries with values formatted into them are all different, so only this
+ *  many prepared statements are kept. */
+static const size_t MAX_CACHED_STATEMENTS = 64;
+
+// ----------------------------------------------------------------------------
+/** Opens the database and starts the database thread. If the database
+ *  cannot be opened, all queries fail.
+ *  \param filename The database file.
+ */
+DatabaseWorker::DatabaseWorker(const std::string& filename)
+{
+    m_db = NULL;
+    // Only the database thread uses this connection. Use a private cache, so
+    // the lobby connection waits for locks in its busy handler instead of
+    // failing with SQLITE_LOCKED on a shared cache
+    int ret = sqlite3_open_v2(filename.c_str(), &m_db,
+        SQLITE_OPEN_PRIVATECACHE | SQLITE_OPEN_NOMUTEX |
+        SQLITE_OPEN_READWRITE, NULL);
+    if (ret != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker", "Cannot open database: %s.",
+            sqlite3_errmsg(m_db));
+        sqlite3_close(m_db);
+        m_db = NULL;
+    }
+    else
+    {
+        sqlite3_busy_timeout(m_db, 1000);
+        // With write-ahead logging the reads of the lobby are not blocked
+        // by the transactions of this thread
+        if (sqlite3_exec(m_db, "PRAGMA journal_mode=WAL;", NULL, NULL,
+            NULL) != SQLITE_OK)
+        {
+            Log::warn("DatabaseWorker", "Cannot enable write-ahead "
+                "logging: %s.", sqlite3_errmsg(m_db));
+        }
+    }
+    m_running_queries = 0;
+    m_exit = false;
+    m_thread = std::thread(std::bind(&DatabaseWorker::mainLoop, this));
+}   // DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Executes all remaining queries, then stops the database thread and frees
+ *  the prepared statements.
+ */
+DatabaseWorker::~DatabaseWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queries_mutex);
+        m_exit = true;
+    }
+    m_queries_cv.notify_all();
+    m_thread.join();
+    for (auto& statement : m_statements)
+        sqlite3_finalize(statement.second);
+    if (m_db)
+        sqlite3_close(m_db);
+}   // ~DatabaseWorker
+
+// ----------------------------------------------------------------------------
+/** Adds a query to be executed by the database thread.
+ *  \param query The SQL query, using ? for values bound by bind_function.
+ *  \param bind_function Optional function to bind values, it must not use
+ *         data which can be freed before the query is executed.
+ *  \param done_function Optional function called after the query is done
+ *         (and committed), in the database thread.
+ *  \param row_function Optional function called for each returned row, in
+ *         the database thread.
+ */
+void DatabaseWorker::addQuery(const std::string& query,
+                              BindFunction bind_function,
+                              DoneFunction done_function,
+                              RowFunction row_function)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queries_mutex);
+        Query q;
+        q.m_query = query;
+        q.m_bind_function = bind_function;
+        q.m_row_function = row_function;
+        q.m_done_function = done_function;
+        m_queries.push_back(std::move(q));
+    }
+    m_queries_cv.notify_all();
+}   // addQuery
+
+// ----------------------------------------------------------------------------
+/** Waits until all queries added so far are executed.
+ */
+void DatabaseWorker::flush()
+{
+    std::unique_lock<std::mutex> ul(m_queries_mutex);
+    m_queries_cv.wait(ul, [this]()
+        {
+            return m_queries.empty() && m_running_queries == 0;
+        });
+}   // flush
+
+// ----------------------------------------------------------------------------
+/** The database thread, which executes all waiting queries in one
+ *  transaction until it is told to exit and no query is left.
+ */
+void DatabaseWorker::mainLoop()
+{
+    VS::setThreadName("DatabaseWorker");
+    while (true)
+    {
+        std::deque<Query> queries;
+        {
+            std::unique_lock<std::mutex> ul(m_queries_mutex);
+            m_queries_cv.wait(ul, [this]()
+                {
+                    return m_exit || !m_queries.empty();
+                });
+            if (m_queries.empty())
+                return;
+            std::swap(queries, m_queries);
+            m_running_queries = (unsigned)queries.size();
+        }
+
+        const bool transaction = m_db && queries.size() > 1 &&
+            sqlite3_get_autocommit(m_db) != 0;
+        if (transaction &&
+            sqlite3_exec(m_db, "BEGIN;", NULL, NULL, NULL) != SQLITE_OK)
+        {
+            Log::error("DatabaseWorker", "Error starting transaction: %s",
+                sqlite3_errmsg(m_db));
+        }
+
+        std::vector<bool> results;
+        for (Query& q : queries)
+            results.push_back(execute(q));
+
+        if (transaction &&
+            sqlite3_exec(m_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK)
+        {
+            Log::error("DatabaseWorker", "Error committing %d queries: %s",
+                (int)queries.size(), sqlite3_errmsg(m_db));
+            sqlite3_exec(m_db, "ROLLBACK;", NULL, NULL, NULL);
+            results.assign(results.size(), false);
+        }
+
+        for (unsigned i = 0; i < queries.size(); i++)
+        {
+            if (queries[i].m_done_function)
+                queries[i].m_done_function(results[i]);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_queries_mutex);
+            m_running_queries = 0;
+        }
+        m_queries_cv.notify_all();
+    }
+}   // mainLoop
+
+// ----------------------------------------------------------------------------
+/** Returns the prepared statement of a query, from the cache if possible.
+ *  Returns NULL if the query cannot be prepared.
+ */
+sqlite3_stmt* DatabaseWorker::getStatement(const std::string& query)
+{
+    if (!m_db)
+        return NULL;
+    auto it = m_statements.find(query);
+    if (it != m_statements.end())
+        return it->second;
+
+    sqlite3_stmt* stmt = NULL;
+    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
+    if (ret != SQLITE_OK)
+    {
+        Log::error("DatabaseWorker",
+            "Error preparing database for query %s: %s",
+            query.c_str(), sqlite3_errmsg(m_db));
+        sqlite3_finalize(stmt);
+        return NULL;
+    }
+    if (m_statements.size() >= MAX_CACHED_STATEMENTS)
+    {
+        // Drop an arbitrary statement, queries run often use bound values
+        // so they are usually added again soon
+        sqlite3_finalize(m_statements.begin()->second);
+        m_statements.erase(m_statements.begin());
+    }
+    m_statements[query] = stmt;
+    return stmt;
+}   // getStatement
+
+// ----------------------------------------------------------------------------
+/** Executes a query in the database thread.
+ *  \return True if no error occurred.
+ */
+bool DatabaseWorker::execute(Query& query)
+{
+    const uint64_t start_time = StkTime::getMonoTimeUs();
+    sqlite3_stmt* stmt = getStatement(query.m_query);
+    if (!stmt)
+    {
+        ServerMetrics::get()->addDatabaseQuery(0, false);
+        return false;
+    }
+    if (query.m_bind_function)
+        query.m_bind_function(stmt);
+
+    int ret = sqlite3_step(stmt);
+    while (ret == SQLITE_ROW)
+    {
+        if (query.m_row_function)
+            query.m_row_function(stmt);
+        ret = sqlite3_step(stmt);
+    }
+    const bool ok = ret == SQLITE_DONE;
+    if (!ok)
+    {
+        Log::error("DatabaseWorker", "Error executing query %s: %s",
+            query.m_query.c_str(), sqlite3_errmsg(m_db));
+    }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    ServerMetrics::get()->addDatabaseQuery(
+        StkTime::getMonoTimeUs() - start_time, ok);
+    return ok;
+}   // execute
+
+#endif
@@ -0,0 +1,118 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_DATABASE_WORKER_HPP
+#define HEADER_DATABASE_WORKER_HPP
+
+#ifdef ENABLE_SQLITE3
+
+#include "utils/no_copy.hpp"
+
+#include <sqlite3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/** Runs sqlite queries of the server in a separate thread, so that a slow
+ *  disk or large tables do not stall the lobby. Queries are executed in the
+ *  order they were added. All queries waiting when the thread wakes up are
+ *  executed in one transaction, which makes many small inserts and updates
+ *  much cheaper. Prepared statements are cached by query string, so queries
+ *  which are run often should use bound parameters instead of formatting
+ *  values into the query.
+ *  \ingroup network
+ */
+class DatabaseWorker : public NoCopy
+{
+public:
+    /** Binds the parameters of a prepared statement, called in the database
+     *  thread. */
+    typedef std::function<void(sqlite3_stmt* stmt)> BindFunction;
+
+    /** Called in the database thread for each row returned by a query. */
+    typedef std::function<void(sqlite3_stmt* stmt)> RowFunction;
+
+    /** Called in the database thread when a query is finished, with true if
+     *  no error occurred. */
+    typedef std::function<void(bool)> DoneFunction;
+
+private:
+    struct Query
+    {
+        std::string  m_query;
+        BindFunction m_bind_function;
+        RowFunction  m_row_function;
+        DoneFunction m_done_function;
+    };   // struct Query
+
+    /** The own connection of the database thread to the database. The lobby
+     *  uses a separate connection for queries which need an answer at once,
+     *  so these are neither part of the transactions of this thread nor
+     *  wait for its busy handler. */
+    sqlite3* m_db;
+
+    /** Protects m_queries and m_exit. */
+    std::mutex m_queries_mutex;
+
+    /** Signals the database thread that there are new queries, and waiting
+     *  threads that all queries are finished. */
+    std::condition_variable m_queries_cv;
+
+    std::deque<Query> m_queries;
+
+    /** Number of queries taken by the database thread but not finished. */
+    unsigned m_running_queries;
+
+    bool m_exit;
+
+    /** Prepared statements by query string, only used by the database
+     *  thread. */
+    std::map<std::string, sqlite3_stmt*> m_statements;
+
+    std::thread m_thread;
+
+    void mainLoop();
+    bool execute(Query& query);
+    sqlite3_stmt* getStatement(const std::string& query);
+
+public:
+    DatabaseWorker(const std::string& filename);
+    ~DatabaseWorker();
+    void addQuery(const std::string& query,
+                  BindFunction bind_function = nullptr,
+                  DoneFunction done_function = nullptr,
+                  RowFunction row_function = nullptr);
+    void flush();
+    // ------------------------------------------------------------------------
+    /** Returns the number of queries which are not finished yet. */
+    size_t getPendingQueries()
+    {
+        std::lock_guard<std::mutex> lock(m_queries_mutex);
+        return m_queries.size() + m_running_queries;
+    }   // getPendingQueries
+
+};   // class DatabaseWorker
+
+#endif
+
+#endif
@@ -21,11 +21,47 @@
 #include "network/crypto.hpp"
 #include "network/protocols/client_lobby.hpp"
 #include "network/stk_peer.hpp"
+#include "utils/lock_free_queue.hpp"
 #include "utils/log.hpp"
 #include "utils/time.hpp"
 
 #include <string.h>
 
+// ============================================================================
+/** Returns the pool of freed event memory. An event is created for each
+ *  packet by the network thread and deleted by a different thread, so the
+ *  pool is a lock-free queue. It is never freed, so events can still be
+ *  deleted during static destruction. */
+static LockFreeQueue<void*>* getEventPool()
+{
+    static LockFreeQueue<void*>* pool = new LockFreeQueue<void*>(1024);
+    return pool;
+}   // getEventPool
+
+// ============================================================================
+/** Allocates memory for an event, reusing memory of a deleted event if
+ *  possible.
+ */
+void* Event::operator new(size_t size)
+{
+    void* ptr = NULL;
+    if (size == sizeof(Event) && getEventPool()->pop(&ptr))
+        return ptr;
+    return ::operator new(size);
+}   // operator new
+
+// ============================================================================
+/** Puts the memory of a deleted event back into the pool, or frees it if the
+ *  pool is full.
+ */
+void Event::operator delete(void* ptr)
+{
+    if (ptr == NULL)
+        return;
+    if (!getEventPool()->push(ptr))
+        ::operator delete(ptr);
+}   // operator delete
+
 /** \brief Constructor
  *  \param event : The event that needs to be translated.
  */
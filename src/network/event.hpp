@@ -92,6 +92,8 @@ private:
 public:
          Event(ENetEvent* event, std::shared_ptr<STKPeer> peer);
         ~Event();
+    static void* operator new(size_t size);
+    static void  operator delete(void* ptr);
 
     // ------------------------------------------------------------------------
     /** Returns the type of this event. */
@@ -19,6 +19,7 @@
 #include "network/network_config.hpp"
 #include "network/network_player_profile.hpp"
 #include "network/server_config.hpp"
+#include "network/server_metrics.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
 #include "network/protocols/server_lobby.hpp"
@@ -43,6 +44,8 @@ void showHelp()
     std::cout << "listpeers, List all peers with host ID and IP." << std::endl;
     std::cout << "listban, List IP ban list of server." << std::endl;
     std::cout << "speedstats, Show upload and download speed." << std::endl;
+    std::cout << "metrics, Show server metrics in Prometheus text format."
+        << std::endl;
 }   // showHelp
 
 // ----------------------------------------------------------------------------
@@ -122,6 +125,10 @@ void mainLoop(STKHost* host)
                 "   Download speed (KBps): " <<
                 (float)host->getDownloadSpeed() / 1024.0f  << std::endl;
         }
+        else if (str == "metrics")
+        {
+            std::cout << ServerMetrics::get()->getText(host->getPeers());
+        }
         else
         {
             std::cout << "Unknown command: " << str << std::endl;
@@ -0,0 +1,235 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/network_simulator.hpp"
+
+#include "network/server_config.hpp"
+#include "utils/log.hpp"
+#include "utils/time.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+int   NetworkSimulator::m_cmd_latency   = -1;
+int   NetworkSimulator::m_cmd_jitter    = -1;
+float NetworkSimulator::m_cmd_loss      = -1.0f;
+float NetworkSimulator::m_cmd_reorder   = -1.0f;
+int   NetworkSimulator::m_cmd_bandwidth = -1;
+
+namespace
+{
+    /** The first two bytes of a valid ENet packet are never 0xFFFF. */
+    const uint8_t WAKE_UP[] = { 0xFF, 0xFF, 's', 't', 'k', '-', 's', 'i',
+                                'm' };
+
+    /** Datagrams received while this many are queued are dropped. */
+    const unsigned MAX_QUEUED = 1000;
+
+    /** The intercept callback of ENet has no user data, so the simulator
+     *  of each host is found here. */
+    std::mutex g_simulators_mutex;
+    std::map<ENetHost*, NetworkSimulator*> g_simulators;
+
+    /** Returns the command line value if set, otherwise the server config
+     *  value. */
+    template<typename T, typename P> T getSetting(T cmd, P& param)
+    {
+        return cmd >= 0 ? cmd : (T)param;
+    }   // getSetting
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Returns if any network condition is to be simulated. */
+bool NetworkSimulator::isEnabled()
+{
+    return getSetting(m_cmd_latency, ServerConfig::m_simulated_latency) > 0 ||
+        getSetting(m_cmd_jitter, ServerConfig::m_simulated_jitter) > 0 ||
+        getSetting(m_cmd_loss, ServerConfig::m_simulated_loss) > 0.0f ||
+        getSetting(m_cmd_reorder, ServerConfig::m_simulated_reorder) > 0.0f ||
+        getSetting(m_cmd_bandwidth, ServerConfig::m_simulated_bandwidth) > 0;
+}   // isEnabled
+
+// ----------------------------------------------------------------------------
+/** Starts simulating the network conditions for the packets received by the
+ *  given host.
+ */
+NetworkSimulator::NetworkSimulator(ENetHost* host)
+                : m_random(1)
+{
+    m_host = host;
+    m_wake_ups_pending = 0;
+    m_last_wake_up_time = 0;
+    m_latency = getSetting(m_cmd_latency, ServerConfig::m_simulated_latency);
+    m_jitter = getSetting(m_cmd_jitter, ServerConfig::m_simulated_jitter);
+    m_loss = getSetting(m_cmd_loss, ServerConfig::m_simulated_loss);
+    m_reorder = getSetting(m_cmd_reorder, ServerConfig::m_simulated_reorder);
+    m_bandwidth = getSetting(m_cmd_bandwidth,
+        ServerConfig::m_simulated_bandwidth);
+
+    // Send the wake up datagrams to the address the socket is bound to.
+    // A socket bound to all interfaces is reached through the loopback
+    // interface, which is what the datagrams arrive from then.
+    if (enet_socket_get_address(m_host->socket, &m_self_address) != 0)
+    {
+        Log::error("NetworkSimulator", "Can't get the address of the "
+            "socket, queued packets are only received with other packets.");
+        m_self_address = m_host->address;
+    }
+    if (m_self_address.host == ENET_HOST_ANY)
+        m_self_address.host = ENET_HOST_TO_NET_32(0x7F000001);
+
+    {
+        std::lock_guard<std::mutex> lock(g_simulators_mutex);
+        g_simulators[m_host] = this;
+    }
+    m_host->intercept = NetworkSimulator::interceptCallback;
+    Log::warn("NetworkSimulator", "Simulating latency %dms, jitter %dms, "
+        "loss %.1f%%, reorder %.1f%%, bandwidth %dkbit/s for packets "
+        "received on port %d.", m_latency, m_jitter, m_loss, m_reorder,
+        m_bandwidth, m_self_address.port);
+}   // NetworkSimulator
+
+// ----------------------------------------------------------------------------
+NetworkSimulator::~NetworkSimulator()
+{
+    m_host->intercept = NULL;
+    std::lock_guard<std::mutex> lock(g_simulators_mutex);
+    g_simulators.erase(m_host);
+}   // ~NetworkSimulator
+
+// ----------------------------------------------------------------------------
+int NetworkSimulator::interceptCallback(ENetHost* host, ENetEvent* event)
+{
+    NetworkSimulator* ns = NULL;
+    {
+        std::lock_guard<std::mutex> lock(g_simulators_mutex);
+        auto it = g_simulators.find(host);
+        if (it != g_simulators.end())
+            ns = it->second;
+    }
+    // 0 means let enet handle this packet
+    return ns ? ns->intercept() : 0;
+}   // interceptCallback
+
+// ----------------------------------------------------------------------------
+/** Returns the simulated arrival time of a datagram of the given size from
+ *  the sender of the datagram being received.
+ *  \param now Current time in microseconds.
+ */
+uint64_t NetworkSimulator::getArrivalTime(uint64_t now)
+{
+    uint64_t arrival = now;
+    if (m_bandwidth > 0)
+    {
+        const ENetAddress& a = m_host->receivedAddress;
+        uint64_t& link_free = m_link_free_time[std::make_pair(a.host, a.port)];
+        link_free = std::max(link_free, now) +
+            (uint64_t)m_host->receivedDataLength * 8000 / m_bandwidth;
+        arrival = link_free;
+    }
+
+    std::uniform_real_distribution<float> percent(0.0f, 100.0f);
+    if (m_reorder > 0.0f && percent(m_random) < m_reorder)
+        return arrival;
+
+    int delay = m_latency;
+    if (m_jitter > 0)
+    {
+        std::uniform_int_distribution<int> jitter(-m_jitter, m_jitter);
+        delay += jitter(m_random);
+    }
+    if (delay > 0)
+        arrival += (uint64_t)delay * 1000;
+    return arrival;
+}   // getArrivalTime
+
+// ----------------------------------------------------------------------------
+/** Called by ENet for each received datagram. Replaces a wake up datagram
+ *  with the next queued datagram which has arrived, and queues or drops all
+ *  other datagrams.
+ *  \return 0 if ENet should handle the (replaced) datagram, 1 if it should
+ *          ignore it.
+ */
+int NetworkSimulator::intercept()
+{
+    const uint8_t* data = m_host->receivedData;
+    const size_t length = m_host->receivedDataLength;
+    const uint64_t now = StkTime::getMonoTimeUs();
+    if (length == sizeof(WAKE_UP) &&
+        memcmp(data, WAKE_UP, sizeof(WAKE_UP)) == 0 &&
+        m_host->receivedAddress.host == m_self_address.host &&
+        m_host->receivedAddress.port == m_self_address.port)
+    {
+        if (m_wake_ups_pending > 0)
+            m_wake_ups_pending--;
+        auto it = m_queue.begin();
+        if (it == m_queue.end() || it->first > now)
+            return 1;
+        m_current = std::move(it->second);
+        m_queue.erase(it);
+        m_host->receivedAddress = m_current.m_address;
+        m_host->receivedData = m_current.m_data.data();
+        m_host->receivedDataLength = m_current.m_data.size();
+        return 0;
+    }
+
+    std::uniform_real_distribution<float> percent(0.0f, 100.0f);
+    if (m_loss > 0.0f && percent(m_random) < m_loss)
+        return 1;
+    if (m_queue.size() >= MAX_QUEUED)
+        return 1;
+
+    const uint64_t arrival = getArrivalTime(now);
+    if (arrival <= now && m_queue.empty())
+        return 0;
+
+    Datagram d;
+    d.m_address = m_host->receivedAddress;
+    d.m_data.assign(data, data + length);
+    m_queue.emplace(arrival, std::move(d));
+    return 1;
+}   // intercept
+
+// ----------------------------------------------------------------------------
+/** Sends a wake up datagram to the host for each queued datagram which has
+ *  arrived, so ENet receives them in the next service call.
+ */
+void NetworkSimulator::update()
+{
+    const uint64_t now = StkTime::getMonoTimeUs();
+    // Don't stop the queue if a wake up datagram was lost
+    if (m_wake_ups_pending > 0 && now - m_last_wake_up_time > 100000)
+        m_wake_ups_pending = 0;
+
+    unsigned arrived = 0;
+    for (auto it = m_queue.begin(); it != m_queue.end() && it->first <= now;
+         it++)
+        arrived++;
+
+    ENetBuffer buffer;
+    buffer.data = (void*)WAKE_UP;
+    buffer.dataLength = sizeof(WAKE_UP);
+    while (m_wake_ups_pending < arrived)
+    {
+        if (enet_socket_send(m_host->socket, &m_self_address, &buffer, 1) <= 0)
+            break;
+        m_wake_ups_pending++;
+        m_last_wake_up_time = now;
+    }
+}   // update
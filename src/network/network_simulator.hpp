@@ -0,0 +1,100 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_NETWORK_SIMULATOR_HPP
+#define HEADER_NETWORK_SIMULATOR_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <enet/enet.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+/** Simulates a bad connection for testing, by adding latency, jitter, loss,
+ *  reordering and a bandwidth limit to the packets received by an ENet host.
+ *  It uses the intercept callback of ENet: each received datagram is either
+ *  dropped or queued until its simulated arrival time. To hand a queued
+ *  datagram back to ENet, a small wake up datagram is sent to the host
+ *  itself, and the intercept replaces it with the queued one. The simulator
+ *  must only be used from the thread servicing the ENet host.
+ *  \ingroup network
+ */
+class NetworkSimulator : public NoCopy
+{
+private:
+    struct Datagram
+    {
+        ENetAddress m_address;
+        std::vector<uint8_t> m_data;
+    };
+
+    ENetHost* m_host;
+
+    /** Address the socket of the host is bound to, which the wake up
+     *  datagrams are sent to and received from. */
+    ENetAddress m_self_address;
+
+    /** Datagrams waiting for their arrival time in microseconds. */
+    std::multimap<uint64_t, Datagram> m_queue;
+
+    /** For each sender, the time at which the simulated link is free again
+     *  for the bandwidth limit. */
+    std::map<std::pair<uint32_t, uint16_t>, uint64_t> m_link_free_time;
+
+    /** The datagram currently given to ENet, which reads it after the
+     *  intercept callback returns. */
+    Datagram m_current;
+
+    /** Number of wake up datagrams sent but not received yet. */
+    unsigned m_wake_ups_pending;
+
+    uint64_t m_last_wake_up_time;
+
+    /** Fixed seed, so the same traffic gives the same drops. */
+    std::mt19937 m_random;
+
+    int m_latency;
+    int m_jitter;
+    float m_loss;
+    float m_reorder;
+    int m_bandwidth;
+
+    static int interceptCallback(ENetHost* host, ENetEvent* event);
+    int intercept();
+    uint64_t getArrivalTime(uint64_t now);
+
+public:
+    /** Settings from the command line, which override the server config if
+     *  not negative. */
+    static int m_cmd_latency;
+    static int m_cmd_jitter;
+    static float m_cmd_loss;
+    static float m_cmd_reorder;
+    static int m_cmd_bandwidth;
+
+    static bool isEnabled();
+    NetworkSimulator(ENetHost* host);
+    ~NetworkSimulator();
+    void update();
+};   // class NetworkSimulator
+
+#endif
@@ -17,12 +17,57 @@
 
 #include "network/network_string.hpp"
 
+#include "utils/lock_free_queue.hpp"
 #include "utils/string_utils.hpp"
 
 #include <algorithm>   // for std::min
 #include <iomanip>
 #include <ostream>
 
+// ============================================================================
+/** Buffers of deleted strings are kept in this pool up to this size, larger
+ *  buffers (e.g. from a replay or a full items state) are freed. */
+const size_t MAX_POOLED_BUFFER_CAPACITY = 16 * 1024;
+
+// ----------------------------------------------------------------------------
+/** Returns the pool of unused string buffers. Strings are created and
+ *  deleted in several threads (main, ProtocolManager and network), so a
+ *  lock-free queue is used. It is never freed, so strings can still be
+ *  deleted during static destruction. */
+static LockFreeQueue<std::vector<uint8_t> >* getBufferPool()
+{
+    static LockFreeQueue<std::vector<uint8_t> >* pool =
+        new LockFreeQueue<std::vector<uint8_t> >(256);
+    return pool;
+}   // getBufferPool
+
+// ----------------------------------------------------------------------------
+/** Takes a buffer from the pool (if one is available) and makes sure it can
+ *  hold at least capacity bytes.
+ *  \param buffer The empty buffer of a new string.
+ *  \param capacity Number of bytes to reserve.
+ */
+void BareNetworkString::acquireBuffer(std::vector<uint8_t>* buffer,
+                                      int capacity)
+{
+    getBufferPool()->pop(buffer);
+    if (capacity > 0)
+        buffer->reserve(capacity);
+}   // acquireBuffer
+
+// ----------------------------------------------------------------------------
+/** Puts the buffer of a deleted string into the pool, it is kept allocated
+ *  for the next string.
+ */
+void BareNetworkString::releaseBuffer(std::vector<uint8_t>* buffer)
+{
+    if (buffer->capacity() == 0 ||
+        buffer->capacity() > MAX_POOLED_BUFFER_CAPACITY)
+        return;
+    buffer->clear();
+    getBufferPool()->push(std::move(*buffer));
+}   // releaseBuffer
+
 // ============================================================================
 /** Unit testing function.
  */
@@ -57,6 +102,16 @@ void NetworkString::unitTesting()
     std::string log = slog.getLogMessage();
     assert(log=="0x000 | 00 01 02 03 04 05 06 07  08 09 0a 0b 0c 0d 0e 0f   | ................\n"
                 "0x010 | 10 11 12 13 14 15 16 17  18 19 1a 1b               | ............\n");
+
+    // Buffers taken from the pool must be empty
+    for (unsigned int i = 0; i < 300; i++)
+    {
+        BareNetworkString* used = new BareNetworkString(32);
+        used->addUInt32(i);
+        delete used;
+        BareNetworkString reused(32);
+        assert(reused.size() == 0 && reused.getTotalSize() == 0);
+    }
 }   // unitTesting
 
 // ============================================================================
@@ -118,18 +118,23 @@ protected:
         return m_buffer.at(m_current_offset++);
     }   // get
 
+    // ------------------------------------------------------------------------
+    static void acquireBuffer(std::vector<uint8_t>* buffer, int capacity);
+    static void releaseBuffer(std::vector<uint8_t>* buffer);
+
 public:
 
     /** Constructor, sets the protocol type of this message. */
     BareNetworkString(int capacity=16)
     {
-        m_buffer.reserve(capacity);
+        acquireBuffer(&m_buffer, capacity);
         m_current_offset = 0;
     }   // BareNetworkString
 
     // ------------------------------------------------------------------------
     BareNetworkString(const std::string &s)
     {
+        acquireBuffer(&m_buffer, (int)s.size() + 1);
         m_current_offset = 0;
         encodeString(s);
     }   // BareNetworkString
@@ -137,10 +142,23 @@ public:
     /** Initialises the string with a sequence of characters. */
     BareNetworkString(const char *data, int len)
     {
+        acquireBuffer(&m_buffer, len);
         m_current_offset = 0;
         m_buffer.resize(len);
         memcpy(m_buffer.data(), data, len);
     }   // BareNetworkString
+    // ------------------------------------------------------------------------
+    BareNetworkString(const BareNetworkString&) = default;
+    // ------------------------------------------------------------------------
+    BareNetworkString(BareNetworkString&&) = default;
+    // ------------------------------------------------------------------------
+    BareNetworkString& operator=(const BareNetworkString&) = default;
+    // ------------------------------------------------------------------------
+    BareNetworkString& operator=(BareNetworkString&&) = default;
+    // ------------------------------------------------------------------------
+    /** Gives the buffer back to the pool, so the next string can be created
+     *  without allocating memory. */
+    ~BareNetworkString()                         { releaseBuffer(&m_buffer); }
 
     // ------------------------------------------------------------------------
     /** Allows to read a buffer from the beginning again. */
@@ -31,8 +31,11 @@
 #include <algorithm>
 #include <assert.h>
 #include <cstdlib>
+#include <cstring>
 #include <errno.h>
 #include <functional>
+#include <iterator>
+#include <thread>
 #include <typeinfo>
 
 // ============================================================================
@@ -112,20 +115,6 @@ ProtocolManager::~ProtocolManager()
         m_all_protocols[i].abort();
     }
 
-    m_sync_events_to_process.lock();
-    for (EventList::iterator i =m_sync_events_to_process.getData().begin();
-                             i!=m_sync_events_to_process.getData().end(); ++i)
-        delete *i;
-    m_sync_events_to_process.getData().clear();
-    m_sync_events_to_process.unlock();
-
-    m_async_events_to_process.lock();
-    for (EventList::iterator i = m_async_events_to_process.getData().begin();
-                             i!= m_async_events_to_process.getData().end(); ++i)
-        delete *i;
-    m_async_events_to_process.getData().clear();
-    m_async_events_to_process.unlock();
-
     for (EventList::iterator i = m_controller_events_list.begin();
                              i!= m_controller_events_list.end(); ++i)
         delete *i;
@@ -137,6 +126,108 @@ ProtocolManager::~ProtocolManager()
 
 }   // ~ProtocolManager
 
+// ----------------------------------------------------------------------------
+// ----------------------------------------------------------------------------
+ProtocolManager::EventQueue::EventQueue() : m_ring(1024)
+{
+    m_use_overflow.store(false);
+    m_overflow_size.store(0);
+    m_pending_size.store(0);
+    m_events_count.store(0);
+    m_total_wait_ms.store(0);
+    m_max_wait_ms.store(0);
+}   // EventQueue
+
+// ----------------------------------------------------------------------------
+/** Deletes all events still in the queue. Only called when no other thread
+ *  is using the queue anymore. */
+ProtocolManager::EventQueue::~EventQueue()
+{
+    fetch();
+    for (Event* event : m_pending)
+        delete event;
+    m_pending.clear();
+}   // ~EventQueue
+
+// ----------------------------------------------------------------------------
+/** Adds an event to the queue, can be called from any thread.
+ *  \param event The event to add.
+ */
+void ProtocolManager::EventQueue::push(Event* event)
+{
+    if (!m_use_overflow.load(std::memory_order_acquire) && m_ring.push(event))
+        return;
+    std::lock_guard<std::mutex> lock(m_overflow_mutex);
+    m_overflow.push_back(event);
+    m_overflow_size.store((uint32_t)m_overflow.size(),
+        std::memory_order_relaxed);
+    m_use_overflow.store(true, std::memory_order_release);
+}   // push
+
+// ----------------------------------------------------------------------------
+/** Moves all newly added events to the end of m_pending, and updates the
+ *  wait time statistics. Must only be called from the consuming thread.
+ */
+void ProtocolManager::EventQueue::fetch()
+{
+    EventList::iterator first_new = m_pending.end();
+    bool has_new = false;
+    auto pop_ring = [this, &first_new, &has_new]()
+    {
+        Event* event = NULL;
+        while (m_ring.pop(&event))
+        {
+            m_pending.push_back(event);
+            if (!has_new)
+            {
+                first_new = std::prev(m_pending.end());
+                has_new = true;
+            }
+        }
+    };
+    pop_ring();
+    if (m_use_overflow.load(std::memory_order_acquire))
+    {
+        // The ring can have filled up again since it was emptied above, and
+        // these events are older than the overflowed ones. No new event is
+        // added to the ring while m_use_overflow is set, so empty it again
+        // with the lock held before the overflowed events are appended.
+        std::lock_guard<std::mutex> lock(m_overflow_mutex);
+        pop_ring();
+        if (!m_overflow.empty())
+        {
+            EventList::iterator first_overflow = m_overflow.begin();
+            m_pending.splice(m_pending.end(), m_overflow);
+            if (!has_new)
+            {
+                first_new = first_overflow;
+                has_new = true;
+            }
+        }
+        m_overflow_size.store(0, std::memory_order_relaxed);
+        m_use_overflow.store(false, std::memory_order_release);
+    }
+    if (!has_new)
+        return;
+
+    const uint64_t now = StkTime::getMonoTimeMs();
+    uint64_t count = 0, total_wait = 0;
+    uint64_t max_wait = m_max_wait_ms.load(std::memory_order_relaxed);
+    for (EventList::iterator i = first_new; i != m_pending.end(); ++i)
+    {
+        uint64_t wait = now > (*i)->getArrivalTime() ?
+            now - (*i)->getArrivalTime() : 0;
+        count++;
+        total_wait += wait;
+        if (wait > max_wait)
+            max_wait = wait;
+    }
+    m_events_count.fetch_add(count, std::memory_order_relaxed);
+    m_total_wait_ms.fetch_add(total_wait, std::memory_order_relaxed);
+    m_max_wait_ms.store(max_wait, std::memory_order_relaxed);
+    updatePendingSize();
+}   // fetch
+
 // ----------------------------------------------------------------------------
 void ProtocolManager::OneProtocolType::abort()
 {
@@ -179,17 +270,9 @@ void ProtocolManager::propagateEvent(Event* event)
         return;
     }
     if (event->isSynchronous())
-    {
-        m_sync_events_to_process.lock();
-        m_sync_events_to_process.getData().push_back(event);
-        m_sync_events_to_process.unlock();
-    }
+        m_sync_events_to_process.push(event);
     else
-    {
-        m_async_events_to_process.lock();
-        m_async_events_to_process.getData().push_back(event);
-        m_async_events_to_process.unlock();
-    }
+        m_async_events_to_process.push(event);
 }   // propagateEvent
 
 // ----------------------------------------------------------------------------
@@ -430,12 +513,12 @@ void ProtocolManager::update(int ticks)
     ul.unlock();
 
     // before updating, notify protocols that they have received events
-    m_sync_events_to_process.lock();
-    EventList::iterator i = m_sync_events_to_process.getData().begin();
+    m_sync_events_to_process.fetch();
+    EventList& sync_events = m_sync_events_to_process.m_pending;
+    EventList::iterator i = sync_events.begin();
 
-    while (i != m_sync_events_to_process.getData().end())
+    while (i != sync_events.end())
     {
-        m_sync_events_to_process.unlock();
         bool can_be_deleted = true;
         try
         {
@@ -448,11 +531,10 @@ void ProtocolManager::update(int ticks)
                 "Synchronous event error from %s: %s", name.c_str(), e.what());
             Log::error("ProtocolManager", (*i)->data().getLogMessage().c_str());
         }
-        m_sync_events_to_process.lock();
         if (can_be_deleted)
         {
             delete *i;
-            i = m_sync_events_to_process.getData().erase(i);
+            i = sync_events.erase(i);
         }
         else
         {
@@ -460,7 +542,7 @@ void ProtocolManager::update(int ticks)
             ++i;
         }
     }
-    m_sync_events_to_process.unlock();
+    m_sync_events_to_process.updatePendingSize();
 
     // Now update all protocols.
     for (unsigned int i = 0; i < all_protocols.size(); i++)
@@ -484,12 +566,11 @@ void ProtocolManager::asynchronousUpdate()
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
     // First deliver asynchronous messages for all protocols
     // =====================================================
-    m_async_events_to_process.lock();
-    EventList::iterator i = m_async_events_to_process.getData().begin();
-    while (i != m_async_events_to_process.getData().end())
+    m_async_events_to_process.fetch();
+    EventList& async_events = m_async_events_to_process.m_pending;
+    EventList::iterator i = async_events.begin();
+    while (i != async_events.end())
     {
-        m_async_events_to_process.unlock();
-
         bool result = true;
         try
         {
@@ -504,11 +585,10 @@ void ProtocolManager::asynchronousUpdate()
                 (*i)->data().getLogMessage().c_str());
         }
 
-        m_async_events_to_process.lock();
         if (result)
         {
             delete *i;
-            i = m_async_events_to_process.getData().erase(i);
+            i = async_events.erase(i);
         }
         else
         {
@@ -517,7 +597,7 @@ void ProtocolManager::asynchronousUpdate()
             ++i;
         }
     }   // while i != m_events_to_process.end()
-    m_async_events_to_process.unlock();
+    m_async_events_to_process.updatePendingSize();
 
     PROFILER_POP_CPU_MARKER();
     PROFILER_PUSH_CPU_MARKER("Message delivery", 255, 0, 0);
@@ -581,3 +661,46 @@ std::shared_ptr<Protocol> ProtocolManager::getProtocol(ProtocolType type)
 
     return opt.getFirstProtocol();
 }   // getProtocol
+
+// ----------------------------------------------------------------------------
+/** Checks that events keep their order when the ring buffer of an event
+ *  queue overflows while the consumer is fetching events.
+ */
+void ProtocolManager::unitTesting()
+{
+    const unsigned count = 200000;
+    EventQueue queue;
+    std::vector<Event*> pushed;
+    pushed.reserve(count);
+    std::thread producer([&queue, &pushed, count]()
+        {
+            ENetEvent enet_event;
+            memset(&enet_event, 0, sizeof(enet_event));
+            enet_event.type = ENET_EVENT_TYPE_CONNECT;
+            for (unsigned i = 0; i < count; i++)
+            {
+                Event* event = new Event(&enet_event, nullptr);
+                pushed.push_back(event);
+                queue.push(event);
+            }
+        });
+    // Fetch slower than the producer pushes, so the ring overflows often
+    unsigned fetched = 0;
+    while (fetched < count)
+    {
+        queue.fetch();
+        fetched = (unsigned)queue.m_pending.size();
+        if (fetched % 7 == 0)
+            StkTime::sleep(1);
+    }
+    producer.join();
+    queue.fetch();
+    assert(queue.m_pending.size() == count);
+    unsigned i = 0;
+    for (Event* event : queue.m_pending)
+    {
+        assert(event == pushed[i]);
+        i++;
+    }
+    (void)i;
+}   // unitTesting
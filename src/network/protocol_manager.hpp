@@ -25,6 +25,7 @@
 
 #include "network/network_string.hpp"
 #include "network/protocol.hpp"
+#include "utils/lock_free_queue.hpp"
 #include "utils/no_copy.hpp"
 #include "utils/singleton.hpp"
 #include "utils/synchronised.hpp"
@@ -190,13 +191,76 @@ private:
     /** A list of network events - messages, disconnect and disconnects. */
     typedef std::list<Event*> EventList;
 
+    /** A queue of incoming network events. The network thread pushes events
+     *  into a bounded lock-free ring buffer, so it never has to wait for the
+     *  thread delivering the events. Only if the ring buffer is full the
+     *  events are stored in a mutex-protected overflow list, and all events
+     *  are then added to the overflow list until the consumer has emptied
+     *  it, so the order of events is kept. Events which could not be
+     *  delivered yet (e.g. protocol not started) are kept in m_pending,
+     *  which is only accessed by the consuming thread. */
+    class EventQueue : public NoCopy
+    {
+    private:
+        LockFreeQueue<Event*> m_ring;
+
+        std::mutex m_overflow_mutex;
+
+        EventList m_overflow;
+
+        /** Set while m_overflow is not empty. */
+        std::atomic_bool m_use_overflow;
+
+        /** Number of events in m_overflow and m_pending, for statistics. */
+        std::atomic<uint32_t> m_overflow_size, m_pending_size;
+
+        /** Number of events taken from the queue, and the sum and maximum
+         *  of the time they have been waiting in it. */
+        std::atomic<uint64_t> m_events_count, m_total_wait_ms, m_max_wait_ms;
+
+    public:
+        /** Events taken from the queue which are not delivered yet. Only
+         *  used by the consuming thread. */
+        EventList m_pending;
+
+        EventQueue();
+        ~EventQueue();
+        void push(Event* event);
+        void fetch();
+        // --------------------------------------------------------------------
+        /** Updates the number of pending events after the consumer has
+         *  removed delivered events from m_pending. */
+        void updatePendingSize()
+        {
+            m_pending_size.store((uint32_t)m_pending.size(),
+                std::memory_order_relaxed);
+        }   // updatePendingSize
+        // --------------------------------------------------------------------
+        /** Returns the approximate number of events in this queue. */
+        unsigned getDepth() const
+        {
+            return (unsigned)m_ring.size() +
+                m_overflow_size.load(std::memory_order_relaxed) +
+                m_pending_size.load(std::memory_order_relaxed);
+        }   // getDepth
+        // --------------------------------------------------------------------
+        uint64_t getEventsCount() const
+                     { return m_events_count.load(std::memory_order_relaxed); }
+        // --------------------------------------------------------------------
+        uint64_t getTotalWaitMs() const
+                    { return m_total_wait_ms.load(std::memory_order_relaxed); }
+        // --------------------------------------------------------------------
+        uint64_t getMaxWaitMs() const
+                      { return m_max_wait_ms.load(std::memory_order_relaxed); }
+    };   // class EventQueue
+
     /** Contains the network events to pass synchronously to protocols
      *  (i.e. from the main thread). */
-    Synchronised<EventList> m_sync_events_to_process;
+    EventQueue m_sync_events_to_process;
 
     /** Contains the network events to pass asynchronously to protocols
     *  (i.e. from the separate ProtocolManager thread). */
-    Synchronised<EventList> m_async_events_to_process;
+    EventQueue m_async_events_to_process;
 
     /** Contains the requests to start/pause etc... protocols. */
     Synchronised< std::vector<ProtocolRequest> > m_requests;
@@ -240,6 +304,35 @@ public:
     void      findAndTerminate(ProtocolType type);
     void      update(int ticks);
     // ------------------------------------------------------------------------
+    /** Returns the number of events waiting for delivery.
+     *  \param sync True for the synchronous (main thread) queue. */
+    unsigned getEventQueueDepth(bool sync) const
+    {
+        return sync ? m_sync_events_to_process.getDepth() :
+                      m_async_events_to_process.getDepth();
+    }   // getEventQueueDepth
+    // ------------------------------------------------------------------------
+    /** Returns the number of events taken from a queue so far. */
+    uint64_t getEventQueueCount(bool sync) const
+    {
+        return sync ? m_sync_events_to_process.getEventsCount() :
+                      m_async_events_to_process.getEventsCount();
+    }   // getEventQueueCount
+    // ------------------------------------------------------------------------
+    /** Returns the sum of the times in ms all events waited in a queue. */
+    uint64_t getEventQueueTotalWait(bool sync) const
+    {
+        return sync ? m_sync_events_to_process.getTotalWaitMs() :
+                      m_async_events_to_process.getTotalWaitMs();
+    }   // getEventQueueTotalWait
+    // ------------------------------------------------------------------------
+    /** Returns the longest time in ms an event waited in a queue. */
+    uint64_t getEventQueueMaxWait(bool sync) const
+    {
+        return sync ? m_sync_events_to_process.getMaxWaitMs() :
+                      m_async_events_to_process.getMaxWaitMs();
+    }   // getEventQueueMaxWait
+    // ------------------------------------------------------------------------
     bool isExiting() const                            { return m_exit.load(); }
     // ------------------------------------------------------------------------
     const std::thread& getThread() const
@@ -258,6 +351,8 @@ public:
     {
         return m_protocol_manager.lock();
     }   // lock
+    // ------------------------------------------------------------------------
+    static void unitTesting();
 
 };   // class ProtocolManager
 
@@ -21,21 +21,27 @@
 #include "items/network_item_manager.hpp"
 #include "karts/abstract_kart.hpp"
 #include "karts/controller/player_controller.hpp"
-#include "modes/world.hpp"
+#include "modes/world_with_rank.hpp"
 #include "network/event.hpp"
 #include "network/network_config.hpp"
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
 #include "network/protocol_manager.hpp"
+#include "network/race_recorder.hpp"
 #include "network/rewind_info.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/rewinder.hpp"
+#include "network/server_config.hpp"
 #include "network/stk_host.hpp"
 #include "network/stk_peer.hpp"
+#include "tracks/arena_graph.hpp"
 #include "utils/log.hpp"
 #include "utils/time.hpp"
 #include "main_loop.hpp"
 
+#include <algorithm>
+
 // ============================================================================
 std::weak_ptr<GameProtocol> GameProtocol::m_game_protocol;
 // ============================================================================
@@ -57,7 +63,11 @@ GameProtocol::GameProtocol()
             : Protocol( PROTOCOL_CONTROLLER_EVENTS)
 {
     m_data_to_send = getNetworkString();
-
+    m_current_state_ticks = 0;
+    m_state_count = 0;
+    const std::string recording_dir = ServerConfig::m_race_recording_dir;
+    if (NetworkConfig::get()->isServer() && !recording_dir.empty())
+        m_race_recorder.reset(new RaceRecorder(recording_dir));
 }   // GameProtocol
 
 //-----------------------------------------------------------------------------
@@ -127,6 +137,8 @@ bool GameProtocol::notifyEventAsynchronous(Event* event)
     case GP_CONTROLLER_ACTION: handleControllerAction(event); break;
     case GP_STATE:             handleState(event);            break;
     case GP_ITEM_CONFIRMATION: handleItemEventConfirmation(event); break;
+    case GP_STATE_DELTA:       handleStateDelta(event);       break;
+    case GP_STATE_ACK:         handleStateAck(event);         break;
     case GP_ADJUST_TIME:
     case GP_ITEM_UPDATE:
         break;
@@ -222,6 +234,11 @@ void GameProtocol::handleControllerAction(Event *event)
                 cur_ticks, kart_id, std::get<0>(a), std::get<1>(a),
                 std::get<2>(a), std::get<3>(a));
         }
+        if (m_race_recorder)
+        {
+            m_race_recorder->addControllerAction(cur_ticks, kart_id, w, x, y,
+                                                 z);
+        }
         BareNetworkString *s = new BareNetworkString(3);
         s->addUInt8(kart_id).addUInt8(w).addUInt16(x).addUInt16(y)
             .addUInt16(z);
@@ -281,9 +298,13 @@ void GameProtocol::handleItemEventConfirmation(Event *event)
 void GameProtocol::startNewState()
 {
     assert(NetworkConfig::get()->isServer());
+    m_current_state_ticks = World::getWorld()->getTicksSinceStart();
+    m_state_count++;
+    m_current_state.m_rewinder_using.clear();
+    m_current_state.m_rewinder_ids.clear();
+    m_current_state.m_data.clear();
     m_data_to_send->clear();
-    m_data_to_send->addUInt8(GP_STATE)
-        .addUInt32(World::getWorld()->getTicksSinceStart());
+    m_data_to_send->addUInt8(GP_STATE).addUInt32(m_current_state_ticks);
 }   // startNewState
 
 // ----------------------------------------------------------------------------
@@ -296,6 +317,9 @@ void GameProtocol::addState(BareNetworkString *buffer)
     assert(NetworkConfig::get()->isServer());
     m_data_to_send->addUInt16(buffer->size());
     (*m_data_to_send) += *buffer;
+    const std::vector<uint8_t>& data = buffer->getBuffer();
+    m_current_state.m_data.emplace_back(
+        data.begin() + buffer->getCurrentOffset(), data.end());
 }   // addState
 
 // ----------------------------------------------------------------------------
@@ -320,18 +344,497 @@ void GameProtocol::finalizeState(std::vector<std::string>& cur_rewinder)
         names.insert(names.end(), rewinder.begin(), rewinder.end());
     }
     buffer.insert(pos, names.begin(), names.end());
+    m_current_state.m_rewinder_using = cur_rewinder;
+    for (const std::string& name : cur_rewinder)
+    {
+        m_current_state.m_rewinder_ids.push_back(
+            RewindManager::get()->getRewinderId(name));
+    }
 }   // finalizeState
 
 // ----------------------------------------------------------------------------
 /** Called when the last state information has been added and the message
- *  can be sent to the clients.
+ *  can be sent to the clients. If delta states are enabled, each client
+ *  supporting it gets the state encoded relative to the last state it has
+ *  acknowledged, all other clients get the full state. Karts which are not
+ *  relevant for a client can be omitted from its state. Rewinders are sent
+ *  by id to clients supporting it.
  */
 void GameProtocol::sendState()
 {
     assert(NetworkConfig::get()->isServer());
-    sendMessageToPeers(m_data_to_send, /*reliable*/false);
+    if (m_race_recorder)
+        m_race_recorder->addState(m_current_state_ticks, *m_data_to_send);
+
+    std::map<std::weak_ptr<STKPeer>, int,
+        std::owner_less<std::weak_ptr<STKPeer> > > last_acked_state;
+    {
+        std::lock_guard<std::mutex> lock(m_state_ack_mutex);
+        for (auto it = m_last_acked_state.begin();
+             it != m_last_acked_state.end();)
+        {
+            if (it->first.expired())
+            {
+                it = m_last_acked_state.erase(it);
+                continue;
+            }
+            it++;
+        }
+        if (ServerConfig::m_delta_state)
+            last_acked_state = m_last_acked_state;
+    }
+
+    // Clients getting the complete state and acknowledging the same state
+    // share the same encoded delta
+    std::map<std::pair<int, bool>, NetworkString*> delta_states;
+    std::unique_ptr<NetworkString> full_with_ids;
+    // The packets are encrypted and sent after all are encoded, so it can be
+    // done in parallel by the send workers
+    std::vector<std::shared_ptr<STKPeer> > peers;
+    std::vector<NetworkString*> packets;
+    std::vector<std::unique_ptr<NetworkString> > filtered_packets;
+    for (auto& peer : STKHost::get()->getPeers())
+    {
+        if (!peer->isValidated() || peer->isWaitingForGame())
+            continue;
+
+        const std::set<std::string>& caps = peer->getClientCapabilities();
+        const bool use_ids = caps.find("rewinder_id") != caps.end();
+        std::set<std::string> omitted;
+        findIrrelevantKarts(peer.get(), &omitted);
+        const StateSnapshot* state = &m_current_state;
+        StateSnapshot filtered_state;
+        NetworkString* ns = m_data_to_send;
+        if (!omitted.empty())
+        {
+            filtered_state = m_current_state;
+            omitRewinders(&filtered_state, omitted);
+            state = &filtered_state;
+            filtered_packets.emplace_back(getNetworkString());
+            ns = filtered_packets.back().get();
+            encodeState(ns, filtered_state, use_ids);
+            m_omitted_rewinders[peer][m_current_state_ticks] = omitted;
+        }
+        else if (use_ids)
+        {
+            if (!full_with_ids)
+            {
+                full_with_ids.reset(getNetworkString());
+                encodeState(full_with_ids.get(), m_current_state, use_ids);
+            }
+            ns = full_with_ids.get();
+        }
+
+        auto acked = last_acked_state.find(peer);
+        if (acked != last_acked_state.end())
+        {
+            auto baseline = m_state_snapshots.find(acked->second);
+            if (baseline != m_state_snapshots.end())
+            {
+                const std::set<std::string>* baseline_omitted = NULL;
+                auto peer_omitted = m_omitted_rewinders.find(peer);
+                if (peer_omitted != m_omitted_rewinders.end())
+                {
+                    auto it = peer_omitted->second.find(acked->second);
+                    if (it != peer_omitted->second.end())
+                        baseline_omitted = &it->second;
+                }
+                NetworkString* delta = NULL;
+                if (omitted.empty() && !baseline_omitted)
+                {
+                    NetworkString*& shared_delta =
+                        delta_states[std::make_pair(acked->second, use_ids)];
+                    if (!shared_delta)
+                    {
+                        shared_delta = getNetworkString();
+                        encodeStateDelta(shared_delta, m_current_state,
+                            acked->second, baseline->second, use_ids);
+                    }
+                    delta = shared_delta;
+                }
+                else
+                {
+                    // The client keeps the omitted rewinders of its
+                    // baseline as empty data
+                    StateSnapshot filtered_baseline = baseline->second;
+                    if (baseline_omitted)
+                        omitRewinders(&filtered_baseline, *baseline_omitted);
+                    filtered_packets.emplace_back(getNetworkString());
+                    delta = filtered_packets.back().get();
+                    encodeStateDelta(delta, *state, acked->second,
+                        filtered_baseline, use_ids);
+                }
+                if (delta->getTotalSize() < ns->getTotalSize())
+                    ns = delta;
+            }
+        }
+        peers.push_back(peer);
+        packets.push_back(ns);
+    }
+    STKHost::get()->sendPacketsToPeers(peers, packets, /*reliable*/false);
+    for (auto& delta : delta_states)
+        delete delta.second;
+
+    addStateSnapshot(m_current_state_ticks, m_current_state);
+
+    // Omitted rewinders are only needed as long as the state can be used
+    // as baseline
+    const int oldest_ticks = m_state_snapshots.begin()->first;
+    for (auto it = m_omitted_rewinders.begin();
+         it != m_omitted_rewinders.end();)
+    {
+        auto& states = it->second;
+        while (!states.empty() && states.begin()->first < oldest_ticks)
+            states.erase(states.begin());
+        if (it->first.expired() || states.empty())
+        {
+            it = m_omitted_rewinders.erase(it);
+            continue;
+        }
+        it++;
+    }
 }   // sendState
 
+// ----------------------------------------------------------------------------
+/** Finds the karts which are far away from all karts of a client. They are
+ *  only sent in every state-relevance-interval state to this client, which
+ *  predicts them in between. Distances are measured along the navmesh in
+ *  arenas, otherwise the direct distance is used.
+ *  \param peer The client to find the irrelevant karts for.
+ *  \param omitted Will contain the rewinder identities of these karts.
+ */
+void GameProtocol::findIrrelevantKarts(const STKPeer* peer,
+                                       std::set<std::string>* omitted) const
+{
+    const float max_distance = ServerConfig::m_state_relevance_distance;
+    const int interval = ServerConfig::m_state_relevance_interval;
+    if (max_distance <= 0.0f || interval <= 1 ||
+        m_state_count % interval == 0)
+        return;
+
+    const std::set<std::string>& caps = peer->getClientCapabilities();
+    if (caps.find("state_relevance") == caps.end())
+        return;
+    // Spectators get all karts
+    const std::set<unsigned>& own_karts = peer->getAvailableKartIDs();
+    if (own_karts.empty())
+        return;
+
+    World* world = World::getWorld();
+    WorldWithRank* wwr = dynamic_cast<WorldWithRank*>(world);
+    ArenaGraph* ag = ArenaGraph::get();
+    for (unsigned i = 0; i < world->getNumKarts(); i++)
+    {
+        AbstractKart* kart = world->getKart(i);
+        if (own_karts.find(i) != own_karts.end() || kart->isEliminated())
+            continue;
+        bool relevant = false;
+        for (unsigned id : own_karts)
+        {
+            if (id >= world->getNumKarts())
+                continue;
+            AbstractKart* own_kart = world->getKart(id);
+            float distance = -1.0f;
+            if (ag && wwr)
+            {
+                int from = wwr->getSectorForKart(own_kart);
+                int to = wwr->getSectorForKart(kart);
+                if (from != Graph::UNKNOWN_SECTOR &&
+                    to != Graph::UNKNOWN_SECTOR)
+                    distance = ag->getDistance(from, to);
+            }
+            if (distance < 0.0f)
+                distance = (own_kart->getXYZ() - kart->getXYZ()).length();
+            if (distance <= max_distance)
+            {
+                relevant = true;
+                break;
+            }
+        }
+        if (!relevant)
+            omitted->insert(std::string({ RN_KART, static_cast<char>(i) }));
+    }
+}   // findIrrelevantKarts
+
+// ----------------------------------------------------------------------------
+/** Removes the data of the given rewinders from a state. They are kept in
+ *  the list of rewinders with empty data, which tells the client to use its
+ *  own prediction for them.
+ *  \param state The state to change.
+ *  \param omitted Identities of the rewinders to remove.
+ */
+void GameProtocol::omitRewinders(StateSnapshot* state,
+                                 const std::set<std::string>& omitted)
+{
+    for (unsigned i = 0; i < state->m_rewinder_using.size(); i++)
+    {
+        if (omitted.find(state->m_rewinder_using[i]) != omitted.end())
+            state->m_data[i].clear();
+    }
+}   // omitRewinders
+
+// ----------------------------------------------------------------------------
+/** Writes a full state message from the data of each rewinder, in the same
+ *  format as assembled by startNewState, addState and finalizeState.
+ *  \param ns The network string to write the state to.
+ *  \param state The state to write.
+ *  \param use_ids If rewinders are written by id instead of by name.
+ */
+void GameProtocol::encodeState(NetworkString* ns, const StateSnapshot& state,
+                               bool use_ids)
+{
+    ns->addUInt8(GP_STATE).addUInt32(m_current_state_ticks);
+    encodeRewinderUsing(ns, state, use_ids);
+    for (const std::vector<uint8_t>& data : state.m_data)
+    {
+        ns->addUInt16((uint16_t)data.size());
+        for (uint8_t c : data)
+            ns->addUInt8(c);
+    }
+}   // encodeState
+
+// ----------------------------------------------------------------------------
+/** Writes the list of rewinders of a state. Clients supporting it get the
+ *  rewinders which existed at race start by id, which saves the name in each
+ *  state.
+ *  \param ns The network string to write to.
+ *  \param state The state with the rewinders to write.
+ *  \param use_ids If rewinders are written by id instead of by name.
+ */
+void GameProtocol::encodeRewinderUsing(NetworkString* ns,
+                                       const StateSnapshot& state,
+                                       bool use_ids)
+{
+    static_assert(RI_NAME >= RewindManager::MAX_REWINDER_IDS,
+                  "Rewinder ids must not clash with RI_NAME");
+    ns->addUInt8((uint8_t)state.m_rewinder_using.size());
+    for (unsigned i = 0; i < state.m_rewinder_using.size(); i++)
+    {
+        if (use_ids)
+        {
+            const int id = state.m_rewinder_ids[i];
+            if (id != -1)
+            {
+                assert(id < RI_NAME);
+                ns->addUInt8((uint8_t)id);
+                continue;
+            }
+            ns->addUInt8(RI_NAME);
+        }
+        ns->encodeString(state.m_rewinder_using[i]);
+    }
+}   // encodeRewinderUsing
+
+// ----------------------------------------------------------------------------
+/** Reads the list of rewinders of a state written by encodeRewinderUsing.
+ *  \param data The state message.
+ *  \param rewinder_using Will contain the unique identities of rewinders.
+ */
+void GameProtocol::decodeRewinderUsing(NetworkString& data,
+                                       std::vector<std::string>*
+                                       rewinder_using)
+{
+    const std::set<std::string>& caps =
+        NetworkConfig::get()->getServerCapabilities();
+    const bool use_ids = caps.find("rewinder_id") != caps.end();
+    unsigned rewinder_size = data.getUInt8();
+    rewinder_using->reserve(rewinder_size);
+    for (unsigned i = 0; i < rewinder_size; i++)
+    {
+        if (use_ids)
+        {
+            const uint8_t id = data.getUInt8();
+            if (id != RI_NAME)
+            {
+                const std::string* name =
+                    RewindManager::get()->getRewinderName(id);
+                if (!name)
+                    throw std::out_of_range("Unknown rewinder id.");
+                rewinder_using->push_back(*name);
+                continue;
+            }
+        }
+        std::string name;
+        data.decodeString(&name);
+        rewinder_using->push_back(name);
+    }
+}   // decodeRewinderUsing
+
+// ----------------------------------------------------------------------------
+/** Writes the state currently assembled by the server as a delta against the
+ *  given baseline. Data of a rewinder which is unchanged is omitted, data
+ *  with the same size is sent as runs of bytes xor-ed with the baseline,
+ *  everything else is sent in full.
+ *  \param ns The network string to write the delta state to.
+ *  \param state The current state as seen by the client.
+ *  \param baseline_ticks Ticks of the baseline state.
+ *  \param baseline The state the client has acknowledged.
+ *  \param use_ids If rewinders are written by id instead of by name.
+ */
+void GameProtocol::encodeStateDelta(NetworkString* ns,
+                                    const StateSnapshot& state,
+                                    int baseline_ticks,
+                                    const StateSnapshot& baseline,
+                                    bool use_ids)
+{
+    ns->addUInt8(GP_STATE_DELTA).addUInt32(m_current_state_ticks)
+        .addUInt32(baseline_ticks);
+
+    const bool same_rewinder_using =
+        state.m_rewinder_using == baseline.m_rewinder_using;
+    ns->addUInt8(same_rewinder_using ? 1 : 0);
+    std::map<std::string, unsigned> baseline_index;
+    if (!same_rewinder_using)
+    {
+        encodeRewinderUsing(ns, state, use_ids);
+        for (unsigned i = 0; i < baseline.m_rewinder_using.size(); i++)
+            baseline_index[baseline.m_rewinder_using[i]] = i;
+    }
+
+    for (unsigned i = 0; i < state.m_data.size(); i++)
+    {
+        const std::vector<uint8_t>& cur = state.m_data[i];
+        const std::vector<uint8_t>* base = NULL;
+        if (same_rewinder_using)
+            base = &baseline.m_data[i];
+        else
+        {
+            auto it = baseline_index.find(
+                state.m_rewinder_using[i]);
+            if (it != baseline_index.end())
+                base = &baseline.m_data[it->second];
+        }
+
+        if (base && *base == cur)
+        {
+            ns->addUInt8(DS_UNCHANGED);
+            continue;
+        }
+
+        BareNetworkString runs;
+        uint16_t run_count = 0;
+        if (base && base->size() == cur.size())
+        {
+            // Each run is: number of unchanged bytes to skip, number of
+            // changed bytes followed by these bytes xor-ed with baseline.
+            // Up to 2 unchanged bytes between changed bytes are merged into
+            // the run, as a new run costs 2 bytes.
+            unsigned pos = 0;
+            while (pos < cur.size())
+            {
+                unsigned start = pos;
+                while (start < cur.size() && cur[start] == (*base)[start])
+                    start++;
+                if (start == cur.size())
+                    break;
+                unsigned end = start + 1;
+                while (end < cur.size())
+                {
+                    if (cur[end] != (*base)[end])
+                    {
+                        end++;
+                        continue;
+                    }
+                    unsigned next = end;
+                    while (next < cur.size() && next - end < 3 &&
+                        cur[next] == (*base)[next])
+                        next++;
+                    if (next == cur.size() || next - end == 3)
+                        break;
+                    end = next;
+                }
+                unsigned skip = start - pos;
+                while (skip > 255)
+                {
+                    runs.addUInt8(255).addUInt8(0);
+                    run_count++;
+                    skip -= 255;
+                }
+                for (unsigned j = start; j < end;)
+                {
+                    unsigned len = std::min(end - j, 255u);
+                    runs.addUInt8((uint8_t)skip).addUInt8((uint8_t)len);
+                    for (unsigned k = j; k < j + len; k++)
+                        runs.addUInt8(cur[k] ^ (*base)[k]);
+                    run_count++;
+                    skip = 0;
+                    j += len;
+                }
+                pos = end;
+            }
+        }
+
+        if (base && base->size() == cur.size() &&
+            runs.getTotalSize() < cur.size())
+        {
+            ns->addUInt8(DS_XOR).addUInt16(run_count);
+            (*ns) += runs;
+        }
+        else
+        {
+            ns->addUInt8(DS_FULL).addUInt16((uint16_t)cur.size());
+            for (uint8_t c : cur)
+                ns->addUInt8(c);
+        }
+    }
+}   // encodeStateDelta
+
+// ----------------------------------------------------------------------------
+/** Stores a state as possible baseline for delta states, and discards the
+ *  states which are too old to be used anymore.
+ *  \param ticks Ticks of the state.
+ *  \param snapshot The state, its content will be moved.
+ */
+void GameProtocol::addStateSnapshot(int ticks, StateSnapshot& snapshot)
+{
+    m_state_snapshots[ticks] = std::move(snapshot);
+    // Keep 3 seconds of states, which is more than the maximum ping allowed
+    const unsigned max_snapshots =
+        std::max(NetworkConfig::get()->getStateFrequency() * 3, 1);
+    while (m_state_snapshots.size() > max_snapshots)
+        m_state_snapshots.erase(m_state_snapshots.begin());
+}   // addStateSnapshot
+
+// ----------------------------------------------------------------------------
+/** Sends to the server the ticks of the latest state received, so it can be
+ *  used as the baseline for the following delta states.
+ *  \param ticks Ticks of the state received, or -1 if the client cannot
+ *         decode delta states anymore and needs a full state.
+ */
+void GameProtocol::sendStateAck(int ticks)
+{
+    assert(NetworkConfig::get()->isClient());
+    NetworkString *ns = getNetworkString(5);
+    ns->addUInt8(GP_STATE_ACK).addUInt32(ticks);
+    // A lost acknowledgement only means a larger delta for the next state
+    sendToServer(ns, /*reliable*/false);
+    delete ns;
+}   // sendStateAck
+
+// ----------------------------------------------------------------------------
+/** Handles a state acknowledgement from a client.
+ *  \param event The data from the client.
+ */
+void GameProtocol::handleStateAck(Event *event)
+{
+    if (!NetworkConfig::get()->isServer() || !ServerConfig::m_delta_state)
+        return;
+    int ticks = (int)event->data().getUInt32();
+    std::weak_ptr<STKPeer> peer = event->getPeerSP();
+    std::lock_guard<std::mutex> lock(m_state_ack_mutex);
+    if (ticks < 0)
+    {
+        m_last_acked_state.erase(peer);
+        return;
+    }
+    // States are sent unsequenced, so only keep the latest one
+    auto it = m_last_acked_state.find(peer);
+    if (it == m_last_acked_state.end())
+        m_last_acked_state[peer] = ticks;
+    else if (it->second < ticks)
+        it->second = ticks;
+}   // handleStateAck
+
 // ----------------------------------------------------------------------------
 /** Called when a new full state is received form the server.
  */
@@ -343,13 +846,31 @@ void GameProtocol::handleState(Event *event)
     int ticks          = data.getUInt32();
 
     // Check for updated rewinder using
-    unsigned rewinder_size = data.getUInt8();
     std::vector<std::string> rewinder_using;
-    for (unsigned i = 0; i < rewinder_size; i++)
+    decodeRewinderUsing(data, &rewinder_using);
+    const unsigned rewinder_size = (unsigned)rewinder_using.size();
+
+    const std::set<std::string>& caps =
+        NetworkConfig::get()->getServerCapabilities();
+    if (caps.find("delta_state") != caps.end())
     {
-        std::string name;
-        data.decodeString(&name);
-        rewinder_using.push_back(name);
+        // Keep the data of each rewinder as baseline for delta states
+        StateSnapshot snapshot;
+        snapshot.m_rewinder_using = rewinder_using;
+        const int offset = data.getCurrentOffset();
+        for (unsigned i = 0; i < rewinder_size; i++)
+        {
+            uint16_t size = data.getUInt16();
+            if (size > data.size())
+                throw std::out_of_range("State data out of range.");
+            const uint8_t* p = (const uint8_t*)data.getCurrentData();
+            snapshot.m_data.emplace_back(p, p + size);
+            data.skip(size);
+        }
+        data.reset();
+        data.skip(offset);
+        addStateSnapshot(ticks, snapshot);
+        sendStateAck(ticks);
     }
 
     // The memory for bns will be handled in the RewindInfoState object
@@ -358,6 +879,106 @@ void GameProtocol::handleState(Event *event)
     RewindManager::get()->addNetworkRewindInfo(ris);
 }   // handleState
 
+// ----------------------------------------------------------------------------
+/** Called when a delta state is received from the server. It reconstructs
+ *  the full state from the baseline state it refers to, which is then handled
+ *  like a full state.
+ */
+void GameProtocol::handleStateDelta(Event *event)
+{
+    if (!NetworkConfig::get()->isClient())
+        return;
+    NetworkString &data = event->data();
+    int ticks          = data.getUInt32();
+    int baseline_ticks = data.getUInt32();
+
+    auto it = m_state_snapshots.find(baseline_ticks);
+    if (it == m_state_snapshots.end())
+    {
+        Log::warn("GameProtocol", "Missing baseline state %d for delta "
+            "state %d, requesting full state.", baseline_ticks, ticks);
+        sendStateAck(-1);
+        return;
+    }
+    const StateSnapshot& baseline = it->second;
+
+    StateSnapshot snapshot;
+    const bool same_rewinder_using = data.getUInt8() == 1;
+    std::map<std::string, unsigned> baseline_index;
+    if (same_rewinder_using)
+        snapshot.m_rewinder_using = baseline.m_rewinder_using;
+    else
+    {
+        decodeRewinderUsing(data, &snapshot.m_rewinder_using);
+        for (unsigned i = 0; i < baseline.m_rewinder_using.size(); i++)
+            baseline_index[baseline.m_rewinder_using[i]] = i;
+    }
+
+    // Rebuild the buffer in the same format as a full state
+    std::vector<uint8_t> buffer;
+    for (unsigned i = 0; i < snapshot.m_rewinder_using.size(); i++)
+    {
+        const std::vector<uint8_t>* base = NULL;
+        if (same_rewinder_using)
+            base = &baseline.m_data.at(i);
+        else
+        {
+            auto index = baseline_index.find(snapshot.m_rewinder_using[i]);
+            if (index != baseline_index.end())
+                base = &baseline.m_data[index->second];
+        }
+
+        std::vector<uint8_t> cur;
+        uint8_t mode = data.getUInt8();
+        if (mode == DS_FULL)
+        {
+            uint16_t size = data.getUInt16();
+            if (size > data.size())
+                throw std::out_of_range("Delta state data out of range.");
+            const uint8_t* p = (const uint8_t*)data.getCurrentData();
+            cur.assign(p, p + size);
+            data.skip(size);
+        }
+        else if (base && (mode == DS_UNCHANGED || mode == DS_XOR))
+        {
+            cur = *base;
+            if (mode == DS_XOR)
+            {
+                unsigned pos = 0;
+                uint16_t run_count = data.getUInt16();
+                for (unsigned j = 0; j < run_count; j++)
+                {
+                    pos += data.getUInt8();
+                    unsigned len = data.getUInt8();
+                    if (pos + len > cur.size())
+                    {
+                        throw std::out_of_range(
+                            "Delta state run out of range.");
+                    }
+                    for (unsigned k = 0; k < len; k++)
+                        cur[pos++] ^= data.getUInt8();
+                }
+            }
+        }
+        else
+        {
+            throw std::invalid_argument("Invalid delta state.");
+        }
+        buffer.push_back((cur.size() >> 8) & 0xff);
+        buffer.push_back(cur.size() & 0xff);
+        buffer.insert(buffer.end(), cur.begin(), cur.end());
+        snapshot.m_data.push_back(std::move(cur));
+    }
+
+    std::vector<std::string> rewinder_using = snapshot.m_rewinder_using;
+    addStateSnapshot(ticks, snapshot);
+    sendStateAck(ticks);
+
+    RewindInfoState* ris = new RewindInfoState(ticks, 0/*start_offset*/,
+        rewinder_using, buffer);
+    RewindManager::get()->addNetworkRewindInfo(ris);
+}   // handleStateDelta
+
 // ----------------------------------------------------------------------------
 /** Called from the RewindManager when rolling back.
  *  \param buffer Pointer to the saved state information.
@@ -27,12 +27,17 @@
 #include "utils/singleton.hpp"
 
 #include <cstdlib>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 #include <vector>
 #include <tuple>
 
 class BareNetworkString;
 class NetworkString;
+class RaceRecorder;
 class STKPeer;
 
 class GameProtocol : public Protocol
@@ -48,9 +53,31 @@ private:
            GP_STATE,
            GP_ITEM_UPDATE,
            GP_ITEM_CONFIRMATION,
-           GP_ADJUST_TIME
+           GP_ADJUST_TIME,
+           GP_STATE_DELTA,
+           GP_STATE_ACK
     };
 
+    /** How each rewinder is encoded in a delta state. */
+    enum { DS_UNCHANGED,
+           DS_FULL,
+           DS_XOR
+    };
+
+    /** A state split into the data of each rewinder, used as baseline for
+     *  delta states. */
+    struct StateSnapshot
+    {
+        std::vector<std::string> m_rewinder_using;
+        /** Server only: the rewinder id of each rewinder using, or -1. */
+        std::vector<int> m_rewinder_ids;
+        std::vector<std::vector<uint8_t> > m_data;
+    };   // struct StateSnapshot
+
+    /** Sent instead of a rewinder id for rewinders which have no id, followed
+     *  by the name of the rewinder. */
+    static const uint8_t RI_NAME = 255;
+
     /** A network string that collects all information from the server to be sent
      *  next. */
     NetworkString *m_data_to_send;
@@ -59,6 +86,36 @@ private:
      *  to reduce number of rollbacks. */
     std::vector<int8_t> m_adjust_time;
 
+    /** On the server the recently sent states, on a client the recently
+     *  received (and reconstructed) states, indexed by ticks. */
+    std::map<int, StateSnapshot> m_state_snapshots;
+
+    /** The state which is currently assembled by the server. */
+    StateSnapshot m_current_state;
+
+    /** Ticks of the state which is currently assembled by the server. */
+    int m_current_state_ticks;
+
+    /** Number of states assembled by the server, used to send irrelevant
+     *  karts only in every state-relevance-interval state. */
+    unsigned m_state_count;
+
+    /** Stores on the server for each client the rewinders which were
+     *  omitted in the states sent to it, indexed by state ticks. The client
+     *  keeps these states (with empty data for omitted rewinders) as
+     *  baseline for delta states. */
+    std::map<std::weak_ptr<STKPeer>, std::map<int, std::set<std::string> >,
+        std::owner_less<std::weak_ptr<STKPeer> > > m_omitted_rewinders;
+
+    /** Protect \ref m_last_acked_state, as it is written by the network
+     *  thread. */
+    std::mutex m_state_ack_mutex;
+
+    /** Stores on the server the latest acknowledged state ticks from each
+     *  client supporting delta states. */
+    std::map<std::weak_ptr<STKPeer>, int,
+        std::owner_less<std::weak_ptr<STKPeer> > > m_last_acked_state;
+
     // Dummy data structure to save all kart actions.
     struct Action
     {
@@ -73,10 +130,31 @@ private:
     // List of all kart actions to send to the server
     std::vector<Action> m_all_actions;
 
+    /** Records the race on the server if race-recording-dir is set. */
+    std::unique_ptr<RaceRecorder> m_race_recorder;
+
     void handleControllerAction(Event *event);
     void handleState(Event *event);
     void handleAdjustTime(Event *event);
     void handleItemEventConfirmation(Event *event);
+    void handleStateDelta(Event *event);
+    void handleStateAck(Event *event);
+    void addStateSnapshot(int ticks, StateSnapshot& snapshot);
+    void sendStateAck(int ticks);
+    void encodeState(NetworkString* ns, const StateSnapshot& state,
+                     bool use_ids);
+    void encodeStateDelta(NetworkString* ns, const StateSnapshot& state,
+                          int baseline_ticks, const StateSnapshot& baseline,
+                          bool use_ids);
+    static void encodeRewinderUsing(NetworkString* ns,
+                                    const StateSnapshot& state,
+                                    bool use_ids);
+    static void decodeRewinderUsing(NetworkString& data,
+                                    std::vector<std::string>* rewinder_using);
+    void findIrrelevantKarts(const STKPeer* peer,
+                             std::set<std::string>* omitted) const;
+    static void omitRewinders(StateSnapshot* state,
+                              const std::set<std::string>& omitted);
     static std::weak_ptr<GameProtocol> m_game_protocol;
     // Maximum value of values are only 32768
     std::tuple<uint8_t, uint16_t, uint16_t, uint16_t>
@@ -28,6 +28,7 @@
 #include "modes/capture_the_flag.hpp"
 #include "modes/linear_world.hpp"
 #include "network/crypto.hpp"
+#include "network/database_worker.hpp"
 #include "network/event.hpp"
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
@@ -171,7 +172,18 @@ void ServerLobby::initDatabase()
 {
 #ifdef ENABLE_SQLITE3
     m_last_cleanup_db_time = StkTime::getMonoTimeMs();
+    m_ban_index.reset(new BanIndex());
+    m_ban_index_dirty.store(true);
+    m_ban_index_loading.store(false);
+    m_ban_index_loaded = false;
+    m_ip_ban_changes_exists = false;
+    m_online_id_ban_changes_exists = false;
+    m_ip_ban_change_id = 0;
+    m_online_id_ban_change_id = 0;
+    m_ban_data_version = -1;
+    m_last_ban_check_time = 0;
     m_db = NULL;
+    m_db_worker.reset();
     m_ip_ban_table_exists = false;
     m_online_id_ban_table_exists = false;
     m_ip_geolocation_table_exists = false;
@@ -200,6 +212,7 @@ void ServerLobby::initDatabase()
             // Return zero to let caller return SQLITE_BUSY immediately
             return 0;
         }, NULL);
+    m_db_worker.reset(new DatabaseWorker(ServerConfig::m_database_file));
 
     checkTableExists(ServerConfig::m_ip_ban_table, m_ip_ban_table_exists);
     checkTableExists(ServerConfig::m_online_id_ban_table,
@@ -208,6 +221,19 @@ void ServerLobby::initDatabase()
         m_player_reports_table_exists);
     checkTableExists(ServerConfig::m_ip_geolocation_table,
         m_ip_geolocation_table_exists);
+    if (m_ip_ban_table_exists)
+    {
+        m_ip_ban_changes_exists = initBanChanges(ServerConfig::m_ip_ban_table,
+            "ip_start, ip_end");
+    }
+    if (m_online_id_ban_table_exists)
+    {
+        m_online_id_ban_changes_exists = initBanChanges(
+            ServerConfig::m_online_id_ban_table, "online_id");
+    }
+    // Read the ban tables before the first player connects
+    updateBanIndex();
+    m_db_worker->flush();
 #endif
 }   // initDatabase
 
@@ -416,6 +442,8 @@ void ServerLobby::destroyDatabase()
     auto peers = STKHost::get()->getPeers();
     for (auto& peer : peers)
         writeDisconnectInfoTable(peer.get());
+    // Finish all queued queries before closing the database
+    m_db_worker.reset();
     if (m_db != NULL)
         sqlite3_close(m_db);
 #endif
@@ -428,10 +456,15 @@ void ServerLobby::writeDisconnectInfoTable(STKPeer* peer)
     if (m_server_stats_table.empty())
         return;
     std::string query = StringUtils::insertValues(
-        "UPDATE %s SET disconnected_time = datetime('now'), ping = %d "
-        "WHERE host_id = %u;", m_server_stats_table.c_str(),
-        peer->getAveragePing(), peer->getHostId());
-    easySQLQuery(query);
+        "UPDATE %s SET disconnected_time = datetime('now'), ping = ? "
+        "WHERE host_id = ?;", m_server_stats_table.c_str());
+    const int ping = peer->getAveragePing();
+    const uint32_t host_id = peer->getHostId();
+    easySQLQuery(query, [ping, host_id](sqlite3_stmt* stmt)
+        {
+            sqlite3_bind_int(stmt, 1, ping);
+            sqlite3_bind_int64(stmt, 2, host_id);
+        });
 #endif
 }   // writeDisconnectInfoTable
 
@@ -737,6 +770,20 @@ void ServerLobby::cleanupDatabase()
             ServerConfig::m_player_reports_expired_days);
         easySQLQuery(query);
     }
+    // Servers check the change logs every second, a server stopped for
+    // longer reads the ban tables completely when started again
+    if (m_ip_ban_changes_exists)
+    {
+        easySQLQuery(StringUtils::insertValues("DELETE FROM %s_changes "
+            "WHERE changed_time < datetime('now', '-1 days');",
+            ServerConfig::m_ip_ban_table.c_str()));
+    }
+    if (m_online_id_ban_changes_exists)
+    {
+        easySQLQuery(StringUtils::insertValues("DELETE FROM %s_changes "
+            "WHERE changed_time < datetime('now', '-1 days');",
+            ServerConfig::m_online_id_ban_table.c_str()));
+    }
     if (m_server_stats_table.empty())
         return;
 
@@ -779,39 +826,277 @@ void ServerLobby::cleanupDatabase()
 }   // cleanupDatabase
 
 //-----------------------------------------------------------------------------
-/** Run simple query with write lock waiting and optional function, this
- *  function has no callback for the return (if any) by the query.
- *  Return true if no error occurs
+/** Creates a change log of a ban table, which triggers fill with the rowid
+ *  of each ban added, removed or changed, so the ban index only needs to
+ *  read the changed bans again. Updates of trigger_count and last_trigger,
+ *  which the servers do whenever a ban is triggered, are not logged. The
+ *  change log is shared by all servers using the same ban table.
+ *  \param table Name of the ban table.
+ *  \param columns Columns of the banned ips or online id.
+ *  \return True if the change log and its triggers exist.
  */
-bool ServerLobby::easySQLQuery(const std::string& query,
-                   std::function<void(sqlite3_stmt* stmt)> bind_function) const
+bool ServerLobby::initBanChanges(const std::string& table,
+                                 const std::string& columns)
 {
-    if (!m_db)
+    const std::string changes = table + "_changes";
+    std::ostringstream oss;
+    oss << "CREATE TABLE IF NOT EXISTS " << changes << "\n"
+        << "(\n"
+        << "    id INTEGER PRIMARY KEY AUTOINCREMENT, -- Increased for each change\n"
+        << "    row_id INTEGER NOT NULL, -- rowid of the changed ban\n"
+        << "    changed_time TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP -- Time of the change\n"
+        << ");\n"
+        << "CREATE TRIGGER IF NOT EXISTS " << changes << "_insert\n"
+        << "    AFTER INSERT ON " << table << "\n"
+        << "BEGIN\n"
+        << "    INSERT INTO " << changes << " (row_id) VALUES (new.rowid);\n"
+        << "END;\n"
+        << "CREATE TRIGGER IF NOT EXISTS " << changes << "_update\n"
+        << "    AFTER UPDATE OF " << columns << ", starting_time, "
+        << "expired_days, reason, description ON " << table << "\n"
+        << "BEGIN\n"
+        << "    INSERT INTO " << changes << " (row_id)\n"
+        << "        SELECT old.rowid UNION SELECT new.rowid;\n"
+        << "END;\n"
+        << "CREATE TRIGGER IF NOT EXISTS " << changes << "_delete\n"
+        << "    AFTER DELETE ON " << table << "\n"
+        << "BEGIN\n"
+        << "    INSERT INTO " << changes << " (row_id) VALUES (old.rowid);\n"
+        << "END;";
+    char* error = NULL;
+    if (sqlite3_exec(m_db, oss.str().c_str(), NULL, NULL, &error) !=
+        SQLITE_OK)
+    {
+        Log::warn("ServerLobby", "Cannot create change log of %s, it will "
+            "be read completely whenever the database changes: %s",
+            table.c_str(), error ? error : "");
+        sqlite3_free(error);
         return false;
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
+    }
+    return true;
+}   // initBanChanges
+
+//-----------------------------------------------------------------------------
+/** Reads the ban tables into a new ban index if they might have changed,
+ *  which is checked at most once per second. The tables are read completely
+ *  once, after that only the bans found in the change logs (see
+ *  initBanChanges()) since the last check are read, so writes of the
+ *  servers to other tables do not cause any reading. If a ban table has no
+ *  change log, the tables are read completely whenever the data version of
+ *  the database changed. The tables are read by the database thread, which
+ *  replaces the ban index when done, so large tables do not stall the lobby.
+ */
+void ServerLobby::updateBanIndex()
+{
+    if (!m_db || !m_db_worker ||
+        (!m_ip_ban_table_exists && !m_online_id_ban_table_exists))
+        return;
+    // Changes made while the tables are read are found by the next check
+    if (m_ban_index_loading.load())
+        return;
+
+    const bool dirty = m_ban_index_dirty.exchange(false);
+    if (!dirty && StkTime::getMonoTimeMs() < m_last_ban_check_time + 1000)
+        return;
+    m_last_ban_check_time = StkTime::getMonoTimeMs();
+
+    const bool incremental = m_ban_index_loaded &&
+        (!m_ip_ban_table_exists || m_ip_ban_changes_exists) &&
+        (!m_online_id_ban_table_exists || m_online_id_ban_changes_exists);
+    if (!incremental)
     {
-        if (bind_function)
-            bind_function(stmt);
-        ret = sqlite3_step(stmt);
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+        int data_version = -1;
+        sqlite3_stmt* stmt = NULL;
+        if (sqlite3_prepare_v2(m_db, "PRAGMA data_version;", -1, &stmt, 0) ==
+            SQLITE_OK)
         {
-            Log::error("ServerLobby",
-                "Error finalize database for easy query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-            return false;
+            if (sqlite3_step(stmt) == SQLITE_ROW)
+                data_version = sqlite3_column_int(stmt, 0);
+            sqlite3_finalize(stmt);
         }
+        if (!dirty && data_version != -1 &&
+            data_version == m_ban_data_version)
+            return;
+        m_ban_data_version = data_version;
+    }
+
+    // Times are converted to seconds since 1.1.1970, so the index can
+    // check if a ban is active with the same conditions as a query
+    const std::string times = "CAST(strftime('%s', starting_time) AS "
+        "INTEGER), CASE WHEN expired_days IS NULL THEN -1 ELSE "
+        "CAST(strftime('%s', starting_time, '+'||expired_days||' days') AS "
+        "INTEGER) END";
+    auto read_ban = [](sqlite3_stmt* stmt, BanIndex::Ban* ban)
+    {
+        const char* reason = (const char*)sqlite3_column_text(stmt, 1);
+        const char* desc = (const char*)sqlite3_column_text(stmt, 2);
+        ban->m_row_id = sqlite3_column_int(stmt, 0);
+        ban->m_reason = reason ? reason : "";
+        ban->m_description = desc ? desc : "";
+        ban->m_start_time = sqlite3_column_int64(stmt, 3);
+        ban->m_expired_time = sqlite3_column_type(stmt, 4) == SQLITE_NULL ?
+            -1 : sqlite3_column_int64(stmt, 4);
+    };
+    auto is_null = [](sqlite3_stmt* stmt, int column)
+    {
+        return sqlite3_column_type(stmt, column) == SQLITE_NULL;
+    };
+
+    m_ban_index_loading.store(true);
+    std::shared_ptr<BanIndex> index = std::make_shared<BanIndex>();
+    std::shared_ptr<bool> ok = std::make_shared<bool>(true);
+    auto done = [ok](bool success)
+    {
+        if (!success)
+            *ok = false;
+    };
+    // Last change of each change log, read before the bans so changes made
+    // in between are read again next time
+    std::shared_ptr<int64_t> ip_change_id =
+        std::make_shared<int64_t>(m_ip_ban_change_id);
+    std::shared_ptr<int64_t> online_id_change_id =
+        std::make_shared<int64_t>(m_online_id_ban_change_id);
+    auto read_change_id = [this, done](const std::string& table,
+                                       std::shared_ptr<int64_t> change_id)
+    {
+        m_db_worker->addQuery("SELECT IFNULL(MAX(id), 0) FROM " + table +
+            "_changes;", nullptr, done, [change_id](sqlite3_stmt* stmt)
+            {
+                *change_id = sqlite3_column_int64(stmt, 0);
+            });
+    };
+    if (m_ip_ban_changes_exists)
+        read_change_id(ServerConfig::m_ip_ban_table, ip_change_id);
+    if (m_online_id_ban_changes_exists)
+    {
+        read_change_id(ServerConfig::m_online_id_ban_table,
+            online_id_change_id);
+    }
+
+    // Reads the bans of a table, or with incremental only the bans changed
+    // since the last check. The rowid of a changed ban is the last column,
+    // and the other columns are NULL if it was removed.
+    std::shared_ptr<bool> changed = std::make_shared<bool>(!incremental);
+    auto read_bans = [this, incremental, times, done, index, changed](
+        const std::string& table, const std::string& columns,
+        std::shared_ptr<int64_t> change_id, int64_t last_change_id,
+        std::function<void(sqlite3_stmt*)> add_ban,
+        std::function<void(int)> remove_ban)
+    {
+        const std::string select = "SELECT " + table + ".rowid, reason, "
+            "description, " + times + ", " + columns;
+        if (!incremental)
+        {
+            m_db_worker->addQuery(select + " FROM " + table + ";", nullptr,
+                done, add_ban);
+            return;
+        }
+        m_db_worker->addQuery(select + ", changes.row_id FROM (SELECT "
+            "DISTINCT row_id FROM " + table + "_changes WHERE id > ? AND "
+            "id <= ?) AS changes LEFT JOIN " + table + " ON " + table +
+            ".rowid = changes.row_id;",
+            [change_id, last_change_id](sqlite3_stmt* stmt)
+            {
+                sqlite3_bind_int64(stmt, 1, last_change_id);
+                sqlite3_bind_int64(stmt, 2, *change_id);
+            }, done,
+            [this, index, changed, add_ban, remove_ban](sqlite3_stmt* stmt)
+            {
+                // Only the database thread replaces the ban index
+                if (!*changed)
+                {
+                    index->copyBans(*getBanIndex());
+                    *changed = true;
+                }
+                const int column = sqlite3_column_count(stmt) - 1;
+                remove_ban(sqlite3_column_int(stmt, column));
+                add_ban(stmt);
+            });
+    };
+    if (m_ip_ban_table_exists)
+    {
+        read_bans(ServerConfig::m_ip_ban_table, "ip_start, ip_end",
+            ip_change_id, m_ip_ban_change_id,
+            [index, read_ban, is_null](sqlite3_stmt* stmt)
+            {
+                if (is_null(stmt, 0) || is_null(stmt, 3) ||
+                    is_null(stmt, 5) || is_null(stmt, 6))
+                    return;
+                BanIndex::Ban ban;
+                read_ban(stmt, &ban);
+                index->addIPBan((uint32_t)sqlite3_column_int64(stmt, 5),
+                    (uint32_t)sqlite3_column_int64(stmt, 6), ban);
+            },
+            [index](int row_id) { index->removeIPBan(row_id); });
     }
-    else
+    if (m_online_id_ban_table_exists)
     {
-        Log::error("ServerLobby",
-            "Error preparing database for easy query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return false;
+        read_bans(ServerConfig::m_online_id_ban_table, "online_id",
+            online_id_change_id, m_online_id_ban_change_id,
+            [index, read_ban, is_null](sqlite3_stmt* stmt)
+            {
+                if (is_null(stmt, 0) || is_null(stmt, 3) || is_null(stmt, 5))
+                    return;
+                BanIndex::Ban ban;
+                read_ban(stmt, &ban);
+                index->addOnlineIdBan((uint32_t)sqlite3_column_int64(stmt, 5),
+                    ban);
+            },
+            [index](int row_id) { index->removeOnlineIdBan(row_id); });
+    }
+    // Queries are executed in order, so this is called after both tables
+    // were read. Keep the old index and change ids if reading failed.
+    m_db_worker->addQuery("SELECT 1;", nullptr,
+        [this, index, ok, changed, ip_change_id, online_id_change_id]
+        (bool success)
+        {
+            if (*ok)
+            {
+                if (*changed)
+                {
+                    std::lock_guard<std::mutex> lock(m_ban_index_mutex);
+                    m_ban_index = index;
+                }
+                m_ip_ban_change_id = *ip_change_id;
+                m_online_id_ban_change_id = *online_id_change_id;
+                m_ban_index_loaded = true;
+            }
+            else
+                m_ban_index_dirty.store(true);
+            m_ban_index_loading.store(false);
+        });
+}   // updateBanIndex
+
+//-----------------------------------------------------------------------------
+/** Returns the current ban index. The index is only searched by the lobby
+ *  thread, the database thread replaces it by a new one.
+ */
+std::shared_ptr<BanIndex> ServerLobby::getBanIndex()
+{
+    std::lock_guard<std::mutex> lock(m_ban_index_mutex);
+    return m_ban_index;
+}   // getBanIndex
+
+//-----------------------------------------------------------------------------
+/** Run simple query with write lock waiting and optional function in the
+ *  database thread, so the lobby is not blocked by it. This function has no
+ *  callback for the return (if any) by the query.
+ *  \param bind_function Optional function to bind values, it is called
+ *         later so it must not use data which can be freed before.
+ *  \param done_function Optional function called in the database thread
+ *         with true if no error occurs.
+ */
+void ServerLobby::easySQLQuery(const std::string& query,
+                   std::function<void(sqlite3_stmt* stmt)> bind_function,
+                   std::function<void(bool)> done_function) const
+{
+    if (!m_db_worker)
+    {
+        if (done_function)
+            done_function(false);
+        return;
     }
-    return true;
+    m_db_worker->addQuery(query, bind_function, done_function);
 }   // easySQLQuery
 
 //-----------------------------------------------------------------------------
@@ -930,7 +1215,8 @@ void ServerLobby::writePlayerReport(Event* event)
         ServerConfig::m_player_reports_table.c_str(),
         reporter->getAddress().getIP(), reporter_npp->getOnlineId(),
         reporting_peer->getAddress().getIP(), reporting_npp->getOnlineId());
-    bool written = easySQLQuery(query,
+    std::shared_ptr<STKPeer> reporter_peer = event->getPeerSP();
+    easySQLQuery(query,
         [reporter_npp, reporting_npp, info](sqlite3_stmt* stmt)
         {
             // SQLITE_TRANSIENT to copy string
@@ -961,16 +1247,18 @@ void ServerLobby::writePlayerReport(Event* event)
                 Log::error("easySQLQuery", "Failed to bind %s.",
                     StringUtils::wideToUtf8(reporting_npp->getName()).c_str());
             }
+        },
+        [this, reporter_peer, reporting_npp](bool written)
+        {
+            if (!written)
+                return;
+            NetworkString* success = getNetworkString();
+            success->setSynchronous(true);
+            success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
+                .encodeString(reporting_npp->getName());
+            reporter_peer->sendPacket(success, true/*reliable*/);
+            delete success;
         });
-    if (written)
-    {
-        NetworkString* success = getNetworkString();
-        success->setSynchronous(true);
-        success->addUInt8(LE_REPORT_PLAYER).addUInt8(1)
-            .encodeString(reporting_npp->getName());
-        event->getPeer()->sendPacket(success, true/*reliable*/);
-        delete success;
-    }
 #endif
 }   // writePlayerReport
 
@@ -987,6 +1275,7 @@ void ServerLobby::asynchronousUpdate()
 
 #ifdef ENABLE_SQLITE3
     cleanupDatabase();
+    updateBanIndex();
 #endif
 
     // Check if server owner has left
@@ -2211,7 +2500,8 @@ void ServerLobby::checkIncomingConnectionRequests()
         }
     public:
         PollServerRequest(std::shared_ptr<ServerLobby> sl)
-        : XMLRequest(true), m_server_lobby(sl)
+        : XMLRequest(true, Online::RequestManager::HTTP_HIGH_PRIORITY),
+          m_server_lobby(sl)
         {
             m_disable_sending_log = true;
         }
@@ -2642,7 +2932,11 @@ void ServerLobby::saveIPBanTable(const TransportAddress& addr)
         "INSERT INTO %s (ip_start, ip_end) "
         "VALUES (%u, %u);",
         ServerConfig::m_ip_ban_table.c_str(), addr.getIP(), addr.getIP());
-    easySQLQuery(query);
+    easySQLQuery(query, nullptr, [this](bool written)
+        {
+            if (written)
+                m_ban_index_dirty.store(true);
+        });
 #endif
 }   // saveIPBanTable
 
@@ -2973,9 +3267,13 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
     message_ack->addUInt8(LE_CONNECTION_ACCEPTED).addUInt32(peer->getHostId())
         .addUInt32(ServerConfig::m_server_version);
 
-    message_ack->addUInt16(
-        (uint16_t)stk_config->m_network_capabilities.size());
-    for (const std::string& cap : stk_config->m_network_capabilities)
+    // Clients only keep state snapshots and send acknowledgements if delta
+    // states are advertised, so don't advertise them if they are disabled
+    std::set<std::string> capabilities = stk_config->m_network_capabilities;
+    if (!ServerConfig::m_delta_state)
+        capabilities.erase("delta_state");
+    message_ack->addUInt16((uint16_t)capabilities.size());
+    for (const std::string& cap : capabilities)
         message_ack->encodeString(cap);
 
     message_ack->addFloat(auto_start_timer)
@@ -3023,23 +3321,32 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
         "INSERT INTO %s "
         "(host_id, ip, port, online_id, username, player_num, "
         "country_code, version, ping) "
-        "VALUES (%u, %u, %u, %u, ?, %u, ?, ?, %u);",
-        m_server_stats_table.c_str(), peer->getHostId(),
-        peer->getAddress().getIP(), peer->getAddress().getPort(), online_id,
-        player_count, peer->getAveragePing());
-    easySQLQuery(query, [peer, country_code](sqlite3_stmt* stmt)
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);", m_server_stats_table.c_str());
+    // The query is run later, so copy everything from the peer now
+    const uint32_t host_id = peer->getHostId();
+    const uint32_t ip = peer->getAddress().getIP();
+    const uint16_t port = peer->getAddress().getPort();
+    const int ping = peer->getAveragePing();
+    const std::string username =
+        StringUtils::wideToUtf8(peer->getPlayerProfiles()[0]->getName());
+    const std::string version = peer->getUserVersion();
+    easySQLQuery(query, [host_id, ip, port, online_id, username,
+        player_count, country_code, version, ping](sqlite3_stmt* stmt)
         {
-            if (sqlite3_bind_text(stmt, 1, StringUtils::wideToUtf8(
-                peer->getPlayerProfiles()[0]->getName()).c_str(),
+            sqlite3_bind_int64(stmt, 1, host_id);
+            sqlite3_bind_int64(stmt, 2, ip);
+            sqlite3_bind_int(stmt, 3, port);
+            sqlite3_bind_int64(stmt, 4, online_id);
+            if (sqlite3_bind_text(stmt, 5, username.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    StringUtils::wideToUtf8(
-                    peer->getPlayerProfiles()[0]->getName()).c_str());
+                    username.c_str());
             }
+            sqlite3_bind_int(stmt, 6, player_count);
             if (country_code.empty())
             {
-                if (sqlite3_bind_null(stmt, 2) != SQLITE_OK)
+                if (sqlite3_bind_null(stmt, 7) != SQLITE_OK)
                 {
                     Log::error("easySQLQuery",
                         "Failed to bind NULL for country code.");
@@ -3047,19 +3354,20 @@ void ServerLobby::handleUnencryptedConnection(std::shared_ptr<STKPeer> peer,
             }
             else
             {
-                if (sqlite3_bind_text(stmt, 2, country_code.c_str(),
+                if (sqlite3_bind_text(stmt, 7, country_code.c_str(),
                     -1, SQLITE_TRANSIENT) != SQLITE_OK)
                 {
                     Log::error("easySQLQuery", "Failed to bind country: %s.",
                         country_code.c_str());
                 }
             }
-            if (sqlite3_bind_text(stmt, 3, peer->getUserVersion().c_str(),
+            if (sqlite3_bind_text(stmt, 8, version.c_str(),
                 -1, SQLITE_TRANSIENT) != SQLITE_OK)
             {
                 Log::error("easySQLQuery", "Failed to bind %s.",
-                    peer->getUserVersion().c_str());
+                    version.c_str());
             }
+            sqlite3_bind_int(stmt, 9, ping);
         }
     );
 #endif
@@ -3828,124 +4136,65 @@ void ServerLobby::resetServer()
 }   // resetServer
 
 //-----------------------------------------------------------------------------
-void ServerLobby::testBannedForIP(STKPeer* peer) const
+void ServerLobby::testBannedForIP(STKPeer* peer)
 {
 #ifdef ENABLE_SQLITE3
     if (!m_db || !m_ip_ban_table_exists)
         return;
 
-    int row_id = -1;
-    unsigned ip_start = 0;
-    unsigned ip_end = 0;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, ip_start, ip_end, reason, description FROM %s "
-        "WHERE ip_start <= %u AND ip_end >= %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_ip_ban_table.c_str(),
-        peer->getAddress().getIP(), peer->getAddress().getIP());
+    std::shared_ptr<BanIndex> ban_index = getBanIndex();
+    const BanIndex::Ban* ban = ban_index->findIPBan(
+        peer->getAddress().getIP(), StkTime::getTimeSinceEpoch());
+    if (!ban)
+        return;
 
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            ip_start = (unsigned)sqlite3_column_int64(stmt, 1);
-            ip_end = (unsigned)sqlite3_column_int64(stmt, 2);
-            const char* reason = (char*)sqlite3_column_text(stmt, 3);
-            const char* desc = (char*)sqlite3_column_text(stmt, 4);
-            Log::info("ServerLobby", "%s banned by IP: %s "
-                "(rowid: %d, description: %s).",
-                peer->getAddress().toString().c_str(), reason, row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+    Log::info("ServerLobby", "%s banned by IP: %s "
+        "(rowid: %d, description: %s).",
+        peer->getAddress().toString().c_str(), ban->m_reason.c_str(),
+        ban->m_row_id, ban->m_description.c_str());
+    kickPlayerWithReason(peer, ban->m_reason.c_str());
+
+    const int row_id = ban->m_row_id;
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE rowid = ?;",
+        ServerConfig::m_ip_ban_table.c_str());
+    easySQLQuery(query, [row_id](sqlite3_stmt* stmt)
         {
-            Log::error("ServerLobby",
-                "Error finalize database for query %s: %s",
-                query.c_str(), sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database for query %s: %s",
-            query.c_str(), sqlite3_errmsg(m_db));
-        return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE ip_start = %u AND ip_end = %u;",
-            ServerConfig::m_ip_ban_table.c_str(), ip_start, ip_end);
-        easySQLQuery(query);
-    }
+            sqlite3_bind_int(stmt, 1, row_id);
+        });
 #endif
 }   // testBannedForIP
 
 //-----------------------------------------------------------------------------
-void ServerLobby::testBannedForOnlineId(STKPeer* peer,
-                                        uint32_t online_id) const
+void ServerLobby::testBannedForOnlineId(STKPeer* peer, uint32_t online_id)
 {
 #ifdef ENABLE_SQLITE3
     if (!m_db || !m_online_id_ban_table_exists)
         return;
 
-    int row_id = -1;
-    std::string query = StringUtils::insertValues(
-        "SELECT rowid, reason, description FROM %s "
-        "WHERE online_id = %u "
-        "AND datetime('now') > datetime(starting_time) AND "
-        "(expired_days is NULL OR datetime"
-        "(starting_time, '+'||expired_days||' days') > datetime('now')) "
-        "LIMIT 1;",
-        ServerConfig::m_online_id_ban_table.c_str(), online_id);
+    std::shared_ptr<BanIndex> ban_index = getBanIndex();
+    const BanIndex::Ban* ban = ban_index->findOnlineIdBan(online_id,
+        StkTime::getTimeSinceEpoch());
+    if (!ban)
+        return;
 
-    sqlite3_stmt* stmt = NULL;
-    int ret = sqlite3_prepare_v2(m_db, query.c_str(), -1, &stmt, 0);
-    if (ret == SQLITE_OK)
-    {
-        ret = sqlite3_step(stmt);
-        if (ret == SQLITE_ROW)
-        {
-            row_id = sqlite3_column_int(stmt, 0);
-            const char* reason = (char*)sqlite3_column_text(stmt, 1);
-            const char* desc = (char*)sqlite3_column_text(stmt, 2);
-            Log::info("ServerLobby", "%s banned by online id: %s "
-                "(online id: %u rowid: %d, description: %s).",
-                peer->getAddress().toString().c_str(), reason, online_id,
-                row_id, desc);
-            kickPlayerWithReason(peer, reason);
-        }
-        ret = sqlite3_finalize(stmt);
-        if (ret != SQLITE_OK)
+    Log::info("ServerLobby", "%s banned by online id: %s "
+        "(online id: %u rowid: %d, description: %s).",
+        peer->getAddress().toString().c_str(), ban->m_reason.c_str(),
+        online_id, ban->m_row_id, ban->m_description.c_str());
+    kickPlayerWithReason(peer, ban->m_reason.c_str());
+
+    std::string query = StringUtils::insertValues(
+        "UPDATE %s SET trigger_count = trigger_count + 1, "
+        "last_trigger = datetime('now') "
+        "WHERE online_id = ?;",
+        ServerConfig::m_online_id_ban_table.c_str());
+    easySQLQuery(query, [online_id](sqlite3_stmt* stmt)
         {
-            Log::error("ServerLobby", "Error finalize database: %s",
-                sqlite3_errmsg(m_db));
-        }
-    }
-    else
-    {
-        Log::error("ServerLobby", "Error preparing database: %s",
-            sqlite3_errmsg(m_db));
-        return;
-    }
-    if (row_id != -1)
-    {
-        query = StringUtils::insertValues(
-            "UPDATE %s SET trigger_count = trigger_count + 1, "
-            "last_trigger = datetime('now') "
-            "WHERE online_id = %u;",
-            ServerConfig::m_online_id_ban_table.c_str(), online_id);
-        easySQLQuery(query);
-    }
+            sqlite3_bind_int64(stmt, 1, online_id);
+        });
 #endif
 }   // testBannedForOnlineId
 
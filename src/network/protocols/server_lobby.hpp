@@ -19,6 +19,7 @@
 #ifndef SERVER_LOBBY_HPP
 #define SERVER_LOBBY_HPP
 
+#include "network/ban_index.hpp"
 #include "network/protocols/lobby_protocol.hpp"
 #include "network/transport_address.hpp"
 #include "utils/cpp2011.hpp"
@@ -39,6 +40,7 @@
 #endif
 
 class BareNetworkString;
+class DatabaseWorker;
 class NetworkString;
 class NetworkPlayerProfile;
 class STKPeer;
@@ -76,6 +78,10 @@ private:
 #ifdef ENABLE_SQLITE3
     sqlite3* m_db;
 
+    /** Executes queries which do not need an answer at once in a separate
+     *  thread. */
+    std::unique_ptr<DatabaseWorker> m_db_worker;
+
     std::string m_server_stats_table;
 
     bool m_ip_ban_table_exists;
@@ -86,10 +92,54 @@ private:
 
     uint64_t m_last_cleanup_db_time;
 
+    /** The ban tables in memory, so connecting players can be checked
+     *  without querying the database. It is read again by the database
+     *  thread, which replaces it when done. */
+    std::shared_ptr<BanIndex> m_ban_index;
+
+    /** Protects m_ban_index, which is replaced by the database thread. */
+    std::mutex m_ban_index_mutex;
+
+    /** Set while the database thread reads the ban tables. */
+    std::atomic_bool m_ban_index_loading;
+
+    /** Set when this server changed a ban table, so the changes are read
+     *  without waiting for the next check. */
+    std::atomic_bool m_ban_index_dirty;
+
+    /** Set when the ban tables were read completely, after that only the
+     *  changed bans are read if the tables have a change log. */
+    bool m_ban_index_loaded;
+
+    /** If the ban tables have a change log, see initBanChanges(). */
+    bool m_ip_ban_changes_exists;
+
+    bool m_online_id_ban_changes_exists;
+
+    /** Id of the last change in the change log of each ban table which is
+     *  included in m_ban_index. */
+    int64_t m_ip_ban_change_id;
+
+    int64_t m_online_id_ban_change_id;
+
+    /** Data version of the database when the ban index was read, only used
+     *  if a ban table has no change log. */
+    int m_ban_data_version;
+
+    uint64_t m_last_ban_check_time;
+
     void cleanupDatabase();
 
-    bool easySQLQuery(const std::string& query,
-        std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr) const;
+    bool initBanChanges(const std::string& table,
+                        const std::string& columns);
+
+    void updateBanIndex();
+
+    std::shared_ptr<BanIndex> getBanIndex();
+
+    void easySQLQuery(const std::string& query,
+        std::function<void(sqlite3_stmt* stmt)> bind_function = nullptr,
+        std::function<void(bool)> done_function = nullptr) const;
 
     void checkTableExists(const std::string& table, bool& result);
 
@@ -329,8 +379,8 @@ private:
     void clientInGameWantsToBackLobby(Event* event);
     void clientSelectingAssetsWantsToBackLobby(Event* event);
     void kickPlayerWithReason(STKPeer* peer, const char* reason) const;
-    void testBannedForIP(STKPeer* peer) const;
-    void testBannedForOnlineId(STKPeer* peer, uint32_t online_id) const;
+    void testBannedForIP(STKPeer* peer);
+    void testBannedForOnlineId(STKPeer* peer, uint32_t online_id);
     void writeDisconnectInfoTable(STKPeer* peer);
     void writePlayerReport(Event* event);
 public:
@@ -0,0 +1,203 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/race_recorder.hpp"
+
+#include "io/file_manager.hpp"
+#include "network/network_string.hpp"
+#include "network/remote_kart_info.hpp"
+#include "network/server_config.hpp"
+#include "race/race_manager.hpp"
+#include "utils/constants.hpp"
+#include "utils/log.hpp"
+#include "utils/string_utils.hpp"
+#include "utils/time.hpp"
+#include "utils/vs.hpp"
+
+#include <functional>
+
+namespace
+{
+    /** Records are written to the file when this many bytes are buffered. */
+    const unsigned FLUSH_SIZE = 64 * 1024;
+}   // namespace
+
+// ----------------------------------------------------------------------------
+/** Creates a new recording file in the given directory for the race which
+ *  was just loaded. The file is named after the start time and the track.
+ *  \param directory Directory to store the file in, created if needed.
+ */
+RaceRecorder::RaceRecorder(const std::string& directory)
+{
+    m_buffer.reset(new BareNetworkString(FLUSH_SIZE + 1024));
+    m_exit = false;
+    m_failed.store(false);
+    m_file = NULL;
+    file_manager->checkAndCreateDirectoryP(directory);
+    // Server instances can start a race on the same track at the same time
+    m_filename = ServerConfig::getInstanceFileName(directory + "/" +
+        StringUtils::toString(StkTime::getTimeSinceEpoch()) + "-" +
+        race_manager->getTrackName() + ".stkrec");
+    m_file = fopen(m_filename.c_str(), "wb");
+    if (!m_file)
+    {
+        Log::error("RaceRecorder", "Can't open '%s' to record the race.",
+                   m_filename.c_str());
+        return;
+    }
+    Log::info("RaceRecorder", "Recording race to '%s'.", m_filename.c_str());
+    writeHeader();
+    m_thread = std::thread(std::bind(&RaceRecorder::writerLoop, this));
+}   // RaceRecorder
+
+// ----------------------------------------------------------------------------
+/** Writes all remaining records, then stops the writer thread and closes the
+ *  file.
+ */
+RaceRecorder::~RaceRecorder()
+{
+    if (!m_file)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_buffer_mutex);
+        queueBuffer();
+        m_exit = true;
+    }
+    m_buffer_cv.notify_all();
+    m_thread.join();
+    fclose(m_file);
+}   // ~RaceRecorder
+
+// ----------------------------------------------------------------------------
+/** Adds the header describing the race to the buffer.
+ */
+void RaceRecorder::writeHeader()
+{
+    RaceManager* rm = race_manager;
+    m_buffer->addUInt8('S').addUInt8('T').addUInt8('K').addUInt8('R')
+        .addUInt8(FORMAT_VERSION).encodeString(std::string(STK_VERSION))
+        .encodeString(rm->getTrackName())
+        .encodeString(rm->getMinorModeName())
+        .addUInt8(rm->getReverseTrack() ? 1 : 0)
+        .addUInt8((uint8_t)rm->getNumLaps())
+        .addUInt8((uint8_t)rm->getDifficulty())
+        .addUInt64(StkTime::getTimeSinceEpoch());
+
+    const unsigned num_karts = rm->getNumberOfKarts();
+    m_buffer->addUInt8((uint8_t)num_karts);
+    for (unsigned i = 0; i < num_karts; i++)
+    {
+        const RemoteKartInfo& rki = rm->getKartInfo(i);
+        m_buffer->encodeString(rki.getKartName())
+            .encodeString(rki.getPlayerName());
+    }
+}   // writeHeader
+
+// ----------------------------------------------------------------------------
+/** Hands the buffered records to the writer thread and starts a new buffer.
+ *  The caller must hold m_buffer_mutex.
+ */
+void RaceRecorder::queueBuffer()
+{
+    if (m_buffer->getTotalSize() == 0)
+        return;
+    m_full_buffers.push_back(std::move(m_buffer));
+    m_buffer.reset(new BareNetworkString(FLUSH_SIZE + 1024));
+}   // queueBuffer
+
+// ----------------------------------------------------------------------------
+/** The writer thread, which writes full buffers to the file until it is
+ *  told to exit and no buffer is left. The file is written without holding
+ *  the mutex, so adding records never waits for the disk.
+ */
+void RaceRecorder::writerLoop()
+{
+    VS::setThreadName("RaceRecorder");
+    while (true)
+    {
+        std::deque<std::unique_ptr<BareNetworkString> > buffers;
+        {
+            std::unique_lock<std::mutex> ul(m_buffer_mutex);
+            m_buffer_cv.wait(ul, [this]()
+                {
+                    return m_exit || !m_full_buffers.empty();
+                });
+            if (m_full_buffers.empty())
+                return;
+            std::swap(buffers, m_full_buffers);
+        }
+
+        for (auto& buffer : buffers)
+        {
+            if (m_failed.load())
+                break;
+            if (fwrite(buffer->getData(), 1, buffer->getTotalSize(),
+                m_file) != buffer->getTotalSize())
+            {
+                Log::error("RaceRecorder",
+                    "Can't write to '%s', recording stopped.",
+                    m_filename.c_str());
+                m_failed.store(true);
+            }
+        }
+    }
+}   // writerLoop
+
+// ----------------------------------------------------------------------------
+/** Adds a state sent by the server.
+ *  \param ticks World ticks of the state.
+ *  \param state The complete state message.
+ */
+void RaceRecorder::addState(int ticks, const NetworkString& state)
+{
+    if (!m_file || m_failed.load())
+        return;
+    std::lock_guard<std::mutex> lock(m_buffer_mutex);
+    m_buffer->addUInt8(RR_STATE).addUInt32(ticks)
+        .addUInt32(state.getTotalSize());
+    const uint8_t* data = (const uint8_t*)state.getData();
+    m_buffer->getBuffer().insert(m_buffer->getBuffer().end(), data,
+                                 data + state.getTotalSize());
+    if (m_buffer->getTotalSize() >= FLUSH_SIZE)
+    {
+        queueBuffer();
+        m_buffer_cv.notify_all();
+    }
+}   // addState
+
+// ----------------------------------------------------------------------------
+/** Adds a controller action received by the server from a client.
+ *  \param ticks World ticks at which the action happened.
+ *  \param kart_id The kart which triggered the action.
+ *  \param w, x, y, z The compressed action.
+ */
+void RaceRecorder::addControllerAction(int ticks, uint8_t kart_id, uint8_t w,
+                                       uint16_t x, uint16_t y, uint16_t z)
+{
+    if (!m_file || m_failed.load())
+        return;
+    std::lock_guard<std::mutex> lock(m_buffer_mutex);
+    m_buffer->addUInt8(RR_CONTROLLER_ACTION).addUInt32(ticks)
+        .addUInt8(kart_id).addUInt8(w).addUInt16(x).addUInt16(y)
+        .addUInt16(z);
+    if (m_buffer->getTotalSize() >= FLUSH_SIZE)
+    {
+        queueBuffer();
+        m_buffer_cv.notify_all();
+    }
+}   // addControllerAction
@@ -0,0 +1,112 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_RACE_RECORDER_HPP
+#define HEADER_RACE_RECORDER_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class BareNetworkString;
+class NetworkString;
+
+/** Records a race on the server by appending the states and controller
+ *  events it already sends to the clients to a file, so a race can be
+ *  investigated later without simulating it again. The file starts with a
+ *  header:
+ *  - UInt32 magic "STKR", UInt8 format version,
+ *  - strings STK version, track and minor mode, UInt8 reverse, laps and
+ *    difficulty, UInt64 start time in seconds since 1.1.1970,
+ *  - UInt8 number of karts, then for each kart the kart and player name.
+ *
+ *  Followed by records until the end of the file, each starting with the
+ *  UInt8 record type and UInt32 world ticks:
+ *  - RR_STATE: UInt32 size and the complete state message (with the
+ *    rewinder names) as sent to clients without delta state support,
+ *  - RR_CONTROLLER_ACTION: UInt8 kart id and the compressed action (UInt8,
+ *    3 * UInt16) as in GameProtocol::handleControllerAction.
+ *
+ *  Records are collected in memory and written in large blocks by a
+ *  separate thread, so the recording can be left enabled on a busy server.
+ *  Events can be added from any thread.
+ *  \ingroup network
+ */
+class RaceRecorder : public NoCopy
+{
+public:
+    /** The type of each record after the header. */
+    enum RecordType
+    {
+        RR_STATE = 0,
+        RR_CONTROLLER_ACTION = 1
+    };
+
+private:
+    /** Version of the file format, increase it on any change. */
+    static const uint8_t FORMAT_VERSION = 1;
+
+    /** Protects m_buffer, m_full_buffers and m_exit. */
+    std::mutex m_buffer_mutex;
+
+    /** Signals the writer thread that there are full buffers to write. */
+    std::condition_variable m_buffer_cv;
+
+    /** Records added since the buffer was last handed to the writer thread. */
+    std::unique_ptr<BareNetworkString> m_buffer;
+
+    /** Buffers waiting to be written by the writer thread. */
+    std::deque<std::unique_ptr<BareNetworkString> > m_full_buffers;
+
+    bool m_exit;
+
+    /** Set by the writer thread if writing failed, no more records are
+     *  added then. */
+    std::atomic_bool m_failed;
+
+    /** Only used by the writer thread after the constructor. */
+    FILE* m_file;
+
+    std::string m_filename;
+
+    std::thread m_thread;
+
+    void writeHeader();
+    void queueBuffer();
+    void writerLoop();
+
+public:
+    RaceRecorder(const std::string& directory);
+    ~RaceRecorder();
+    void addState(int ticks, const NetworkString& state);
+    void addControllerAction(int ticks, uint8_t kart_id, uint8_t w,
+                             uint16_t x, uint16_t y, uint16_t z);
+    // ------------------------------------------------------------------------
+    /** Returns if the file was opened successfully. */
+    bool isRecording() const                      { return m_file != NULL; }
+};   // class RaceRecorder
+
+#endif
@@ -22,6 +22,71 @@
 #include "network/rewinder.hpp"
 #include "network/rewind_manager.hpp"
 #include "items/projectile_manager.hpp"
+#include "utils/lock_free_queue.hpp"
+
+namespace RewindInfoPool
+{
+    /** RewindInfo are created and deleted for each state and event, so their
+     *  memory is reused. All subclasses are small, each is allocated from
+     *  the pool of the smallest size class it fits in. */
+    const size_t SIZE_CLASSES = 3;
+    const size_t CLASS_SIZE[SIZE_CLASSES] = { 64, 128, 256 };
+    // ------------------------------------------------------------------------
+    /** Returns the size class of an object, or SIZE_CLASSES if it is too big
+     *  to be pooled. */
+    size_t getSizeClass(size_t size)
+    {
+        size_t i = 0;
+        while (i < SIZE_CLASSES && size > CLASS_SIZE[i])
+            i++;
+        return i;
+    }   // getSizeClass
+    // ------------------------------------------------------------------------
+    /** Returns the pool of unused memory blocks of a size class. It is never
+     *  freed, so it can be used by rewind infos deleted at exit. */
+    LockFreeQueue<void*>* getPool(size_t size_class)
+    {
+        static LockFreeQueue<void*>* pools[SIZE_CLASSES] =
+        {
+            new LockFreeQueue<void*>(1024), new LockFreeQueue<void*>(1024),
+            new LockFreeQueue<void*>(1024)
+        };
+        return pools[size_class];
+    }   // getPool
+}   // namespace RewindInfoPool
+
+// ============================================================================
+/** Allocates memory for a rewind info, reusing memory of a deleted rewind
+ *  info of the same size class if possible. Rewind infos can be created by
+ *  the network thread, so the pools are lock-free.
+ */
+void* RewindInfo::operator new(size_t size)
+{
+    size_t size_class = RewindInfoPool::getSizeClass(size);
+    if (size_class == RewindInfoPool::SIZE_CLASSES)
+        return ::operator new(size);
+    void* ptr = NULL;
+    if (RewindInfoPool::getPool(size_class)->pop(&ptr))
+        return ptr;
+    return ::operator new(RewindInfoPool::CLASS_SIZE[size_class]);
+}   // operator new
+
+// ----------------------------------------------------------------------------
+/** Puts the memory of a deleted rewind info back into its pool, or frees it
+ *  if the pool is full.
+ *  \param size Size of the deleted (most derived) object.
+ */
+void RewindInfo::operator delete(void* ptr, size_t size)
+{
+    if (ptr == NULL)
+        return;
+    size_t size_class = RewindInfoPool::getSizeClass(size);
+    if (size_class == RewindInfoPool::SIZE_CLASSES ||
+        !RewindInfoPool::getPool(size_class)->push(ptr))
+        ::operator delete(ptr);
+}   // operator delete
+
+// ============================================================================
 
 /** Constructor for a state: it only takes the size, and allocates a buffer
  *  for all state info.
@@ -97,6 +162,13 @@ void RewindInfoState::restore()
             m_buffer->skip(data_size);
             continue;
         }
+        if (data_size == 0 && name[0] == RN_KART)
+        {
+            // Omitted by the server as not relevant for this client, other
+            // rewinders (e.g. the item manager) can have an empty state
+            RewindManager::get()->restorePredictedState(getTicks(), r.get());
+            continue;
+        }
         try
         {
             r->restoreState(m_buffer, data_size);
@@ -26,6 +26,7 @@
 #include "utils/ptr_vector.hpp"
 
 #include <assert.h>
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <vector>
@@ -58,6 +59,8 @@ public:
     RewindInfo(int ticks, bool is_confirmed);
 
     void setTicks(int ticks);
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr, size_t size);
 
     /** Called when going back in time to undo any rewind information. */
     virtual void undo() = 0;
@@ -114,6 +117,13 @@ public:
     /** Returns a pointer to the state buffer. */
     BareNetworkString *getBuffer() const { return m_buffer; }
     // ------------------------------------------------------------------------
+    /** Returns the offset of the data of the first rewinder in the buffer. */
+    int getStartOffset() const { return m_start_offset; }
+    // ------------------------------------------------------------------------
+    /** Returns the identities of the rewinders in this state. */
+    const std::vector<std::string>& getRewinderUsing() const
+                                                  { return m_rewinder_using; }
+    // ------------------------------------------------------------------------
     virtual bool isState() const { return true; }
     // ------------------------------------------------------------------------
     /** Called when going back in time to undo any rewind information.
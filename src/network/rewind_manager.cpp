@@ -35,9 +35,40 @@
 #include "utils/profiler.hpp"
 
 #include <algorithm>
+#include <cstdio>
 
 RewindManager* RewindManager::m_rewind_manager = NULL;
 bool           RewindManager::m_enable_rewind_manager = false;
+bool           RewindManager::m_desync_debugging = false;
+
+// ----------------------------------------------------------------------------
+/** FNV-1a hash of the state of a rewinder, used for desync debugging so the
+ *  same state can be recognised in the server and client logs. */
+static uint32_t hashState(const char* data, unsigned size)
+{
+    uint32_t hash = 2166136261u;
+    for (unsigned i = 0; i < size; i++)
+    {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}   // hashState
+
+// ----------------------------------------------------------------------------
+/** Returns the unique identity of a rewinder in hex, as it contains binary
+ *  data. */
+static std::string getLogName(const std::string& uid)
+{
+    std::string name;
+    char hex[3];
+    for (char c : uid)
+    {
+        snprintf(hex, 3, "%02x", (uint8_t)c);
+        name += hex;
+    }
+    return name;
+}   // getLogName
 
 /** Creates the singleton. */
 RewindManager *RewindManager::create()
@@ -61,6 +92,7 @@ void RewindManager::destroy()
  */
 RewindManager::RewindManager()
 {
+    m_checked_states = 0;
     reset();
 }   // RewindManager
 
@@ -70,11 +102,26 @@ RewindManager::RewindManager()
  */
 RewindManager::~RewindManager()
 {
+    logDesyncSummary();
     for (RewindInfoEventFunction* rief : m_pending_rief)
         delete rief;
     m_pending_rief.clear();
 }   // ~RewindManager
 
+// ----------------------------------------------------------------------------
+/** Logs how many server states differed from the prediction in the race
+ *  that just finished, if desync debugging is enabled.
+ */
+void RewindManager::logDesyncSummary() const
+{
+    if (m_desync_debugging && m_checked_states > 0)
+    {
+        Log::info("RewindManager", "Desync debugging: %d of %d server "
+            "states differed from the prediction, first at tick %d.",
+            m_desync_states, m_checked_states, m_first_desync_ticks);
+    }
+}   // logDesyncSummary
+
 // ----------------------------------------------------------------------------
 /** Frees all saved state information and all destroyable rewinder.
  */
@@ -83,6 +130,12 @@ void RewindManager::reset()
     m_is_rewinding = false;
     m_not_rewound_ticks.store(0);
     m_overall_state_size = 0;
+    // Each race is reported on its own
+    logDesyncSummary();
+    m_checked_states = 0;
+    m_desync_states = 0;
+    m_first_desync_ticks = -1;
+    m_latest_past_event_ticks = -1;
     m_state_frequency = stk_config->getPhysicsFPS() /
         NetworkConfig::get()->getStateFrequency();
 
@@ -90,6 +143,16 @@ void RewindManager::reset()
 
     clearExpiredRewinder();
     m_rewind_queue.reset();
+    m_predicted_state.clear();
+
+    // Flyables of a previous race are removed at this stage, so only the
+    // rewinders created with the world get an id
+    m_rewinder_names.clear();
+    for (auto& p : m_all_rewinder)
+    {
+        if (!p.second.expired())
+            m_rewinder_names.push_back(p.first);
+    }
 }   // reset
 
 // ----------------------------------------------------------------------------    
@@ -167,6 +230,13 @@ void RewindManager::saveState()
             buffer = r->saveState(&rewinder_using);
         if (buffer != NULL)
         {
+            if (m_desync_debugging)
+            {
+                Log::verbose("RewindManager", "State %d %s hash %08x",
+                    World::getWorld()->getTicksSinceStart(),
+                    getLogName(p.first).c_str(),
+                    hashState(buffer->getData(), buffer->getTotalSize()));
+            }
             m_overall_state_size += buffer->size();
             gp->addState(buffer);
         }
@@ -176,6 +246,236 @@ void RewindManager::saveState()
     PROFILER_POP_CPU_MARKER();
 }   // saveState
 
+// ----------------------------------------------------------------------------
+/** Returns if a client can predict the state of a rewinder in the format the
+ *  server sends it. Others, like flyables, need to be confirmed by the server.
+ *  \param uid Unique identity of the rewinder.
+ */
+static bool isPredictable(const std::string& uid)
+{
+    if (uid.empty())
+        return false;
+    switch (uid[0])
+    {
+    case RN_KART:
+    case RN_RED_FLAG:
+    case RN_BLUE_FLAG:
+    case RN_PHYSICAL_OBJ:
+        return true;
+    default:
+        return false;
+    }
+}   // isPredictable
+
+// ----------------------------------------------------------------------------
+/** Saves on a client the state of all predictable rewinders as predicted
+ *  locally. It is compared with the state received from the server to skip
+ *  unneeded rewinds, and it is restored for karts which the server omitted
+ *  from a state because they are far away from the karts of this client.
+ *  \param ticks Ticks of the state.
+ */
+void RewindManager::savePredictedState(int ticks)
+{
+    auto& predicted = m_predicted_state[ticks];
+    for (auto& p : m_all_rewinder)
+    {
+        if (!isPredictable(p.first))
+            continue;
+        if (auto r = p.second.lock())
+            predicted[p.first].reset(r->savePredictedState());
+    }
+}   // savePredictedState
+
+// ----------------------------------------------------------------------------
+/** Checks on a client if the state received from the server is identical to
+ *  the state predicted locally for the same time. Client and server round
+ *  all physics values the same way when saving a state, so a correct
+ *  prediction gives exactly the same data, and no rewind is needed.
+ *  \param ticks Time of the state received from the server.
+ */
+bool RewindManager::isPredictionCorrect(int ticks)
+{
+    auto predicted = m_predicted_state.find(ticks);
+    if (predicted == m_predicted_state.end())
+        return false;
+    RewindInfoState* state =
+        dynamic_cast<RewindInfoState*>(m_rewind_queue.getConfirmedState(ticks));
+    if (!state)
+        return false;
+
+    for (auto& p : m_all_rewinder)
+    {
+        if (!p.second.expired() && p.first[0] != RN_ITEM_MANAGER &&
+            !isPredictable(p.first))
+            return false;
+    }
+
+    const std::vector<std::string>& rewinder_using =
+        state->getRewinderUsing();
+    BareNetworkString* buffer = state->getBuffer();
+    buffer->reset();
+    buffer->skip(state->getStartOffset());
+    try
+    {
+        for (const std::string& name : rewinder_using)
+        {
+            const uint16_t data_size = buffer->getUInt16();
+            if (data_size > buffer->size())
+                return false;
+            const char* data = buffer->getCurrentData();
+            buffer->skip(data_size);
+            // No item events which need to be applied
+            if (name[0] == RN_ITEM_MANAGER)
+            {
+                if (data_size != 0)
+                    return false;
+                continue;
+            }
+            // Kart omitted as not relevant for this client
+            if (data_size == 0 && name[0] == RN_KART)
+                continue;
+            auto it = predicted->second.find(name);
+            if (it == predicted->second.end() || !it->second)
+                return false;
+            const BareNetworkString* p = it->second.get();
+            if (p->getTotalSize() != data_size ||
+                memcmp(p->getData(), data, data_size) != 0)
+                return false;
+        }
+    }
+    catch (std::exception& e)
+    {
+        Log::warn("RewindManager", "Invalid state at %d: %s", ticks,
+            e.what());
+        return false;
+    }
+
+    // The server only omits physical objects which did not move
+    for (auto& p : predicted->second)
+    {
+        if (p.second && p.first[0] != RN_PHYSICAL_OBJ &&
+            std::find(rewinder_using.begin(), rewinder_using.end(),
+            p.first) == rewinder_using.end())
+            return false;
+    }
+    return true;
+}   // isPredictionCorrect
+
+// ----------------------------------------------------------------------------
+/** Compares on a client each rewinder in the state received from the server
+ *  with the state predicted locally, and logs the rewinders which differ.
+ *  It is only called if all events up to the state were known when the
+ *  state was predicted, so any difference means that the client simulation
+ *  diverged from the server (e.g. a non-deterministic update).
+ *  \param ticks Time of the state received from the server.
+ */
+void RewindManager::reportDesync(int ticks)
+{
+    auto predicted = m_predicted_state.find(ticks);
+    if (predicted == m_predicted_state.end())
+        return;
+    RewindInfoState* state =
+        dynamic_cast<RewindInfoState*>(m_rewind_queue.getConfirmedState(ticks));
+    if (!state)
+        return;
+
+    bool desync = false;
+    BareNetworkString* buffer = state->getBuffer();
+    buffer->reset();
+    buffer->skip(state->getStartOffset());
+    try
+    {
+        for (const std::string& name : state->getRewinderUsing())
+        {
+            const uint16_t data_size = buffer->getUInt16();
+            if (data_size > buffer->size())
+                break;
+            const char* data = buffer->getCurrentData();
+            buffer->skip(data_size);
+            auto it = predicted->second.find(name);
+            if (data_size == 0 || it == predicted->second.end() ||
+                !it->second)
+                continue;
+            const BareNetworkString* p = it->second.get();
+            const unsigned predicted_size = p->getTotalSize();
+            unsigned offset = 0;
+            while (offset < predicted_size && offset < data_size &&
+                   p->getData()[offset] == data[offset])
+                offset++;
+            if (offset == predicted_size && offset == data_size)
+                continue;
+            desync = true;
+            Log::warn("RewindManager", "Desync at tick %d in rewinder %s "
+                "(id %d): first difference at byte %d, size %d/%d, "
+                "hash %08x/%08x (predicted/server).", ticks,
+                getLogName(name).c_str(), getRewinderId(name), offset,
+                predicted_size, data_size,
+                hashState(p->getData(), predicted_size),
+                hashState(data, data_size));
+        }
+    }
+    catch (std::exception& e)
+    {
+        Log::warn("RewindManager", "Invalid state at %d: %s", ticks,
+            e.what());
+        return;
+    }
+
+    m_checked_states++;
+    if (!desync)
+        return;
+    m_desync_states++;
+    if (m_first_desync_ticks == -1)
+    {
+        m_first_desync_ticks = ticks;
+        Log::warn("RewindManager", "First desync at tick %d.", ticks);
+    }
+}   // reportDesync
+
+// ----------------------------------------------------------------------------
+/** Discards all local and predicted states up to the given time, which are
+ *  not needed anymore once a server state for this time is confirmed.
+ *  \param ticks Time of the confirmed server state.
+ */
+void RewindManager::clearLocalStates(int ticks)
+{
+    m_local_state.erase(m_local_state.begin(),
+        m_local_state.upper_bound(ticks));
+    m_predicted_state.erase(m_predicted_state.begin(),
+        m_predicted_state.upper_bound(ticks));
+}   // clearLocalStates
+
+// ----------------------------------------------------------------------------
+/** Restores the state of a rewinder which the server omitted from a state,
+ *  because it is not relevant for this client. The locally predicted state
+ *  is used, or the current state if there is no prediction (e.g. after live
+ *  join), which also tells the rewinder it is still present on the server.
+ *  \param ticks Ticks of the state.
+ *  \param r The rewinder to restore.
+ */
+void RewindManager::restorePredictedState(int ticks, Rewinder* r)
+{
+    BareNetworkString* buffer = NULL;
+    std::unique_ptr<BareNetworkString> current_state;
+    auto it = m_predicted_state.find(ticks);
+    if (it != m_predicted_state.end())
+    {
+        auto state = it->second.find(r->getUniqueIdentity());
+        if (state != it->second.end())
+            buffer = state->second.get();
+    }
+    if (!buffer)
+    {
+        std::vector<std::string> rewinder_using;
+        current_state.reset(r->saveState(&rewinder_using));
+        buffer = current_state.get();
+        if (!buffer)
+            return;
+    }
+    buffer->reset();
+    r->restoreState(buffer, buffer->getTotalSize());
+}   // restorePredictedState
+
 // ----------------------------------------------------------------------------
 /** Determines if a new state snapshot should be taken, and if so calls all
  *  rewinder to do so.
@@ -185,11 +485,17 @@ void RewindManager::update(int ticks_not_used)
 {
     // FIXME: rename ticks_not_used
     if (!m_enable_rewind_manager ||
-        m_all_rewinder.size() == 0 ||
-        m_is_rewinding)  return;
+        m_all_rewinder.size() == 0)  return;
 
     int ticks = World::getWorld()->getTicksSinceStart();
 
+    if (m_is_rewinding)
+    {
+        if (NetworkConfig::get()->isClient() && shouldSaveState(ticks))
+            savePredictedState(ticks);
+        return;
+    }
+
     m_not_rewound_ticks.store(ticks, std::memory_order_relaxed);
 
     if (!shouldSaveState(ticks))
@@ -205,6 +511,7 @@ void RewindManager::update(int ticks_not_used)
             if (auto r = p.second.lock())
                 ret.push_back(r->getLocalStateRestoreFunction());
         }
+        savePredictedState(ticks);
     }
     else
     {
@@ -230,12 +537,32 @@ void RewindManager::playEventsTill(int world_ticks, bool fast_forward)
     mergeRewindInfoEventFunction();
     bool needs_rewind;
     int rewind_ticks;
+    int latest_event_ticks;
 
     // Merge in all network events that have happened at the current
     // time step.
     // merge and that have happened before the current time (which will
     // be getTime()+dt - world time has not been updated yet).
-    m_rewind_queue.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks);
+    m_rewind_queue.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks,
+        &latest_event_ticks);
+    if (latest_event_ticks > m_latest_past_event_ticks)
+        m_latest_past_event_ticks = latest_event_ticks;
+
+    // If the state from the server is what this client predicted, and no
+    // events (also those received in earlier frames) need to be replayed,
+    // a rewind would not change anything
+    if (needs_rewind && m_latest_past_event_ticks < rewind_ticks)
+    {
+        if (isPredictionCorrect(rewind_ticks))
+        {
+            if (m_desync_debugging)
+                m_checked_states++;
+            needs_rewind = false;
+            clearLocalStates(rewind_ticks);
+        }
+        else if (m_desync_debugging)
+            reportDesync(rewind_ticks);
+    }
 
     if (needs_rewind)
     {
@@ -292,6 +619,8 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
     assert(!m_is_rewinding);
     bool is_history = history->replayHistory();
     history->setReplayHistory(false);
+    // All events received so far are replayed now
+    m_latest_past_event_ticks = -1;
 
     // First save all current transforms so that the error
     // can be computed between the transforms before and after
@@ -357,6 +686,10 @@ void RewindManager::rewindTo(int rewind_ticks, int now_ticks,
         current = m_rewind_queue.getCurrent();
     }
 
+    // Later predictions belong to the timeline which is corrected now, they
+    // are saved again while replaying
+    m_predicted_state.clear();
+
     // Update check line, so the cannon animation can be replayed correctly
     CheckManager::get()->resetAfterRewind();
 
@@ -428,3 +761,36 @@ void RewindManager::resetSmoothNetworkBody()
         }
     }
 }   // resetSmoothNetworkBody
+
+// ----------------------------------------------------------------------------
+/** Tests that rewinders only get ids which can be sent in one byte without
+ *  clashing with GameProtocol::RI_NAME, even with more than 255 rewinders.
+ */
+void RewindManager::unitTesting()
+{
+    RewindManager rm;
+    for (unsigned i = 0; i < 300; i++)
+    {
+        char name[8];
+        snprintf(name, 8, "r%03u", i);
+        rm.m_rewinder_names.push_back(name);
+    }
+    assert(rm.getRewinderId("r000") == 0);
+    assert(rm.getRewinderId("r254") == 254);
+    assert(rm.getRewinderId("r255") == -1);
+    assert(rm.getRewinderId("r299") == -1);
+    assert(rm.getRewinderId("r300") == -1);
+    assert(*rm.getRewinderName(0) == "r000");
+    assert(*rm.getRewinderName(254) == "r254");
+    assert(rm.getRewinderName(255) == NULL);
+    assert(rm.getRewinderName(299) == NULL);
+    for (unsigned i = 0; i < 300; i++)
+    {
+        char name[8];
+        snprintf(name, 8, "r%03u", i);
+        const int id = rm.getRewinderId(name);
+        assert(id < (int)MAX_REWINDER_IDS);
+        if (id != -1)
+            assert(*rm.getRewinderName(id) == name);
+    }
+}   // unitTesting
@@ -23,6 +23,7 @@
 #include "utils/ptr_vector.hpp"
 #include "utils/synchronised.hpp"
 
+#include <algorithm>
 #include <assert.h>
 #include <atomic>
 #include <functional>
@@ -94,9 +95,22 @@ private:
 
     std::map<int, std::vector<std::function<void()> > > m_local_state;
 
+    /** Client only: the states of all predictable rewinders as predicted by
+     *  this client. Used to skip rewinds if the server state is identical,
+     *  and for karts which the server omits from a state because they are
+     *  far away from the karts of this client. NULL entries are rewinders
+     *  which did not save a state. */
+    std::map<int, std::map<std::string, std::unique_ptr<BareNetworkString> > >
+        m_predicted_state;
+
     /** A list of all objects that can be rewound. */
     std::map<std::string, std::weak_ptr<Rewinder> > m_all_rewinder;
 
+    /** Sorted unique identities of all rewinders which exist when the race
+     *  starts. Server and clients have the same rewinders at this time, so
+     *  the index in this list can be sent in states instead of the name. */
+    std::vector<std::string> m_rewinder_names;
+
     /** The queue that stores all rewind infos. */
     RewindQueue m_rewind_queue;
 
@@ -116,6 +130,22 @@ private:
 
     std::vector<RewindInfoEventFunction*> m_pending_rief;
 
+    /** Client only with desync debugging: number of server states compared
+     *  with the prediction, and how many of them differed. */
+    unsigned m_checked_states;
+
+    unsigned m_desync_states;
+
+    /** Ticks of the first server state which differed from the prediction,
+     *  or -1. */
+    int m_first_desync_ticks;
+
+    /** Client only: latest ticks of the network events received for a time
+     *  in the past since the last rewind, or -1. These events are only
+     *  replayed by the next rewind, so it must not be skipped if one of
+     *  them is not before the state to rewind to. */
+    int m_latest_past_event_ticks;
+
     RewindManager();
    ~RewindManager();
     // ------------------------------------------------------------------------
@@ -133,12 +163,27 @@ private:
     }
     // ------------------------------------------------------------------------
     void mergeRewindInfoEventFunction();
+    void savePredictedState(int ticks);
+    bool isPredictionCorrect(int ticks);
+    void reportDesync(int ticks);
+    void logDesyncSummary() const;
+    void clearLocalStates(int ticks);
 
 public:
+    /** If set, clients compare each server state with the locally predicted
+     *  state when all inputs up to that state were known, and log the
+     *  rewinders which differ. The server logs a hash of each state. */
+    static bool m_desync_debugging;
+
+    /** Rewinder ids are sent as one byte, and the highest value is reserved
+     *  for rewinders sent by name, so only the first rewinders get an id. */
+    static const unsigned MAX_REWINDER_IDS = 255;
+
     // First static functions to manage rewinding.
     // ===========================================
     static RewindManager *create();
     static void destroy();
+    static void unitTesting();
     // ------------------------------------------------------------------------
     /** En- or disables rewinding. */
     static void setEnable(bool m) { m_enable_rewind_manager = m; }
@@ -166,6 +211,7 @@ public:
                          BareNetworkString *buffer, int ticks);
     void addNetworkState(BareNetworkString *buffer, int ticks);
     void saveState();
+    void restorePredictedState(int ticks, Rewinder* r);
     // ------------------------------------------------------------------------
     std::shared_ptr<Rewinder> getRewinder(const std::string& name)
     {
@@ -178,6 +224,26 @@ public:
         return nullptr;
     }
     // ------------------------------------------------------------------------
+    /** Returns the id of a rewinder which existed when the race started, or
+     *  -1 if it has no id (e.g. flyables). */
+    int getRewinderId(const std::string& name) const
+    {
+        auto it = std::lower_bound(m_rewinder_names.begin(),
+                                   m_rewinder_names.end(), name);
+        if (it == m_rewinder_names.end() || *it != name)
+            return -1;
+        const int id = (int)(it - m_rewinder_names.begin());
+        return id < (int)MAX_REWINDER_IDS ? id : -1;
+    }   // getRewinderId
+    // ------------------------------------------------------------------------
+    /** Returns the unique identity of a rewinder from its id, or NULL if the
+     *  id is unknown. */
+    const std::string* getRewinderName(unsigned id) const
+    {
+        return id < m_rewinder_names.size() && id < MAX_REWINDER_IDS ?
+            &m_rewinder_names[id] : NULL;
+    }   // getRewinderName
+    // ------------------------------------------------------------------------
     bool addRewinder(std::shared_ptr<Rewinder> rewinder);
     // ------------------------------------------------------------------------
     /** Returns true if currently a rewind is happening. */
@@ -26,6 +26,7 @@
 #include "network/rewinder.hpp"
 #include "network/rewind_info.hpp"
 #include "network/rewind_manager.hpp"
+#include "network/server_metrics.hpp"
 
 #include <algorithm>
 
@@ -45,6 +46,10 @@
  */
 RewindQueue::RewindQueue()
 {
+    // Enough for a few seconds of states and events, it grows if necessary
+    m_all_rewind_info.resize(512, NULL);
+    m_first = 0;
+    m_count = 0;
     reset();
 }   // RewindQueue
 
@@ -74,12 +79,15 @@ void RewindQueue::reset()
     m_network_events.getData().clear();
     m_network_events.unlock();
 
-    AllRewindInfo::const_iterator i;
-    for (i = m_all_rewind_info.begin(); i != m_all_rewind_info.end(); ++i)
-        delete *i;
+    for (unsigned int i = 0; i < m_count; i++)
+    {
+        delete at(i);
+        at(i) = NULL;
+    }
 
-    m_all_rewind_info.clear();
-    m_current = m_all_rewind_info.end();
+    m_first = 0;
+    m_count = 0;
+    m_current = 0;
     m_latest_confirmed_state_time = -1;
 }   // reset
 
@@ -94,25 +102,51 @@ void RewindQueue::reset()
  */
 void RewindQueue::insertRewindInfo(RewindInfo *ri)
 {
-    AllRewindInfo::iterator i = m_all_rewind_info.end();
-
-    while (i != m_all_rewind_info.begin())
+    if (m_count == m_all_rewind_info.size())
     {
-        AllRewindInfo::iterator i_prev = i;
-        i_prev--;
-        // Now test if 'ri' needs to be inserted after the
-        // previous element, i.e. before the current element:
-        if ((*i_prev)->getTicks() < ri->getTicks()) break;
-        if ((*i_prev)->getTicks() == ri->getTicks() &&
-            ri->isEvent()                              ) break;
-        i = i_prev;
+        // Grow the ring buffer, which also moves the oldest info to index 0
+        std::vector<RewindInfo*> all_rewind_info(m_count * 2, NULL);
+        for (unsigned int n = 0; n < m_count; n++)
+            all_rewind_info[n] = at(n);
+        std::swap(m_all_rewind_info, all_rewind_info);
+        m_first = 0;
     }
-    if(m_current == m_all_rewind_info.end())
-        m_current = m_all_rewind_info.insert(i, ri);
-    else
-        m_all_rewind_info.insert(i, ri);  
+
+    const unsigned int i = findFirst(ri->getTicks(), ri->isEvent());
+    // Usually the new info is the latest one, otherwise move the later ones
+    m_count++;
+    for (unsigned int n = m_count - 1; n > i; n--)
+        at(n) = at(n - 1);
+    at(i) = ri;
+
+    if (m_current == m_count - 1)
+        m_current = i;
+    else if (i <= m_current)
+        m_current++;
 }   // insertRewindInfo
 
+// ----------------------------------------------------------------------------
+/** Returns the position of the first rewind info after the given time, or
+ *  m_count if there is none.
+ *  \param ticks Time in ticks.
+ *  \param after_same_ticks If set, rewind infos at the same time are before
+ *         the returned position, otherwise they are after it.
+ */
+unsigned int RewindQueue::findFirst(int ticks, bool after_same_ticks) const
+{
+    unsigned int low = 0, high = m_count;
+    while (low < high)
+    {
+        const unsigned int mid = (low + high) / 2;
+        const int mid_ticks = at(mid)->getTicks();
+        if (mid_ticks < ticks || (mid_ticks == ticks && after_same_ticks))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}   // findFirst
+
 // ----------------------------------------------------------------------------
 /** Adds an event to the rewind data. The data to be stored must be allocated
  *  and not freed by the caller!
@@ -197,11 +231,15 @@ void RewindQueue::addNetworkState(BareNetworkString *buffer, int ticks)
  *         performed.
  *  \param rewind_time[out] If needs_rewind is true, the time to which a rewind
  *         must be performed (at least). Otherwise undefined.
+ *  \param latest_event_ticks[out] If not NULL, the time of the latest
+ *         merged event before world_ticks, or -1 if there is none.
  */
 void RewindQueue::mergeNetworkData(int world_ticks, bool *needs_rewind,
-                                   int *rewind_ticks)
+                                   int *rewind_ticks, int *latest_event_ticks)
 {
     *needs_rewind = false;
+    if (latest_event_ticks)
+        *latest_event_ticks = -1;
     m_network_events.lock();
     if(m_network_events.getData().empty())
     {
@@ -257,6 +295,7 @@ void RewindQueue::mergeNetworkData(int world_ticks, bool *needs_rewind,
             // to be executed 'now' - at least we get a bit closer to the
             // client state.
             (*i)->setTicks(world_ticks);
+            ServerMetrics::get()->addLateEvent();
         }
 
         insertRewindInfo(*i);
@@ -283,6 +322,13 @@ void RewindQueue::mergeNetworkData(int world_ticks, bool *needs_rewind,
                 *rewind_ticks = (*i)->getTicks();
         }   // if client and ticks < world_ticks
 
+        if (latest_event_ticks && (*i)->isEvent() &&
+            (*i)->getTicks() < world_ticks &&
+            (*i)->getTicks() > *latest_event_ticks)
+        {
+            *latest_event_ticks = (*i)->getTicks();
+        }
+
         if ((*i)->isState() && (*i)->getTicks() > latest_confirmed_state &&
             (*i)->isConfirmed())
         {
@@ -321,31 +367,43 @@ void RewindQueue::mergeNetworkData(int world_ticks, bool *needs_rewind,
 
 }   // mergeNetworkData
 
+// ----------------------------------------------------------------------------
+/** Returns the confirmed state at the given time, or NULL if there is none.
+ *  \param ticks Time (in ticks).
+ */
+RewindInfo* RewindQueue::getConfirmedState(int ticks)
+{
+    for (unsigned int i = findFirst(ticks, /*after_same_ticks*/false);
+         i < m_count && at(i)->getTicks() == ticks; i++)
+    {
+        if (at(i)->isState() && at(i)->isConfirmed())
+            return at(i);
+    }
+    return NULL;
+}   // getConfirmedState
+
 // ----------------------------------------------------------------------------
 /** Deletes all states and event before the given time.
  *  \param ticks Time (in ticks).
  */
 void RewindQueue::cleanupOldRewindInfo(int ticks)
 {
-    auto i = m_all_rewind_info.begin();
-
-    while (!m_all_rewind_info.empty() &&
-        (*i)->getTicks() < ticks)
+    while (m_count > 0 && at(0)->getTicks() < ticks)
     {
-        if (m_current == i) next();
-        delete *i;
-        i = m_all_rewind_info.erase(i);
+        // If the current info is deleted, the next one becomes current
+        if (m_current > 0)
+            m_current--;
+        delete at(0);
+        at(0) = NULL;
+        m_first = (m_first + 1) & (m_all_rewind_info.size() - 1);
+        m_count--;
     }
-
-    if (m_all_rewind_info.empty())
-        m_current = m_all_rewind_info.end();
-
 }   // cleanupOldRewindInfo
 
 // ----------------------------------------------------------------------------
 bool RewindQueue::isEmpty() const
 {
-    return m_current == m_all_rewind_info.end();
+    return m_current == m_count;
 }   // isEmpty
 
 // ----------------------------------------------------------------------------
@@ -353,7 +411,7 @@ bool RewindQueue::isEmpty() const
  */
 bool RewindQueue::hasMoreRewindInfo() const
 {
-    return m_current != m_all_rewind_info.end();
+    return m_current < m_count;
 }   // hasMoreRewindInfo
 
 // ----------------------------------------------------------------------------
@@ -367,27 +425,26 @@ int RewindQueue::undoUntil(int undo_ticks)
 {
     // A rewind is done after a state in the past is inserted. This function
     // makes sure that m_current is not end()
-    //assert(m_current != m_all_rewind_info.end());
-    assert(!m_all_rewind_info.empty());
-    m_current = m_all_rewind_info.end();
-    m_current--;
-    while((*m_current)->getTicks() > undo_ticks ||
-        (*m_current)->isEvent() || !(*m_current)->isConfirmed())
+    assert(m_count > 0);
+    m_current = m_count - 1;
+    while(at(m_current)->getTicks() > undo_ticks ||
+        at(m_current)->isEvent() || !at(m_current)->isConfirmed())
     {
         // Undo all events and states from the current time
-        (*m_current)->undo();
-        if(m_current == m_all_rewind_info.begin())
+        at(m_current)->undo();
+        if(m_current == 0)
         {
             // This shouldn't happen, but add some debug info just in case
             Log::error("undoUntil",
                        "At %d rewinding to %d current = %d = begin",
                        World::getWorld()->getTicksSinceStart(), undo_ticks, 
-                       (*m_current)->getTicks());
+                       at(m_current)->getTicks());
+            break;
         }
         m_current--;
     }
 
-    return (*m_current)->getTicks();
+    return at(m_current)->getTicks();
 }   // undoUntil
 
 // ----------------------------------------------------------------------------
@@ -397,10 +454,10 @@ int RewindQueue::undoUntil(int undo_ticks)
 void RewindQueue::replayAllEvents(int ticks)
 {
     // Replay all events that happened at the current time step
-    while ( hasMoreRewindInfo() && (*m_current)->getTicks() == ticks )
+    while ( hasMoreRewindInfo() && at(m_current)->getTicks() == ticks )
     {
-        if ((*m_current)->isEvent())
-            (*m_current)->replay();
+        if (at(m_current)->isEvent())
+            at(m_current)->replay();
         m_current++;
     }   // while current->getTIcks == ticks
 
@@ -427,37 +484,37 @@ void RewindQueue::unitTesting()
     assert(!q0.hasMoreRewindInfo());
 
     q0.addLocalState(NULL, /*confirmed*/true, 0);
-    assert(q0.m_all_rewind_info.front()->isState());
-    assert(!q0.m_all_rewind_info.front()->isEvent());
+    assert(q0.at(0)->isState());
+    assert(!q0.at(0)->isEvent());
     assert(q0.hasMoreRewindInfo());
     assert(q0.undoUntil(0) == 0);
 
     q0.addNetworkEvent(dummy_rewinder.get(), NULL, 0);
     // Network events are not immediately merged
-    assert(q0.m_all_rewind_info.size() == 1);
+    assert(q0.m_count == 1);
 
     bool needs_rewind;
     int rewind_ticks;
     int world_ticks = 0;
     q0.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks);
     assert(q0.hasMoreRewindInfo());
-    assert(q0.m_all_rewind_info.size() == 2);
-    AllRewindInfo::iterator rii = q0.m_all_rewind_info.begin();
-    assert((*rii)->isState());
+    assert(q0.m_count == 2);
+    unsigned int rii = 0;
+    assert(q0.at(rii)->isState());
     rii++;
-    assert((*rii)->isEvent());
+    assert(q0.at(rii)->isEvent());
 
     // Another state must be sorted before the event:
     q0.addNetworkState(NULL, 0);
     assert(q0.hasMoreRewindInfo());
     q0.mergeNetworkData(world_ticks, &needs_rewind, &rewind_ticks);
-    assert(q0.m_all_rewind_info.size() == 3);
-    rii = q0.m_all_rewind_info.begin();
-    assert((*rii)->isState());
+    assert(q0.m_count == 3);
+    rii = 0;
+    assert(q0.at(rii)->isState());
     rii++;
-    assert((*rii)->isState());
+    assert(q0.at(rii)->isState());
     rii++;
-    assert((*rii)->isEvent());
+    assert(q0.at(rii)->isEvent());
 
     // Test time base comparisons: adding an event to the end
     q0.addLocalEvent(dummy_rewinder.get(), NULL, true, 4);
@@ -466,18 +523,18 @@ void RewindQueue::unitTesting()
     // rii points to the 3rd element, the ones added just now
     // should be elements4 and 5:
     rii++;
-    assert((*rii)->getTicks()==1);
+    assert(q0.at(rii)->getTicks()==1);
     rii++;
-    assert((*rii)->getTicks()==4);
+    assert(q0.at(rii)->getTicks()==4);
 
     // Now test inserting an event first, then the state
     RewindQueue q1;
     q1.addLocalEvent(NULL, NULL, true, 5);
     q1.addLocalState(NULL, true, 5);
-    rii = q1.m_all_rewind_info.begin();
-    assert((*rii)->isState());
+    rii = 0;
+    assert(q1.at(rii)->isState());
     rii++;
-    assert((*rii)->isEvent());
+    assert(q1.at(rii)->isEvent());
 
     // Bugs seen before
     // ----------------
@@ -496,7 +553,7 @@ void RewindQueue::unitTesting()
     //    event, that m_current pooints to the first event, otherwise
     //    events with same time stamp will not be handled correctly.
     //    At this stage current points to the event at time 2 from above
-    AllRewindInfo::iterator current_old = b1.m_current;
+    unsigned int current_old = b1.m_current;
     b1.addLocalEvent(NULL, NULL, true, 2);
     // Make sure that current was not modified, i.e. the new event at time
     // 2 was added at the end of the list:
@@ -509,7 +566,7 @@ void RewindQueue::unitTesting()
     assert(ri->getTicks() == 2);
     assert(ri->isEvent());
     b1.next();
-    assert(b1.m_current == b1.m_all_rewind_info.end());
+    assert(b1.m_current == b1.m_count);
 
     // 3) Test that if cleanupOldRewindInfo is called, it will if necessary
     //    adjust m_current to point to the latest confirmed state.
@@ -518,7 +575,23 @@ void RewindQueue::unitTesting()
     b2.addNetworkState(NULL, 2);
     b2.addNetworkState(NULL, 3);
     b2.mergeNetworkData(4, &needs_rewind, &rewind_ticks);
-    assert((*b2.m_current)->getTicks() == 3);
+    assert(b2.getCurrent()->getTicks() == 3);
+
+    // 4) Test that the ring buffer keeps the order when it wraps around
+    //    and when it grows.
+    RewindQueue b3;
+    const int size = (int)b3.m_all_rewind_info.size();
+    for (int i = 0; i < size; i++)
+        b3.addLocalState(NULL, /*confirmed*/false, i);
+    b3.cleanupOldRewindInfo(size / 2);
+    for (int i = size; i < size * 2; i++)
+        b3.addLocalState(NULL, /*confirmed*/false, i);
+    b3.addLocalEvent(NULL, NULL, true, size);
+    assert(b3.m_count == (unsigned int)size * 3 / 2 + 1);
+    for (unsigned int i = 1; i < b3.m_count; i++)
+        assert(b3.at(i - 1)->getTicks() <= b3.at(i)->getTicks());
+    assert(b3.at(size / 2)->isState() && b3.at(size / 2 + 1)->isEvent());
+    assert(b3.getConfirmedState(size) == NULL);
 
 
 }   // unitTesting
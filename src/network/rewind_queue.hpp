@@ -22,7 +22,6 @@
 #include "utils/synchronised.hpp"
 
 #include <assert.h>
-#include <list>
 #include <vector>
 
 class BareNetworkString;
@@ -37,9 +36,17 @@ class RewindQueue
 {
 private:
 
-    typedef std::list<RewindInfo*> AllRewindInfo;
+    /** All rewind infos sorted by time. They are stored in a ring buffer
+     *  (with a power of two size), since new infos are nearly always added
+     *  at the end and old ones are removed at the front, which then does not
+     *  need any allocation. */
+    std::vector<RewindInfo*> m_all_rewind_info;
 
-    AllRewindInfo m_all_rewind_info;
+    /** Index in m_all_rewind_info of the oldest rewind info. */
+    unsigned int m_first;
+
+    /** Number of rewind infos stored. */
+    unsigned int m_count;
 
     /** The list of all events received from the network. They are stored
      *  in a separate thread (so this data structure is thread-save), and
@@ -49,14 +56,32 @@ private:
     typedef std::vector<RewindInfo*> AllNetworkRewindInfo;
     Synchronised<AllNetworkRewindInfo> m_network_events;
 
-    /** Iterator to the curren time step info to be handled. */
-    AllRewindInfo::iterator m_current;
+    /** Position (counted from the oldest rewind info) of the current rewind
+     *  info to be handled, m_count if all were handled. */
+    unsigned int m_current;
 
     /** Time at which the latest confirmed state is at. */
     int m_latest_confirmed_state_time;
 
 
     void cleanupOldRewindInfo(int ticks);
+    unsigned int findFirst(int ticks, bool after_same_ticks) const;
+    // ------------------------------------------------------------------------
+    /** Returns the rewind info at the given position, counted from the
+     *  oldest one. */
+    RewindInfo*& at(unsigned int n)
+    {
+        assert(n < m_count);
+        return m_all_rewind_info[(m_first + n) &
+                                 (m_all_rewind_info.size() - 1)];
+    }   // at
+    // ------------------------------------------------------------------------
+    RewindInfo* at(unsigned int n) const
+    {
+        assert(n < m_count);
+        return m_all_rewind_info[(m_first + n) &
+                                 (m_all_rewind_info.size() - 1)];
+    }   // at
 
 public:
         static void unitTesting();
@@ -77,7 +102,8 @@ public:
         m_network_events.unlock();
     }
     void mergeNetworkData(int world_ticks,  bool *needs_rewind, 
-                          int *rewind_ticks);
+                          int *rewind_ticks, int *latest_event_ticks = NULL);
+    RewindInfo* getConfirmedState(int ticks);
     void replayAllEvents(int ticks);
     bool isEmpty() const;
     bool hasMoreRewindInfo() const;
@@ -95,7 +121,7 @@ public:
      *  RewindInfo element. */
     void next()
     {
-        assert(m_current != m_all_rewind_info.end());
+        assert(m_current < m_count);
         m_current++;
         return;
     }   // operator++
@@ -105,7 +131,7 @@ public:
      *  least one more RewindInfo (see hasMoreRewindInfo()). */
     RewindInfo* getCurrent()
     {
-        return (m_current != m_all_rewind_info.end() ) ? *m_current : NULL;
+        return m_current < m_count ? at(m_current) : NULL;
     }   // getNext
 
 };   // RewindQueue
@@ -77,6 +77,19 @@ public:
      */
     virtual BareNetworkString* saveState(std::vector<std::string>* ru) = 0;
 
+    /** Used by a client to save the state it predicted for this object, in
+     *  the same format as the server sends it, so that it can be compared
+     *  with the state received from the server later. By default it uses
+     *  saveState(), which like on the server can round the values of the
+     *  object to the precision they are sent with.
+     *  \return The state or NULL if there is no state to save.
+     */
+    virtual BareNetworkString* savePredictedState()
+    {
+        std::vector<std::string> rewinder_using;
+        return saveState(&rewinder_using);
+    }   // savePredictedState
+
     /** Called when an event needs to be undone. This is called while going
      *  backwards for rewinding - all stored events will get an 'undo' call.
      */
@@ -0,0 +1,192 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/send_workers.hpp"
+
+#include "network/stk_peer.hpp"
+#include "utils/vs.hpp"
+
+#include <cassert>
+#include <chrono>
+
+// ----------------------------------------------------------------------------
+/** Starts the worker threads.
+ *  \param num_threads Number of threads besides the calling thread.
+ */
+SendWorkers::SendWorkers(unsigned num_threads)
+{
+    m_job = NULL;
+    m_count = 0;
+    m_next_peer.store(0);
+    m_running = 0;
+    m_job_id = 0;
+    m_exit = false;
+    for (unsigned i = 0; i < num_threads; i++)
+        m_threads.emplace_back(std::bind(&SendWorkers::mainLoop, this));
+}   // SendWorkers
+
+// ----------------------------------------------------------------------------
+SendWorkers::~SendWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_exit = true;
+    }
+    m_start_cv.notify_all();
+    for (std::thread& t : m_threads)
+        t.join();
+}   // ~SendWorkers
+
+// ----------------------------------------------------------------------------
+/** Waits for jobs, and sends the packets to the peers not taken by other
+ *  threads yet.
+ */
+void SendWorkers::mainLoop()
+{
+    VS::setThreadName("SendWorkers");
+    uint64_t last_job_id = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> ul(m_mutex);
+            m_start_cv.wait(ul, [this, last_job_id]()
+                {
+                    return m_exit || m_job_id != last_job_id;
+                });
+            if (m_exit)
+                return;
+            last_job_id = m_job_id;
+        }
+        doNextJobs();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running--;
+        }
+        m_done_cv.notify_all();
+    }
+}   // mainLoop
+
+// ----------------------------------------------------------------------------
+/** Sends the packets of the current job to peers which have not been taken
+ *  by another thread, until there are none left.
+ */
+void SendWorkers::doNextJobs()
+{
+    for (unsigned i = m_next_peer.fetch_add(1); i < m_count;
+         i = m_next_peer.fetch_add(1))
+    {
+        (*m_job)(i);
+    }
+}   // doNextJobs
+
+// ----------------------------------------------------------------------------
+/** Calls job for each index from 0 to count - 1 using all workers.
+ *  \param count Number of peers.
+ *  \param job Sends the packet of the peer with the given index.
+ *  \return False if the workers are busy with another job, in which case
+ *          job was not called.
+ */
+bool SendWorkers::run(unsigned count, const std::function<void(unsigned)>& job)
+{
+    std::unique_lock<std::mutex> send_lock(m_send_mutex, std::try_to_lock);
+    if (!send_lock.owns_lock())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_next_peer.store(0);
+        m_running = (unsigned)m_threads.size();
+        m_job_id++;
+    }
+    m_start_cv.notify_all();
+    doNextJobs();
+
+    std::unique_lock<std::mutex> ul(m_mutex);
+    m_done_cv.wait(ul, [this]() { return m_running == 0; });
+    return true;
+}   // run
+
+// ----------------------------------------------------------------------------
+/** Sends a packet to the given peers using all workers, each peer encrypts
+ *  the packet with its own key.
+ *  \param peers The peers to send to.
+ *  \param data The packet to send.
+ *  \param reliable If the packet is sent reliable.
+ *  \return False if the workers are busy with another packet, in which case
+ *          nothing was sent.
+ */
+bool SendWorkers::send(const std::vector<std::shared_ptr<STKPeer> >& peers,
+                       NetworkString* data, bool reliable)
+{
+    return run((unsigned)peers.size(), [&peers, data, reliable](unsigned i)
+        {
+            peers[i]->sendPacket(data, reliable);
+        });
+}   // send
+
+// ----------------------------------------------------------------------------
+/** Sends a different packet to each of the given peers using all workers,
+ *  like the game states which are encoded for each peer.
+ *  \param peers The peers to send to.
+ *  \param data The packet for each peer, in the same order as peers.
+ *  \param reliable If the packets are sent reliable.
+ *  \return False if the workers are busy with another packet, in which case
+ *          nothing was sent.
+ */
+bool SendWorkers::send(const std::vector<std::shared_ptr<STKPeer> >& peers,
+                       const std::vector<NetworkString*>& data, bool reliable)
+{
+    assert(peers.size() == data.size());
+    return run((unsigned)peers.size(), [&peers, &data, reliable](unsigned i)
+        {
+            peers[i]->sendPacket(data[i], reliable);
+        });
+}   // send
+
+// ----------------------------------------------------------------------------
+/** Checks that each peer of a job is handled exactly once, and that the
+ *  worker threads take part in it.
+ */
+void SendWorkers::unitTesting()
+{
+    SendWorkers workers(3);
+    for (unsigned count : { 0u, 1u, 6u, 64u })
+    {
+        std::vector<std::atomic<unsigned> > done(count);
+        for (auto& d : done)
+            d.store(0);
+        std::atomic<unsigned> by_workers(0);
+        const std::thread::id caller = std::this_thread::get_id();
+        std::function<void(unsigned)> job = [&](unsigned i)
+            {
+                done[i].fetch_add(1);
+                if (std::this_thread::get_id() != caller)
+                    by_workers.fetch_add(1);
+                // Long enough for the workers to wake up
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            };
+        bool sent = workers.run(count, job);
+        assert(sent);
+        (void)sent;   // avoid compiler warnings without asserts
+        for (unsigned i = 0; i < count; i++)
+            assert(done[i].load() == 1);
+        assert(count < 6 || by_workers.load() > 0);
+    }
+}   // unitTesting
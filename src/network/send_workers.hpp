@@ -0,0 +1,92 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_SEND_WORKERS_HPP
+#define HEADER_SEND_WORKERS_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class NetworkString;
+class STKPeer;
+
+/** A small pool of threads used by the server to encrypt and queue packets
+ *  for many peers in parallel. The calling thread takes part in the work, and
+ *  send() only returns when the packets were queued for all peers, so they
+ *  can be freed afterwards. Only one batch is sent at a time, a caller
+ *  finding the workers busy sends the packets itself.
+ *  \ingroup network
+ */
+class SendWorkers : public NoCopy
+{
+private:
+    std::vector<std::thread> m_threads;
+
+    /** Protects the current job, m_running and m_exit. */
+    std::mutex m_mutex;
+
+    /** Only one job can be done by the workers at a time. */
+    std::mutex m_send_mutex;
+
+    /** Wakes up the workers when a new job is to be done. */
+    std::condition_variable m_start_cv;
+
+    /** Wakes up the caller of send() when all workers are finished. */
+    std::condition_variable m_done_cv;
+
+    /** The current job, called with the index of each peer to send to. */
+    const std::function<void(unsigned)>* m_job;
+
+    /** Number of peers of the current job. */
+    unsigned m_count;
+
+    /** Index of the next peer which still needs its packet. */
+    std::atomic<unsigned> m_next_peer;
+
+    /** Number of workers which did not finish the current job. */
+    unsigned m_running;
+
+    /** Increased for each job, so a worker knows if there is a new one. */
+    uint64_t m_job_id;
+
+    bool m_exit;
+
+    void mainLoop();
+    void doNextJobs();
+    bool run(unsigned count, const std::function<void(unsigned)>& job);
+
+public:
+    SendWorkers(unsigned num_threads);
+    ~SendWorkers();
+    bool send(const std::vector<std::shared_ptr<STKPeer> >& peers,
+              NetworkString* data, bool reliable);
+    bool send(const std::vector<std::shared_ptr<STKPeer> >& peers,
+              const std::vector<NetworkString*>& data, bool reliable);
+    static void unitTesting();
+
+};   // class SendWorkers
+
+#endif
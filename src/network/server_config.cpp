@@ -47,6 +47,7 @@ namespace ServerConfig
 // ============================================================================
 std::string g_server_config_path;
 std::string m_server_uid;
+int m_server_instance = 0;
 // ============================================================================
 FloatServerConfigParam::FloatServerConfigParam(float default_value,
                                                const char* param_name,
@@ -181,9 +182,32 @@ std::string getServerConfigXML()
     return ss.str();
 }   // getServerConfigXML
 
+// ----------------------------------------------------------------------------
+/** Returns the file name used by this server instance for a file which
+ *  would otherwise be written by all instances, by appending _n (the number
+ *  of the instance) to the name before the extension.
+ *  \param filename The file name from the config.
+ */
+std::string getInstanceFileName(const std::string& filename)
+{
+    if (m_server_instance <= 0)
+        return filename;
+    const std::string suffix = "_" + StringUtils::toString(m_server_instance);
+    size_t dot = filename.find_last_of('.');
+    size_t slash = filename.find_last_of("/\\");
+    if (dot == std::string::npos || dot == 0 ||
+        (slash != std::string::npos && dot < slash + 2))
+        return filename + suffix;
+    return filename.substr(0, dot) + suffix + filename.substr(dot);
+}   // getInstanceFileName
+
 // ----------------------------------------------------------------------------
 void writeServerConfigToDisk()
 {
+    // All server instances share the config file, so never write it with
+    // the port and name of one instance
+    if (m_server_instance > 0)
+        return;
     const std::string& config_xml = getServerConfigXML();
     try
     {
@@ -311,6 +335,17 @@ void loadServerLobbyFromConfig()
     }
     NetworkConfig::get()->setStateFrequency(m_state_frequency);
 
+    if (m_server_instance > 0)
+    {
+        if (m_server_port != 0)
+            m_server_port = m_server_port + m_server_instance - 1;
+        m_server_name = (std::string)m_server_name + " " +
+            StringUtils::toString(m_server_instance);
+        const std::string metrics_file = m_metrics_file;
+        if (!metrics_file.empty())
+            m_metrics_file = getInstanceFileName(metrics_file);
+    }
+
     if (m_player_reports_expired_days < 0.0f)
         m_player_reports_expired_days.revertToDefaults();
     if (m_server_difficulty > RaceManager::DIFFICULTY_LAST)
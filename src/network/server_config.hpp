@@ -319,6 +319,91 @@ namespace ServerConfig
         "more rewind, which clients with slow device may have problem playing "
         "this server, use the default value is recommended."));
 
+    SERVER_CFG_PREFIX BoolServerConfigParam m_delta_state
+        SERVER_CFG_DEFAULT(BoolServerConfigParam(true,
+        "delta-state",
+        "Send states to clients as a delta of the last state acknowledged by "
+        "each client, which reduces the upload bandwidth of the server. "
+        "Clients not supporting it will still receive full states."));
+
+    SERVER_CFG_PREFIX FloatServerConfigParam m_state_relevance_distance
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(0.0f,
+        "state-relevance-distance",
+        "Karts further away than this distance (in meters, measured along the "
+        "navmesh in arenas) from all karts of a client are only sent in every "
+        "state-relevance-interval state to that client, the client predicts "
+        "them in between. This reduces bandwidth and rewind cost in big "
+        "battle rooms, 0 or negative to disable."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_state_relevance_interval
+        SERVER_CFG_DEFAULT(IntServerConfigParam(3,
+        "state-relevance-interval",
+        "Send karts further away than state-relevance-distance only in every "
+        "nth state."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_send_threads
+        SERVER_CFG_DEFAULT(IntServerConfigParam(2,
+        "send-threads",
+        "Number of extra threads used to encrypt and send a packet to many "
+        "clients in parallel, 0 to disable."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_ai_threads
+        SERVER_CFG_DEFAULT(IntServerConfigParam(0,
+        "ai-threads",
+        "Number of extra threads used to compute the decisions of the AI "
+        "karts in parallel, 0 to disable. This changes the order in which "
+        "the karts are updated, so it is not used by clients."));
+
+    SERVER_CFG_PREFIX StringServerConfigParam m_metrics_file
+        SERVER_CFG_DEFAULT(StringServerConfigParam("",
+        "metrics-file",
+        "File to write server metrics (tick durations, network traffic, "
+        "ping and packet loss of players, database latency...) to in "
+        "Prometheus text format, empty to disable."));
+
+    SERVER_CFG_PREFIX FloatServerConfigParam m_metrics_interval
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(5.0f,
+        "metrics-interval",
+        "Interval in seconds between writing the metrics file."));
+
+    SERVER_CFG_PREFIX StringServerConfigParam m_race_recording_dir
+        SERVER_CFG_DEFAULT(StringServerConfigParam("",
+        "race-recording-dir",
+        "Directory to record each race to, as a file with all states and "
+        "controller events of the race, to investigate problems later. The "
+        "files are named after the start time and track of the race, empty "
+        "to disable."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_simulated_latency
+        SERVER_CFG_DEFAULT(IntServerConfigParam(0,
+        "simulated-latency",
+        "Testing only: delay in milliseconds added to each packet received "
+        "from a client, to simulate a bad connection."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_simulated_jitter
+        SERVER_CFG_DEFAULT(IntServerConfigParam(0,
+        "simulated-jitter",
+        "Testing only: random variation in milliseconds of the simulated "
+        "latency."));
+
+    SERVER_CFG_PREFIX FloatServerConfigParam m_simulated_loss
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(0.0f,
+        "simulated-loss",
+        "Testing only: percentage of packets received from clients which are "
+        "dropped."));
+
+    SERVER_CFG_PREFIX FloatServerConfigParam m_simulated_reorder
+        SERVER_CFG_DEFAULT(FloatServerConfigParam(0.0f,
+        "simulated-reorder",
+        "Testing only: percentage of packets received from clients which "
+        "skip the simulated latency, so they arrive before earlier ones."));
+
+    SERVER_CFG_PREFIX IntServerConfigParam m_simulated_bandwidth
+        SERVER_CFG_DEFAULT(IntServerConfigParam(0,
+        "simulated-bandwidth",
+        "Testing only: maximum bandwidth in kbit/s of each client "
+        "connection, 0 for unlimited."));
+
     SERVER_CFG_PREFIX BoolServerConfigParam m_sql_management
         SERVER_CFG_DEFAULT(BoolServerConfigParam(false,
         "sql-management",
@@ -381,12 +466,18 @@ namespace ServerConfig
     /** Server uid, extracted from server_config.xml file with .xml removed. */
     extern std::string m_server_uid;
     // ========================================================================
+    /** Index (starting from 1) of this server if the server process was
+     *  forked into several instances with --server-instances, 0 otherwise. */
+    extern int m_server_instance;
+    // ========================================================================
     void loadServerConfig(const std::string& path = "");
     // ------------------------------------------------------------------------
     void loadServerConfigXML(const XMLNode* root, bool default_config = false);
     // ------------------------------------------------------------------------
     std::string getServerConfigXML();
     // ------------------------------------------------------------------------
+    std::string getInstanceFileName(const std::string& filename);
+    // ------------------------------------------------------------------------
     void writeServerConfigToDisk();
     // ------------------------------------------------------------------------
     std::pair<RaceManager::MinorRaceModeType, RaceManager::MajorRaceModeType>
@@ -0,0 +1,409 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#include "network/server_metrics.hpp"
+
+#include "network/network_string.hpp"
+#include "network/protocol_manager.hpp"
+#include "network/stk_host.hpp"
+#include "network/stk_peer.hpp"
+#include "utils/log.hpp"
+
+#include <enet/enet.h>
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+
+/** Bucket bounds in microseconds. A server tick at 120 Hz is 8.3 ms, ticks
+ *  taking longer than that make the server fall behind. */
+const uint64_t ServerMetrics::Histogram::m_bounds[] =
+    { 500, 1000, 2500, 5000, 8333, 16667, 50000, 250000 };
+
+// ----------------------------------------------------------------------------
+ServerMetrics::Histogram::Histogram()
+{
+    for (unsigned i = 0; i < BUCKET_COUNT; i++)
+        m_buckets[i].store(0);
+    m_sum.store(0);
+    m_count.store(0);
+}   // Histogram
+
+// ----------------------------------------------------------------------------
+/** Adds a value to the histogram.
+ *  \param us The value in microseconds.
+ */
+void ServerMetrics::Histogram::observe(uint64_t us)
+{
+    unsigned bucket = 0;
+    while (bucket < BUCKET_COUNT - 1 && us > m_bounds[bucket])
+        bucket++;
+    m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(us, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+}   // observe
+
+// ----------------------------------------------------------------------------
+/** Writes the cumulative buckets, sum and count of the histogram.
+ *  \param name Name of the metric, the HELP and TYPE lines must have been
+ *         written already.
+ */
+void ServerMetrics::Histogram::write(std::ostringstream& oss,
+                                     const std::string& name) const
+{
+    uint64_t cumulative = 0;
+    for (unsigned i = 0; i < BUCKET_COUNT; i++)
+    {
+        cumulative += m_buckets[i].load(std::memory_order_relaxed);
+        oss << name << "_bucket{le=\"";
+        if (i < BUCKET_COUNT - 1)
+            oss << (double)m_bounds[i] / 1000000.0;
+        else
+            oss << "+Inf";
+        oss << "\"} " << cumulative << "\n";
+    }
+    oss << name << "_sum "
+        << (double)m_sum.load(std::memory_order_relaxed) / 1000000.0 << "\n";
+    oss << name << "_count " << m_count.load(std::memory_order_relaxed)
+        << "\n";
+}   // write
+
+// ============================================================================
+/** Returns the metrics of this process, which exist even if they are not
+ *  enabled, so any thread can update them without checking for lifetime.
+ */
+ServerMetrics* ServerMetrics::get()
+{
+    static ServerMetrics metrics;
+    return &metrics;
+}   // get
+
+// ----------------------------------------------------------------------------
+ServerMetrics::ServerMetrics()
+{
+    m_enabled.store(false);
+    for (unsigned i = 0; i < TP_COUNT; i++)
+        m_tick_phase_us[i].store(0);
+    m_database_errors.store(0);
+    m_late_events.store(0);
+    m_multi_peer_sends[0].store(0);
+    m_multi_peer_sends[1].store(0);
+    for (unsigned d = 0; d < 2; d++)
+    {
+        for (unsigned p = 0; p < PROTOCOL_MAX; p++)
+        {
+            for (unsigned t = 0; t < MESSAGE_TYPES; t++)
+            {
+                m_bytes[d][p][t].store(0);
+                m_messages[d][p][t].store(0);
+            }
+        }
+    }
+}   // ServerMetrics
+
+// ----------------------------------------------------------------------------
+/** Counts a message by its protocol and message type.
+ *  \param direction 0 for sent, 1 for received.
+ *  \param data The unencrypted message.
+ *  \param size Size of the message on the wire.
+ */
+void ServerMetrics::addMessage(int direction, const NetworkString& data,
+                               unsigned size)
+{
+    if (data.getTotalSize() == 0)
+        return;
+    const unsigned protocol = data.getProtocolType();
+    if (protocol >= PROTOCOL_MAX)
+        return;
+    const unsigned type = data.getTotalSize() > 1 ?
+        (uint8_t)data.getData()[1] : 0;
+    m_bytes[direction][protocol][type].fetch_add(size,
+        std::memory_order_relaxed);
+    m_messages[direction][protocol][type].fetch_add(1,
+        std::memory_order_relaxed);
+}   // addMessage
+
+// ----------------------------------------------------------------------------
+/** Writes the bytes and messages per protocol and message type, only message
+ *  types which were used are written.
+ */
+void ServerMetrics::writeTraffic(std::ostringstream& oss) const
+{
+    static const char* protocol_names[PROTOCOL_MAX] =
+    {
+        "none", "connection", "lobby_room", "game_events",
+        "controller_events", "silent"
+    };
+    static const char* directions[2] = { "sent", "received" };
+
+    for (unsigned m = 0; m < 2; m++)
+    {
+        const char* name = m == 0 ? "stk_network_bytes_total" :
+                                    "stk_network_messages_total";
+        oss << "# HELP " << name << (m == 0 ?
+            " Bytes on the wire by protocol and message type.\n" :
+            " Messages by protocol and message type.\n");
+        oss << "# TYPE " << name << " counter\n";
+        for (unsigned d = 0; d < 2; d++)
+        {
+            for (unsigned p = 0; p < PROTOCOL_MAX; p++)
+            {
+                for (unsigned t = 0; t < MESSAGE_TYPES; t++)
+                {
+                    const uint64_t value = m == 0 ?
+                        m_bytes[d][p][t].load(std::memory_order_relaxed) :
+                        m_messages[d][p][t].load(std::memory_order_relaxed);
+                    if (value == 0)
+                        continue;
+                    oss << name << "{direction=\"" << directions[d]
+                        << "\",protocol=\"" << protocol_names[p]
+                        << "\",type=\"" << t << "\"} " << value << "\n";
+                }
+            }
+        }
+    }
+}   // writeTraffic
+
+// ----------------------------------------------------------------------------
+/** Writes the round trip time, its variance and the packet loss measured by
+ *  enet for each peer.
+ */
+void ServerMetrics::writePeers(std::ostringstream& oss,
+                  const std::vector<std::shared_ptr<STKPeer> >& peers) const
+{
+    oss << "# HELP stk_peer_rtt_seconds Round trip time of a peer.\n"
+        << "# TYPE stk_peer_rtt_seconds gauge\n";
+    for (auto& peer : peers)
+    {
+        oss << "stk_peer_rtt_seconds{peer=\"" << peer->getHostId() << "\"} "
+            << (double)peer->getENetPeer()->roundTripTime / 1000.0 << "\n";
+    }
+    oss << "# HELP stk_peer_jitter_seconds Variance of the round trip time "
+           "of a peer.\n"
+        << "# TYPE stk_peer_jitter_seconds gauge\n";
+    for (auto& peer : peers)
+    {
+        oss << "stk_peer_jitter_seconds{peer=\"" << peer->getHostId()
+            << "\"} "
+            << (double)peer->getENetPeer()->roundTripTimeVariance / 1000.0
+            << "\n";
+    }
+    oss << "# HELP stk_peer_packet_loss_ratio Mean loss of reliable packets "
+           "of a peer.\n"
+        << "# TYPE stk_peer_packet_loss_ratio gauge\n";
+    for (auto& peer : peers)
+    {
+        oss << "stk_peer_packet_loss_ratio{peer=\"" << peer->getHostId()
+            << "\"} " << (double)peer->getENetPeer()->packetLoss /
+            (double)ENET_PEER_PACKET_LOSS_SCALE << "\n";
+    }
+}   // writePeers
+
+// ----------------------------------------------------------------------------
+/** Returns all metrics in the Prometheus text exposition format.
+ *  \param peers The peers to write statistics for.
+ */
+std::string ServerMetrics::getText(
+                  const std::vector<std::shared_ptr<STKPeer> >& peers) const
+{
+    std::ostringstream oss;
+    oss << "# HELP stk_tick_duration_seconds Duration of a server tick.\n"
+        << "# TYPE stk_tick_duration_seconds histogram\n";
+    m_tick_duration.write(oss, "stk_tick_duration_seconds");
+
+    oss << "# HELP stk_tick_phase_seconds_total Time spent in each part of "
+           "the server ticks.\n"
+        << "# TYPE stk_tick_phase_seconds_total counter\n";
+    static const char* phase_names[TP_COUNT] = { "protocols", "world" };
+    for (unsigned i = 0; i < TP_COUNT; i++)
+    {
+        oss << "stk_tick_phase_seconds_total{phase=\"" << phase_names[i]
+            << "\"} " << (double)m_tick_phase_us[i].load() / 1000000.0
+            << "\n";
+    }
+
+    oss << "# HELP stk_late_events_total Events received after their tick "
+           "was simulated.\n"
+        << "# TYPE stk_late_events_total counter\n"
+        << "stk_late_events_total " << m_late_events.load() << "\n";
+
+    oss << "# HELP stk_multi_peer_sends_total Packets sent to enough peers "
+           "to use the send workers, by who sent them.\n"
+        << "# TYPE stk_multi_peer_sends_total counter\n"
+        << "stk_multi_peer_sends_total{mode=\"serial\"} "
+        << m_multi_peer_sends[0].load() << "\n"
+        << "stk_multi_peer_sends_total{mode=\"parallel\"} "
+        << m_multi_peer_sends[1].load() << "\n";
+
+    oss << "# HELP stk_database_query_duration_seconds Duration of the "
+           "queries run by the database thread.\n"
+        << "# TYPE stk_database_query_duration_seconds histogram\n";
+    m_database_duration.write(oss, "stk_database_query_duration_seconds");
+    oss << "# HELP stk_database_errors_total Failed database queries.\n"
+        << "# TYPE stk_database_errors_total counter\n"
+        << "stk_database_errors_total " << m_database_errors.load() << "\n";
+
+    if (auto pm = ProtocolManager::lock())
+    {
+        static const char* queues[2] = { "async", "sync" };
+        oss << "# HELP stk_event_queue_depth Events waiting for delivery.\n"
+            << "# TYPE stk_event_queue_depth gauge\n";
+        for (unsigned i = 0; i < 2; i++)
+        {
+            oss << "stk_event_queue_depth{queue=\"" << queues[i] << "\"} "
+                << pm->getEventQueueDepth(i == 1) << "\n";
+        }
+        oss << "# HELP stk_event_queue_events_total Events delivered.\n"
+            << "# TYPE stk_event_queue_events_total counter\n";
+        for (unsigned i = 0; i < 2; i++)
+        {
+            oss << "stk_event_queue_events_total{queue=\"" << queues[i]
+                << "\"} " << pm->getEventQueueCount(i == 1) << "\n";
+        }
+        oss << "# HELP stk_event_queue_wait_seconds_total Time events waited "
+               "for delivery.\n"
+            << "# TYPE stk_event_queue_wait_seconds_total counter\n";
+        for (unsigned i = 0; i < 2; i++)
+        {
+            oss << "stk_event_queue_wait_seconds_total{queue=\"" << queues[i]
+                << "\"} "
+                << (double)pm->getEventQueueTotalWait(i == 1) / 1000.0
+                << "\n";
+        }
+        oss << "# HELP stk_event_queue_max_wait_seconds Longest time an "
+               "event waited for delivery.\n"
+            << "# TYPE stk_event_queue_max_wait_seconds gauge\n";
+        for (unsigned i = 0; i < 2; i++)
+        {
+            oss << "stk_event_queue_max_wait_seconds{queue=\"" << queues[i]
+                << "\"} "
+                << (double)pm->getEventQueueMaxWait(i == 1) / 1000.0 << "\n";
+        }
+    }
+
+    if (STKHost::existHost())
+    {
+        STKHost* host = STKHost::get();
+        oss << "# HELP stk_peers Connected peers.\n"
+            << "# TYPE stk_peers gauge\n"
+            << "stk_peers " << peers.size() << "\n"
+            << "# HELP stk_players_in_game Players in the current game.\n"
+            << "# TYPE stk_players_in_game gauge\n"
+            << "stk_players_in_game " << host->getPlayersInGame() << "\n"
+            << "# HELP stk_upload_bytes_per_second Upload speed.\n"
+            << "# TYPE stk_upload_bytes_per_second gauge\n"
+            << "stk_upload_bytes_per_second " << host->getUploadSpeed()
+            << "\n"
+            << "# HELP stk_download_bytes_per_second Download speed.\n"
+            << "# TYPE stk_download_bytes_per_second gauge\n"
+            << "stk_download_bytes_per_second " << host->getDownloadSpeed()
+            << "\n";
+    }
+    writePeers(oss, peers);
+    writeTraffic(oss);
+    return oss.str();
+}   // getText
+
+// ----------------------------------------------------------------------------
+/** Writes all metrics to a file. A temporary file is renamed to the final
+ *  name, so readers never see a partially written file.
+ *  \param filename The file to write.
+ *  \param peers The peers to write statistics for.
+ *  \return True if the file was written.
+ */
+bool ServerMetrics::writeFile(const std::string& filename,
+                  const std::vector<std::shared_ptr<STKPeer> >& peers) const
+{
+    const std::string tmp = filename + ".tmp";
+    {
+        std::ofstream file(tmp, std::ios::out | std::ios::trunc);
+        if (!file.is_open())
+        {
+            Log::warn("ServerMetrics", "Cannot write %s.", tmp.c_str());
+            return false;
+        }
+        file << getText(peers);
+        if (!file.good())
+        {
+            Log::warn("ServerMetrics", "Error writing %s.", tmp.c_str());
+            return false;
+        }
+    }
+#ifdef WIN32
+    // rename does not replace an existing file on windows
+    remove(filename.c_str());
+#endif
+    if (rename(tmp.c_str(), filename.c_str()) != 0)
+    {
+        Log::warn("ServerMetrics", "Cannot rename %s to %s.", tmp.c_str(),
+            filename.c_str());
+        return false;
+    }
+    return true;
+}   // writeFile
+
+// ----------------------------------------------------------------------------
+/** Tests the histogram buckets and the traffic counters.
+ */
+void ServerMetrics::unitTesting()
+{
+    ServerMetrics* metrics = get();
+    const bool enabled = metrics->isEnabled();
+
+    metrics->setEnabled(false);
+    metrics->addTick(100);
+    assert(metrics->m_tick_duration.m_count.load() == 0);
+
+    metrics->setEnabled(true);
+    const uint64_t count = metrics->m_tick_duration.m_count.load();
+    const uint64_t first = metrics->m_tick_duration.m_buckets[0].load();
+    const uint64_t last =
+        metrics->m_tick_duration.m_buckets[Histogram::BUCKET_COUNT - 1].load();
+    (void)count;   // avoid compiler warnings without asserts
+    (void)first;
+    (void)last;
+    metrics->addTick(500);
+    metrics->addTick(1000000);
+    assert(metrics->m_tick_duration.m_count.load() == count + 2);
+    assert(metrics->m_tick_duration.m_buckets[0].load() == first + 1);
+    assert(metrics->m_tick_duration.m_buckets
+        [Histogram::BUCKET_COUNT - 1].load() == last + 1);
+
+    NetworkString ns(PROTOCOL_LOBBY_ROOM);
+    ns.addUInt8(42).addUInt32(0);
+    const uint64_t bytes = metrics->m_bytes[0][PROTOCOL_LOBBY_ROOM][42].load();
+    (void)bytes;
+    metrics->addSentMessage(ns, 100);
+    assert(metrics->m_bytes[0][PROTOCOL_LOBBY_ROOM][42].load() == bytes + 100);
+
+    const uint64_t parallel = metrics->m_multi_peer_sends[1].load();
+    (void)parallel;
+    metrics->addMultiPeerSend(/*parallel*/true);
+    assert(metrics->m_multi_peer_sends[1].load() == parallel + 1);
+
+    std::vector<std::shared_ptr<STKPeer> > no_peers;
+    const std::string text = metrics->getText(no_peers);
+    assert(text.find("stk_tick_duration_seconds_bucket{le=\"+Inf\"}") !=
+        std::string::npos);
+    assert(text.find("protocol=\"lobby_room\",type=\"42\"") !=
+        std::string::npos);
+    assert(text.find("stk_multi_peer_sends_total{mode=\"parallel\"}") !=
+        std::string::npos);
+
+    metrics->setEnabled(enabled);
+}   // unitTesting
@@ -0,0 +1,186 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_SERVER_METRICS_HPP
+#define HEADER_SERVER_METRICS_HPP
+
+#include "network/protocol.hpp"
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+class NetworkString;
+class STKPeer;
+
+/** Collects counters about a running server (tick durations, network
+ *  traffic per message type, database latency, ...) and formats them in
+ *  the Prometheus text exposition format, so they can be scraped from the
+ *  file written by STKHost (see the metrics-file server config). All
+ *  counters are atomic and can be updated from any thread, and are only
+ *  updated if the metrics are enabled.
+ *  \ingroup network
+ */
+class ServerMetrics : public NoCopy
+{
+public:
+    /** The parts of a server tick measured by the tick profiler. */
+    enum TickPhase
+    {
+        TP_PROTOCOLS = 0,
+        TP_WORLD,
+        TP_COUNT
+    };
+
+private:
+    /** A histogram with fixed buckets, values are given in microseconds
+     *  and written in seconds. */
+    class Histogram
+    {
+    private:
+        friend class ServerMetrics;
+
+        static const unsigned BUCKET_COUNT = 9;
+
+        /** Upper bounds of the buckets in microseconds, the last bucket
+         *  (+Inf) is implicit. */
+        static const uint64_t m_bounds[BUCKET_COUNT - 1];
+
+        std::atomic<uint64_t> m_buckets[BUCKET_COUNT];
+
+        std::atomic<uint64_t> m_sum;
+
+        std::atomic<uint64_t> m_count;
+
+    public:
+        Histogram();
+        void observe(uint64_t us);
+        void write(std::ostringstream& oss, const std::string& name) const;
+    };   // class Histogram
+
+    /** Number of different values of the second byte of a message, which
+     *  is the message type for all protocols. */
+    static const unsigned MESSAGE_TYPES = 256;
+
+    std::atomic<bool> m_enabled;
+
+    Histogram m_tick_duration;
+
+    std::atomic<uint64_t> m_tick_phase_us[TP_COUNT];
+
+    Histogram m_database_duration;
+
+    std::atomic<uint64_t> m_database_errors;
+
+    std::atomic<uint64_t> m_late_events;
+
+    /** Packets sent to many peers by the send workers (1) or serially by
+     *  the calling thread (0). */
+    std::atomic<uint64_t> m_multi_peer_sends[2];
+
+    /** Bytes and messages per direction (0 sent, 1 received), protocol and
+     *  message type. */
+    std::atomic<uint64_t> m_bytes[2][PROTOCOL_MAX][MESSAGE_TYPES];
+
+    std::atomic<uint64_t> m_messages[2][PROTOCOL_MAX][MESSAGE_TYPES];
+
+    ServerMetrics();
+    void addMessage(int direction, const NetworkString& data, unsigned size);
+    void writeTraffic(std::ostringstream& oss) const;
+    void writePeers(std::ostringstream& oss,
+                    const std::vector<std::shared_ptr<STKPeer> >& peers) const;
+
+public:
+    static ServerMetrics* get();
+    // ------------------------------------------------------------------------
+    /** Enables or disables collecting the metrics. */
+    void setEnabled(bool enabled)                  { m_enabled.store(enabled); }
+    // ------------------------------------------------------------------------
+    bool isEnabled() const
+                         { return m_enabled.load(std::memory_order_relaxed); }
+    // ------------------------------------------------------------------------
+    /** Adds the duration of a whole server tick. */
+    void addTick(uint64_t us)
+    {
+        if (isEnabled())
+            m_tick_duration.observe(us);
+    }   // addTick
+    // ------------------------------------------------------------------------
+    /** Adds the time spent in one part of a server tick. */
+    void addTickPhase(TickPhase phase, uint64_t us)
+    {
+        if (isEnabled())
+            m_tick_phase_us[phase].fetch_add(us, std::memory_order_relaxed);
+    }   // addTickPhase
+    // ------------------------------------------------------------------------
+    /** Adds the execution time of a database query. */
+    void addDatabaseQuery(uint64_t us, bool success)
+    {
+        if (!isEnabled())
+            return;
+        m_database_duration.observe(us);
+        if (!success)
+            m_database_errors.fetch_add(1, std::memory_order_relaxed);
+    }   // addDatabaseQuery
+    // ------------------------------------------------------------------------
+    /** Counts an event which arrived after the tick it belongs to was
+     *  simulated, so the server had to move it to the current tick. */
+    void addLateEvent()
+    {
+        if (isEnabled())
+            m_late_events.fetch_add(1, std::memory_order_relaxed);
+    }   // addLateEvent
+    // ------------------------------------------------------------------------
+    /** Counts a packet or a batch of packets sent to enough peers to use the
+     *  send workers, and if they were actually used. */
+    void addMultiPeerSend(bool parallel)
+    {
+        if (isEnabled())
+        {
+            m_multi_peer_sends[parallel ? 1 : 0]
+                .fetch_add(1, std::memory_order_relaxed);
+        }
+    }   // addMultiPeerSend
+    // ------------------------------------------------------------------------
+    /** Counts a message sent, size is the size on the wire. */
+    void addSentMessage(const NetworkString& data, unsigned size)
+    {
+        if (isEnabled())
+            addMessage(0, data, size);
+    }   // addSentMessage
+    // ------------------------------------------------------------------------
+    /** Counts a message received, size is the size on the wire. */
+    void addReceivedMessage(const NetworkString& data, unsigned size)
+    {
+        if (isEnabled())
+            addMessage(1, data, size);
+    }   // addReceivedMessage
+    // ------------------------------------------------------------------------
+    std::string getText(
+        const std::vector<std::shared_ptr<STKPeer> >& peers) const;
+    bool writeFile(const std::string& filename,
+                   const std::vector<std::shared_ptr<STKPeer> >& peers) const;
+    static void unitTesting();
+
+};   // class ServerMetrics
+
+#endif
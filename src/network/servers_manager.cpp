@@ -20,6 +20,7 @@
 
 #include "config/stk_config.hpp"
 #include "config/user_config.hpp"
+#include "io/xml_node.hpp"
 #include "network/network.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
@@ -85,12 +86,21 @@ Online::XMLRequest* ServersManager::getWANRefreshRequest() const
     {
     public:
         WANRefreshRequest() : Online::XMLRequest(/*manage_memory*/true,
-                                                 /*priority*/100) {}
+                                                 /*priority*/100)
+        {
+            // Add each servers/server element as soon as it is parsed
+            setStreamDepth(2);
+        }
+        // --------------------------------------------------------------------
+        virtual void onStreamedNode(const XMLNode &node) OVERRIDE
+        {
+            ServersManager::get()->addWanServer(node);
+        }   // onStreamedNode
         // --------------------------------------------------------------------
         virtual void afterOperation() OVERRIDE
         {
             Online::XMLRequest::afterOperation();
-            ServersManager::get()->setWanServers(isSuccess(), getXMLData());
+            ServersManager::get()->setWanServers(isSuccess());
         }   // callback
         // --------------------------------------------------------------------
     };   // RefreshRequest
@@ -234,6 +244,7 @@ Online::XMLRequest* ServersManager::getLANRefreshRequest() const
 void ServersManager::setLanServers(const std::map<irr::core::stringw,
                                                   std::shared_ptr<Server> >& servers)
 {
+    std::lock_guard<std::mutex> lock(m_servers_mutex);
     m_servers.clear();
     for (auto i : servers) m_servers.emplace_back(i.second);
     m_last_load_time.store(StkTime::getMonoTimeMs());
@@ -274,11 +285,34 @@ bool ServersManager::refresh(bool full_refresh)
 }   // refresh
 
 // ----------------------------------------------------------------------------
-/** Callback from the refresh request for wan servers.
+/** Called from the refresh request for each wan server while the answer is
+ *  parsed, so the servers are available before the whole list is read.
+ *  \param s The XML data describing the server.
+ */
+void ServersManager::addWanServer(const XMLNode& s)
+{
+    const XMLNode* si = s.getNode("server-info");
+    assert(si);
+    int version = 0;
+    si->get("version", &version);
+    assert(version != 0);
+    if (version < stk_config->m_max_server_version ||
+        version > stk_config->m_max_server_version)
+    {
+        Log::verbose("ServersManager", "Skipping a server");
+        return;
+    }
+    auto server = std::make_shared<Server>(s);
+    std::lock_guard<std::mutex> lock(m_servers_mutex);
+    m_servers.emplace_back(server);
+}   // addWanServer
+
+// ----------------------------------------------------------------------------
+/** Callback from the refresh request for wan servers, after all servers
+ *  were added with addWanServer.
  *  \param success If the refresh was successful.
- *  \param input The XML data describing the server.
  */
-void ServersManager::setWanServers(bool success, const XMLNode* input)
+void ServersManager::setWanServers(bool success)
 {
     if (!success)
     {
@@ -286,28 +320,27 @@ void ServersManager::setWanServers(bool success, const XMLNode* input)
         m_list_updated = true;
         return;
     }
-
-    const XMLNode *servers_xml = input->getNode("servers");
-    for (unsigned int i = 0; i < servers_xml->getNumNodes(); i++)
-    {
-        const XMLNode* s = servers_xml->getNode(i);
-        assert(s);
-        const XMLNode* si = s->getNode("server-info");
-        assert(si);
-        int version = 0;
-        si->get("version", &version);
-        assert(version != 0);
-        if (version < stk_config->m_max_server_version ||
-            version > stk_config->m_max_server_version)
-        {
-            Log::verbose("ServersManager", "Skipping a server");
-            continue;
-        }
-        m_servers.emplace_back(std::make_shared<Server>(*s));
-    }
     m_last_load_time.store(StkTime::getMonoTimeMs());
     m_list_updated = true;
-}   // refresh
+}   // setWanServers
+
+// ----------------------------------------------------------------------------
+/** Returns a copy of the servers received so far, which can be used while
+ *  the refresh request is still adding servers.
+ */
+std::vector<std::shared_ptr<Server> > ServersManager::getReceivedServers()
+{
+    std::lock_guard<std::mutex> lock(m_servers_mutex);
+    return m_servers;
+}   // getReceivedServers
+
+// ----------------------------------------------------------------------------
+/** Returns the number of servers received so far. */
+unsigned ServersManager::getNumReceivedServers()
+{
+    std::lock_guard<std::mutex> lock(m_servers_mutex);
+    return (unsigned)m_servers.size();
+}   // getNumReceivedServers
 
 // ----------------------------------------------------------------------------
 /** Sets a list of default broadcast addresses which is used in case no valid
@@ -24,6 +24,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -41,6 +42,9 @@ class ServersManager
 private:
     /** List of servers */
     std::vector<std::shared_ptr<Server> > m_servers;
+
+    /** Protects m_servers while the refresh request adds servers. */
+    std::mutex m_servers_mutex;
     
     /** List of broadcast addresses to use. */
     std::vector<TransportAddress> m_broadcast_address;
@@ -53,7 +57,9 @@ private:
     // ------------------------------------------------------------------------
     ~ServersManager();
     // ------------------------------------------------------------------------
-    void setWanServers(bool success, const XMLNode* input);
+    void addWanServer(const XMLNode& s);
+    // ------------------------------------------------------------------------
+    void setWanServers(bool success);
     // ------------------------------------------------------------------------
     Online::XMLRequest* getWANRefreshRequest() const;
     // ------------------------------------------------------------------------
@@ -72,12 +78,21 @@ public:
     // ------------------------------------------------------------------------
     static void deallocate();
     // ------------------------------------------------------------------------
-    void cleanUpServers()                                { m_servers.clear(); }
+    void cleanUpServers()
+    {
+        std::lock_guard<std::mutex> lock(m_servers_mutex);
+        m_servers.clear();
+    }
     // ------------------------------------------------------------------------
     bool refresh(bool full_refresh);
     // ------------------------------------------------------------------------
+    /** Returns the list of servers, only to be used after listUpdated(). */
     std::vector<std::shared_ptr<Server> >& getServers()   { return m_servers; }
     // ------------------------------------------------------------------------
+    std::vector<std::shared_ptr<Server> > getReceivedServers();
+    // ------------------------------------------------------------------------
+    unsigned getNumReceivedServers();
+    // ------------------------------------------------------------------------
     bool listUpdated() const                         { return m_list_updated; }
     // ------------------------------------------------------------------------
     const std::vector<TransportAddress>& getBroadcastAddresses();
@@ -25,13 +25,16 @@
 #include "network/game_setup.hpp"
 #include "network/network_config.hpp"
 #include "network/network_console.hpp"
+#include "network/network_simulator.hpp"
 #include "network/network_player_profile.hpp"
 #include "network/network_string.hpp"
 #include "network/network_timer_synchronizer.hpp"
 #include "network/protocols/connect_to_peer.hpp"
 #include "network/protocols/server_lobby.hpp"
 #include "network/protocol_manager.hpp"
+#include "network/send_workers.hpp"
 #include "network/server_config.hpp"
+#include "network/server_metrics.hpp"
 #include "network/stk_peer.hpp"
 #include "tracks/track.hpp"
 #include "tracks/track_manager.hpp"
@@ -266,6 +269,13 @@ STKHost::STKHost(bool server)
         m_network = new Network(ServerConfig::m_server_max_players + 1,
             /*channel_limit*/EVENT_CHANNEL_COUNT, /*max_in_bandwidth*/0,
             /*max_out_bandwidth*/ 0, &addr, true/*change_port_if_bound*/);
+        if (ServerConfig::m_send_threads > 0)
+        {
+            m_send_workers.reset(
+                new SendWorkers(ServerConfig::m_send_threads));
+        }
+        ServerMetrics::get()->setEnabled(
+            !std::string(ServerConfig::m_metrics_file).empty());
     }
     else
     {
@@ -334,6 +344,8 @@ STKHost::~STKHost()
     requestShutdown();
     if (m_network_console.joinable())
         m_network_console.join();
+    m_send_workers.reset();
+    ServerMetrics::get()->setEnabled(false);
 
     disconnectAllPeers(true/*timeout_waiting*/);
     Network::closeLog();
@@ -710,8 +722,19 @@ void STKHost::mainLoop()
         direct_socket = new Network(1, 1, 0, 0, &eaddr);
         if (direct_socket->getENetHost() == NULL)
         {
-            Log::warn("STKHost", "No direct socket available, this "
-                "server may not be connected by lan network");
+            // All server instances try to bind the same discovery port, so
+            // only one of them can be found in LAN
+            if (ServerConfig::m_server_instance > 0)
+            {
+                Log::info("STKHost", "No direct socket available, the "
+                    "discovery port is used by another server instance, so "
+                    "this server can't be found by lan network");
+            }
+            else
+            {
+                Log::warn("STKHost", "No direct socket available, this "
+                    "server may not be connected by lan network");
+            }
             delete direct_socket;
             direct_socket = NULL;
         }
@@ -720,9 +743,19 @@ void STKHost::mainLoop()
     uint64_t last_ping_time = StkTime::getMonoTimeMs();
     uint64_t last_update_speed_time = StkTime::getMonoTimeMs();
     uint64_t last_ping_time_update_for_client = StkTime::getMonoTimeMs();
+    uint64_t last_metrics_time = StkTime::getMonoTimeMs();
+    const std::string metrics_file = is_server ?
+        std::string(ServerConfig::m_metrics_file) : "";
     std::map<std::string, uint64_t> ctp;
+    // Only this thread services the enet host, so the simulator lives here
+    std::unique_ptr<NetworkSimulator> network_simulator;
+    if (NetworkSimulator::isEnabled())
+        network_simulator.reset(new NetworkSimulator(host));
     while (m_exit_timeout.load() > StkTime::getMonoTimeMs())
     {
+        if (network_simulator)
+            network_simulator->update();
+
         // Clear outdated connect to peer list every 15 seconds
         for (auto it = ctp.begin(); it != ctp.end();)
         {
@@ -743,6 +776,16 @@ void STKHost::mainLoop()
             getNetwork()->getENetHost()->totalReceivedData = 0;
         }
 
+        if (!metrics_file.empty() &&
+            last_metrics_time < StkTime::getMonoTimeMs())
+        {
+            // Written in this thread, so the enet statistics of the peers
+            // are not updated at the same time
+            last_metrics_time = StkTime::getMonoTimeMs() +
+                (uint64_t)(ServerConfig::m_metrics_interval * 1000.0f);
+            ServerMetrics::get()->writeFile(metrics_file, getPeers());
+        }
+
         auto sl = LobbyProtocol::get<ServerLobby>();
         if (direct_socket && sl && sl->waitingForPlayers())
         {
@@ -928,7 +971,9 @@ void STKHost::mainLoop()
         }
 
         bool need_ping_update = false;
-        while (enet_host_service(host, &event, 10) != 0)
+        // Wake up more often to hand over the simulated packets in time
+        while (enet_host_service(host, &event,
+            network_simulator ? 1 : 10) != 0)
         {
             auto lp = LobbyProtocol::get<LobbyProtocol>();
             if (!is_server &&
@@ -1058,7 +1103,11 @@ void STKHost::mainLoop()
                 }
                 try
                 {
+                    const unsigned packet_size =
+                        (unsigned)event.packet->dataLength;
                     stk_event = new Event(&event, peer);
+                    ServerMetrics::get()->addReceivedMessage(
+                        stk_event->data(), packet_size);
                 }
                 catch (std::exception& e)
                 {
@@ -1235,12 +1284,16 @@ bool STKHost::isConnectedTo(const TransportAddress& peer)
  */
 void STKHost::sendPacketToAllPeersInServer(NetworkString *data, bool reliable)
 {
-    std::lock_guard<std::mutex> lock(m_peers_mutex);
-    for (auto p : m_peers)
+    std::vector<std::shared_ptr<STKPeer> > peers;
     {
-        if (p.second->isValidated())
-            p.second->sendPacket(data, reliable);
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        for (auto p : m_peers)
+        {
+            if (p.second->isValidated())
+                peers.push_back(p.second);
+        }
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeersInServer
 
 //-----------------------------------------------------------------------------
@@ -1250,12 +1303,16 @@ void STKHost::sendPacketToAllPeersInServer(NetworkString *data, bool reliable)
  */
 void STKHost::sendPacketToAllPeers(NetworkString *data, bool reliable)
 {
-    std::lock_guard<std::mutex> lock(m_peers_mutex);
-    for (auto p : m_peers)
+    std::vector<std::shared_ptr<STKPeer> > peers;
     {
-        if (p.second->isValidated() && !p.second->isWaitingForGame())
-            p.second->sendPacket(data, reliable);
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        for (auto p : m_peers)
+        {
+            if (p.second->isValidated() && !p.second->isWaitingForGame())
+                peers.push_back(p.second);
+        }
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeers
 
 //-----------------------------------------------------------------------------
@@ -1267,16 +1324,20 @@ void STKHost::sendPacketToAllPeers(NetworkString *data, bool reliable)
 void STKHost::sendPacketExcept(STKPeer* peer, NetworkString *data,
                                bool reliable)
 {
-    std::lock_guard<std::mutex> lock(m_peers_mutex);
-    for (auto p : m_peers)
+    std::vector<std::shared_ptr<STKPeer> > peers;
     {
-        STKPeer* stk_peer = p.second.get();
-        if (!stk_peer->isSamePeer(peer) && p.second->isValidated() &&
-            !p.second->isWaitingForGame())
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        for (auto p : m_peers)
         {
-            stk_peer->sendPacket(data, reliable);
+            STKPeer* stk_peer = p.second.get();
+            if (!stk_peer->isSamePeer(peer) && p.second->isValidated() &&
+                !p.second->isWaitingForGame())
+            {
+                peers.push_back(p.second);
+            }
         }
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketExcept
 
 //-----------------------------------------------------------------------------
@@ -1288,17 +1349,70 @@ void STKHost::sendPacketExcept(STKPeer* peer, NetworkString *data,
 void STKHost::sendPacketToAllPeersWith(std::function<bool(STKPeer*)> predicate,
                                        NetworkString* data, bool reliable)
 {
-    std::lock_guard<std::mutex> lock(m_peers_mutex);
-    for (auto p : m_peers)
+    std::vector<std::shared_ptr<STKPeer> > peers;
     {
-        STKPeer* stk_peer = p.second.get();
-        if (!stk_peer->isValidated())
-            continue;
-        if (predicate(stk_peer))
-            stk_peer->sendPacket(data, reliable);
+        std::lock_guard<std::mutex> lock(m_peers_mutex);
+        for (auto p : m_peers)
+        {
+            STKPeer* stk_peer = p.second.get();
+            if (!stk_peer->isValidated())
+                continue;
+            if (predicate(stk_peer))
+                peers.push_back(p.second);
+        }
     }
+    sendPacketToPeers(peers, data, reliable);
 }   // sendPacketToAllPeersWith
 
+//-----------------------------------------------------------------------------
+/** Sends data to the given peers without holding the peers lock. The packet
+ *  is encrypted for each peer, so for many peers this is done in parallel by
+ *  the send workers.
+ *  \param peers The peers to send to.
+ *  \param data Data to sent.
+ *  \param reliable If the data should be sent reliable or now.
+ */
+void STKHost::sendPacketToPeers(
+    const std::vector<std::shared_ptr<STKPeer> >& peers, NetworkString* data,
+    bool reliable)
+{
+    if (m_send_workers && peers.size() >= MIN_PARALLEL_PEERS &&
+        m_send_workers->send(peers, data, reliable))
+    {
+        ServerMetrics::get()->addMultiPeerSend(/*parallel*/true);
+        return;
+    }
+    if (peers.size() >= MIN_PARALLEL_PEERS)
+        ServerMetrics::get()->addMultiPeerSend(/*parallel*/false);
+    for (auto& peer : peers)
+        peer->sendPacket(data, reliable);
+}   // sendPacketToPeers
+
+//-----------------------------------------------------------------------------
+/** Sends a different packet to each of the given peers, like the game states
+ *  which are encoded for each peer. For many peers this is done in parallel
+ *  by the send workers.
+ *  \param peers The peers to send to.
+ *  \param data The packet for each peer, in the same order as peers.
+ *  \param reliable If the data should be sent reliable or now.
+ */
+void STKHost::sendPacketsToPeers(
+    const std::vector<std::shared_ptr<STKPeer> >& peers,
+    const std::vector<NetworkString*>& data, bool reliable)
+{
+    assert(peers.size() == data.size());
+    if (m_send_workers && peers.size() >= MIN_PARALLEL_PEERS &&
+        m_send_workers->send(peers, data, reliable))
+    {
+        ServerMetrics::get()->addMultiPeerSend(/*parallel*/true);
+        return;
+    }
+    if (peers.size() >= MIN_PARALLEL_PEERS)
+        ServerMetrics::get()->addMultiPeerSend(/*parallel*/false);
+    for (unsigned i = 0; i < peers.size(); i++)
+        peers[i]->sendPacket(data[i], reliable);
+}   // sendPacketsToPeers
+
 //-----------------------------------------------------------------------------
 /** Sends a message from a client to the server. */
 void STKHost::sendToServer(NetworkString *data, bool reliable)
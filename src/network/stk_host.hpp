@@ -52,6 +52,7 @@ class NetworkPlayerProfile;
 class NetworkTimerSynchronizer;
 class Server;
 class ServerLobby;
+class SendWorkers;
 class SeparateProcess;
 
 enum ENetCommandType : unsigned int
@@ -102,6 +103,13 @@ private:
     /** The list of peers connected to this instance. */
     std::map<ENetPeer*, std::shared_ptr<STKPeer> > m_peers;
 
+    /** Server only: threads to send a packet to many peers in parallel. */
+    std::unique_ptr<SendWorkers> m_send_workers;
+
+    /** Below this number of peers the cost of waking up the send workers is
+     *  higher than the gain. */
+    static const size_t MIN_PARALLEL_PEERS = 6;
+
     /** Next unique host id. It is increased whenever a new peer is added (see
      *  getPeer()), but not decreased whena host (=peer) disconnects. This
      *  results in a unique host id for each host, even when a host should
@@ -167,6 +175,9 @@ private:
                                    std::map<std::string, uint64_t>& ctp);
     // ------------------------------------------------------------------------
     void mainLoop();
+    // ------------------------------------------------------------------------
+    void sendPacketToPeers(const std::vector<std::shared_ptr<STKPeer> >& peers,
+                           NetworkString* data, bool reliable);
 
 public:
     /** If a network console should be started. */
@@ -231,6 +242,10 @@ public:
     void sendPacketToAllPeersWith(std::function<bool(STKPeer*)> predicate,
                                   NetworkString* data, bool reliable = true);
     // ------------------------------------------------------------------------
+    void sendPacketsToPeers(
+        const std::vector<std::shared_ptr<STKPeer> >& peers,
+        const std::vector<NetworkString*>& data, bool reliable = true);
+    // ------------------------------------------------------------------------
     /** Returns true if this client instance is allowed to control the server.
      *  It will auto transfer ownership if previous server owner disconnected.
      */
@@ -23,6 +23,7 @@
 #include "network/event.hpp"
 #include "network/network_config.hpp"
 #include "network/network_string.hpp"
+#include "network/server_metrics.hpp"
 #include "network/stk_host.hpp"
 #include "network/transport_address.hpp"
 #include "utils/log.hpp"
@@ -128,6 +129,8 @@ void STKPeer::sendPacket(NetworkString *data, bool reliable, bool encrypted)
 
     if (packet)
     {
+        ServerMetrics::get()->addSentMessage(*data,
+            (unsigned)packet->dataLength);
         if (Network::m_connection_debug)
         {
             Log::verbose("STKPeer", "sending packet of size %d to %s at %lf",
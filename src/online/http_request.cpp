@@ -95,6 +95,7 @@ namespace Online
         m_filename      = "";
         m_parameters    = "";
         m_curl_code     = CURLE_OK;
+        m_file          = NULL;
         m_progress.setAtomic(0);
         if (m_http_header == nullptr)
         {
@@ -179,6 +180,11 @@ namespace Online
         curl_easy_setopt(m_curl_session, CURLOPT_LOW_SPEED_LIMIT, 10);
         curl_easy_setopt(m_curl_session, CURLOPT_LOW_SPEED_TIME, 20);
         curl_easy_setopt(m_curl_session, CURLOPT_NOSIGNAL, 1);
+        curl_easy_setopt(m_curl_session, CURLOPT_TCP_KEEPALIVE, 1L);
+        // Share connections, dns and tls sessions with other requests, so
+        // most requests to the stk server skip the tcp and tls handshakes
+        curl_easy_setopt(m_curl_session, CURLOPT_SHARE,
+            RequestManager::get()->getCurlShare());
         //curl_easy_setopt(m_curl_session, CURLOPT_VERBOSE, 1L);
 
         // https, load certificate info
@@ -203,22 +209,66 @@ namespace Online
      */
     void HTTPRequest::operation()
     {
-        if (!m_curl_session)
+        if (!m_curl_session || !startTransfer())
             return;
 
-        FILE *fout = NULL;
+        m_curl_code = curl_easy_perform(m_curl_session);
+        Request::operation();
+        finishTransfer();
+    }   // operation
+
+    // ------------------------------------------------------------------------
+    /** Starts to execute this request in the RequestManager thread: it is
+     *  prepared, and the curl session is returned to be run by the curl multi
+     *  handle of the RequestManager. If no transfer can be started, or the
+     *  request does not use curl for its operation, it is executed completely
+     *  and NULL is returned.
+     */
+    CURL* HTTPRequest::startExecution()
+    {
+        assert(isBusy());
+        if (shouldAbort()) return NULL;
+        prepareOperation();
+        if (shouldAbort()) return NULL;
+        if (m_curl_session && startTransfer())
+            return m_curl_session;
+
+        if (!m_curl_session)
+            operation();
+        completeExecution();
+        return NULL;
+    }   // startExecution
+
+    // ------------------------------------------------------------------------
+    /** Finishes this request after the transfer started in startExecution()
+     *  is done.
+     *  \param code The result of the transfer.
+     */
+    void HTTPRequest::finishExecution(CURLcode code)
+    {
+        m_curl_code = code;
+        finishTransfer();
+        completeExecution();
+    }   // finishExecution
+
+    // ------------------------------------------------------------------------
+    /** Sets up where the received data is stored and the parameters to send.
+     *  \return False if the transfer cannot be done.
+     */
+    bool HTTPRequest::startTransfer()
+    {
         if (m_filename.size() > 0)
         {
-            fout = fopen((m_filename+".part").c_str(), "wb");
+            m_file = fopen((m_filename+".part").c_str(), "wb");
 
-            if (!fout)
+            if (!m_file)
             {
                 Log::error("HTTPRequest",
                            "Can't open '%s' for writing, ignored.",
                            (m_filename+".part").c_str());
-                return;
+                return false;
             }
-            curl_easy_setopt(m_curl_session,  CURLOPT_WRITEDATA,     fout  );
+            curl_easy_setopt(m_curl_session,  CURLOPT_WRITEDATA,     m_file);
             curl_easy_setopt(m_curl_session,  CURLOPT_WRITEFUNCTION, fwrite);
         }
         else
@@ -273,12 +323,18 @@ namespace Online
         const std::string& uagent = StringUtils::getUserAgentString();
         curl_easy_setopt(m_curl_session, CURLOPT_USERAGENT, uagent.c_str());
 
-        m_curl_code = curl_easy_perform(m_curl_session);
-        Request::operation();
+        return true;
+    }   // startTransfer
 
-        if (fout)
+    // ------------------------------------------------------------------------
+    /** Moves a downloaded file to its final name after the transfer.
+     */
+    void HTTPRequest::finishTransfer()
+    {
+        if (m_file)
         {
-            fclose(fout);
+            fclose(m_file);
+            m_file = NULL;
             if (m_curl_code == CURLE_OK)
             {
                 if(UserConfigParams::logAddons())
@@ -304,8 +360,8 @@ namespace Online
                     m_curl_code = CURLE_WRITE_ERROR;
                 }
             }   // m_curl_code ==CURLE_OK
-        }   // if fout
-    }   // operation
+        }   // if m_file
+    }   // finishTransfer
 
     // ------------------------------------------------------------------------
     /** Cleanup once the download is finished. The value of progress is
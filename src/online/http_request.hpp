@@ -41,7 +41,11 @@ namespace Online
         static const std::string SERVER_PATH;
     };
 
-    /** A http request.
+    /** A http request. When executed by the RequestManager thread the
+     *  transfer is run by the curl multi handle of the RequestManager
+     *  together with other requests, see startExecution(). A request which
+     *  replaces operation() with its own code must not create a curl
+     *  session in prepareOperation(), so that operation() is called.
      */
     class HTTPRequest : public Request
     {
@@ -71,7 +75,15 @@ namespace Online
         /** String to store the received data in. */
         std::string m_string_buffer;
 
+        /** The file the data is written to during the transfer, if a
+         *  filename is set. */
+        FILE *m_file;
+
         static struct curl_slist* m_http_header;
+
+        bool startTransfer();
+        void finishTransfer();
+
     protected:
         bool m_disable_sending_log;
 
@@ -95,6 +107,8 @@ namespace Online
                     int priority = 1);
         virtual           ~HTTPRequest()
         {
+            if (m_file)
+                fclose(m_file);
             if (m_curl_session)
             {
                 curl_easy_cleanup(m_curl_session);
@@ -102,6 +116,8 @@ namespace Online
             }
         }
         virtual bool       isAllowedToAdd() const OVERRIDE;
+        virtual CURL*      startExecution() OVERRIDE;
+        virtual void       finishExecution(CURLcode code) OVERRIDE;
         void               setApiURL(const std::string& url, const std::string &action);
         void               setAddonsURL(const std::string& path);
 
@@ -61,15 +61,32 @@ namespace Online
     {
         assert(isBusy());
         // Abort as early as possible if abort is requested
-        if (RequestManager::get()->getAbort() && isAbortable()) return;
+        if (shouldAbort()) return;
         prepareOperation();
-        if (RequestManager::get()->getAbort() && isAbortable()) return;
+        if (shouldAbort()) return;
         operation();
-        if (RequestManager::get()->getAbort() && isAbortable()) return;
+        completeExecution();
+    }   // execute
+
+    // ------------------------------------------------------------------------
+    /** Returns true if STK is quitting and this request can be aborted.
+     */
+    bool Request::shouldAbort() const
+    {
+        return RequestManager::get()->getAbort() && isAbortable();
+    }   // shouldAbort
+
+    // ------------------------------------------------------------------------
+    /** Marks this request as executed after its operation was done, and
+     *  calls afterOperation, unless the request is aborted.
+     */
+    void Request::completeExecution()
+    {
+        if (shouldAbort()) return;
         setExecuted();
-        if (RequestManager::get()->getAbort() && isAbortable()) return;
+        if (shouldAbort()) return;
         afterOperation();
-    }   // execute
+    }   // completeExecution
 
     // ------------------------------------------------------------------------
     /** Executes the request now, i.e. in the main thread and without involving
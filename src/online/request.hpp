@@ -127,6 +127,9 @@ namespace Online
         /** Virtual function to be called after an operation. */
         virtual void afterOperation()   {}
 
+        bool shouldAbort() const;
+        void completeExecution();
+
     public:
         enum RequestType
         {
@@ -139,6 +142,20 @@ namespace Online
         void     executeNow();
         void     queue();
 
+        // --------------------------------------------------------------------
+        /** Starts to execute this request in the RequestManager thread. If a
+         *  curl transfer needs to be done, its handle is returned, and the
+         *  RequestManager calls finishExecution() once the transfer is done.
+         *  Otherwise the request is executed completely and NULL is
+         *  returned. */
+        virtual CURL* startExecution()          { execute(); return NULL; }
+
+        // --------------------------------------------------------------------
+        /** Finishes executing a request after the transfer returned by
+         *  startExecution() is done.
+         *  \param code The result of the transfer. */
+        virtual void finishExecution(CURLcode code)     { assert(false); }
+
         // --------------------------------------------------------------------
         /** Executed when a request has finished. */
         virtual void callback() {}
@@ -23,8 +23,11 @@
 #include "config/player_manager.hpp"
 #include "config/user_config.hpp"
 #include "states_screens/state_manager.hpp"
+#include "utils/log.hpp"
 #include "utils/vs.hpp"
 
+#include <algorithm>
+
 #include <iostream>
 #include <stdio.h>
 #include <memory.h>
@@ -73,6 +76,22 @@ namespace Online
         m_game_polling_interval = 60;  // same for game polling
         m_time_since_poll       = m_menu_polling_interval;
         curl_global_init(CURL_GLOBAL_DEFAULT);
+        m_curl_multi = curl_multi_init();
+        m_curl_share = curl_share_init();
+        curl_share_setopt(m_curl_share, CURLSHOPT_LOCKFUNC,
+                          &RequestManager::lockShare);
+        curl_share_setopt(m_curl_share, CURLSHOPT_UNLOCKFUNC,
+                          &RequestManager::unlockShare);
+        curl_share_setopt(m_curl_share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(m_curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(m_curl_share, CURLSHOPT_SHARE,
+                          CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+        // Sharing connections needs libcurl 7.57, with older versions
+        // connections are still reused by the multi handle
+        curl_share_setopt(m_curl_share, CURLSHOPT_SHARE,
+                          CURL_LOCK_DATA_CONNECT);
+#endif
         pthread_cond_init(&m_cond_request, NULL);
         m_abort.setAtomic(false);
     }   // RequestManager
@@ -85,9 +104,35 @@ namespace Online
         delete m_thread_id.getData();
         m_thread_id.unlock();
         pthread_cond_destroy(&m_cond_request);
+        curl_multi_cleanup(m_curl_multi);
+        // This fails if a request which was not deleted still uses the share
+        if (curl_share_cleanup(m_curl_share) != CURLSHE_OK)
+        {
+            Log::warn("RequestManager", "Curl share handle is still used.");
+        }
         curl_global_cleanup();
     }   // ~RequestManager
 
+    // ------------------------------------------------------------------------
+    /** Locks the data shared between requests, called by curl.
+     */
+    void RequestManager::lockShare(CURL *handle, curl_lock_data data,
+                                   curl_lock_access access, void *userptr)
+    {
+        RequestManager *me = (RequestManager*)userptr;
+        me->m_share_mutex[data].lock();
+    }   // lockShare
+
+    // ------------------------------------------------------------------------
+    /** Unlocks the data shared between requests, called by curl.
+     */
+    void RequestManager::unlockShare(CURL *handle, curl_lock_data data,
+                                     void *userptr)
+    {
+        RequestManager *me = (RequestManager*)userptr;
+        me->m_share_mutex[data].unlock();
+    }   // unlockShare
+
     // ------------------------------------------------------------------------
     /** Start the actual network thread. This can not be done as part of
      *  the constructor, since the assignment to the global network_http
@@ -156,6 +201,9 @@ namespace Online
         // be executed (before the quit request is executed, which causes this
         // thread to exit).
         m_abort.setAtomic(true);
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(m_curl_multi);
+#endif
     }   // stopNetworkThread
 
     // ------------------------------------------------------------------------
@@ -177,15 +225,19 @@ namespace Online
         m_request_queue.lock();
         m_request_queue.getData().push(request);
 
-        // Wake up the network http thread
+        // Wake up the network http thread, it either waits for a request
+        // or for the running transfers
         pthread_cond_signal(&m_cond_request);
         m_request_queue.unlock();
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(m_curl_multi);
+#endif
     }   // addRequest
 
     // ------------------------------------------------------------------------
     /** The actual main loop, which is started as a separate thread from the
-     *  constructor. After testing for a new server, fetching news, the list
-     *  of packages to download, it will wait for commands to be issued.
+     *  constructor. It starts as many requests as allowed and runs their
+     *  transfers, and waits for new requests if none is running.
      *  \param obj: A pointer to this object, passed on by pthread_create
      */
     void *RequestManager::mainLoop(void *obj)
@@ -193,41 +245,48 @@ namespace Online
         VS::setThreadName("RequestManager");
         RequestManager *me = (RequestManager*) obj;
 
-        me->m_current_request = NULL;
         me->m_request_queue.lock();
-        while (me->m_request_queue.getData().empty() ||
-               me->m_request_queue.getData().top()->getType() != Request::RT_QUIT)
+        while (true)
         {
-            bool empty = me->m_request_queue.getData().empty();
+            auto& queue = me->m_request_queue.getData();
 
-            // Wait in cond_wait for a request to arrive. The 'while' is necessary
-            // since "spurious wakeups from the pthread_cond_wait ... may occur"
-            // (pthread_cond_wait man page)!
-            while (empty)
+            // A quit request stops starting new requests, but the running
+            // requests are finished first (so a sign-out request is done,
+            // all abortable requests are aborted by the progress callback).
+            bool quit = false;
+            while (!queue.empty())
             {
-                pthread_cond_wait(&me->m_cond_request, me->m_request_queue.getMutex());
-                empty = me->m_request_queue.getData().empty();
+                Request *request = queue.top();
+                if (request->getType() == Request::RT_QUIT)
+                {
+                    quit = true;
+                    break;
+                }
+                if (!me->canStartRequest(request))
+                    break;
+                queue.pop();
+                me->m_request_queue.unlock();
+                me->startRequest(request);
+                me->m_request_queue.lock();
             }
-            me->m_current_request = me->m_request_queue.getData().top();
-            me->m_request_queue.getData().pop();
 
-            if (me->m_current_request->getType() == Request::RT_QUIT)
+            if (me->m_running_requests.empty())
             {
-                delete me->m_current_request;
-                break;
+                if (quit)
+                    break;
+                // Wait in cond_wait for a request to arrive. The caller
+                // loops since "spurious wakeups from the pthread_cond_wait
+                // ... may occur" (pthread_cond_wait man page)!
+                if (queue.empty())
+                {
+                    pthread_cond_wait(&me->m_cond_request,
+                                      me->m_request_queue.getMutex());
+                }
+                continue;
             }
 
             me->m_request_queue.unlock();
-            me->m_current_request->execute();
-            // This test is necessary in case that execute() was aborted
-            // (otherwise the assert in addResult will be triggered).
-            if (!me->getAbort())
-                me->addResult(me->m_current_request);
-            else if (me->m_current_request->manageMemory())
-            {
-                delete me->m_current_request;
-                me->m_current_request = NULL;
-            }
+            me->runTransfers();
             me->m_request_queue.lock();
         } // while handle all requests
 
@@ -243,7 +302,7 @@ namespace Online
             me->m_request_queue.getData().pop();
 
             // Manage memory can be ignored here, all requests
-            // need to be freed.
+            // need to be freed (including the quit request).
             delete request;
         }
         me->m_request_queue.unlock();
@@ -252,6 +311,104 @@ namespace Online
         return 0;
     }   // mainLoop
 
+    // ------------------------------------------------------------------------
+    /** Returns if a request can be started now. At most max_http_requests
+     *  requests are running at the same time, and one more for requests of
+     *  high priority.
+     *  \param request The request with the highest priority in the queue.
+     */
+    bool RequestManager::canStartRequest(const Request *request) const
+    {
+        const size_t max_requests =
+            (size_t)std::max((int)UserConfigParams::m_max_http_requests, 1);
+        if (m_running_requests.size() < max_requests)
+            return true;
+        return request->getPriority() >= HTTP_HIGH_PRIORITY &&
+            m_running_requests.size() < max_requests + 1;
+    }   // canStartRequest
+
+    // ------------------------------------------------------------------------
+    /** Starts a request. If it needs a transfer, it is added to the multi
+     *  handle, otherwise it is finished immediately.
+     *  \param request The request to start.
+     */
+    void RequestManager::startRequest(Request *request)
+    {
+        CURL *handle = request->startExecution();
+        if (!handle)
+        {
+            finishRequest(request);
+            return;
+        }
+        CURLMcode code = curl_multi_add_handle(m_curl_multi, handle);
+        if (code != CURLM_OK)
+        {
+            Log::error("RequestManager", "Cannot start request: %s",
+                       curl_multi_strerror(code));
+            request->finishExecution(CURLE_FAILED_INIT);
+            finishRequest(request);
+            return;
+        }
+        m_running_requests[handle] = request;
+    }   // startRequest
+
+    // ------------------------------------------------------------------------
+    /** Runs the transfers of all running requests, finishes the requests
+     *  whose transfer is done, then waits for network activity, a new request
+     *  or at most a second.
+     */
+    void RequestManager::runTransfers()
+    {
+        int still_running = 0;
+        curl_multi_perform(m_curl_multi, &still_running);
+
+        int messages_left = 0;
+        while (CURLMsg *msg = curl_multi_info_read(m_curl_multi,
+                                                   &messages_left))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            // The message is freed when the handle is removed
+            CURL *handle = msg->easy_handle;
+            CURLcode code = msg->data.result;
+            curl_multi_remove_handle(m_curl_multi, handle);
+            auto it = m_running_requests.find(handle);
+            assert(it != m_running_requests.end());
+            Request *request = it->second;
+            m_running_requests.erase(it);
+            request->finishExecution(code);
+            finishRequest(request);
+        }
+
+        if (m_running_requests.empty())
+            return;
+#if LIBCURL_VERSION_NUM >= 0x074400
+        // New requests wake up curl_multi_poll with curl_multi_wakeup
+        curl_multi_poll(m_curl_multi, NULL, 0, 1000, NULL);
+#elif LIBCURL_VERSION_NUM >= 0x074200
+        // curl_multi_wakeup only exists since libcurl 7.68.0, so wait
+        // shortly to notice new requests
+        curl_multi_poll(m_curl_multi, NULL, 0, 10, NULL);
+#else
+        // New requests cannot wake up curl_multi_wait, so wait shortly
+        curl_multi_wait(m_curl_multi, NULL, 0, 10, NULL);
+#endif
+    }   // runTransfers
+
+    // ------------------------------------------------------------------------
+    /** Passes a request which was executed to the main thread.
+     *  \param request The executed request.
+     */
+    void RequestManager::finishRequest(Request *request)
+    {
+        // This test is necessary in case that the execution was aborted
+        // (otherwise the assert in addResult will be triggered).
+        if (!getAbort())
+            addResult(request);
+        else if (request->manageMemory())
+            delete request;
+    }   // finishRequest
+
     // ------------------------------------------------------------------------
     /** Inserts a request into the queue of results.
      *  \param request The pointer to the request to insert.
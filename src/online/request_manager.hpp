@@ -36,6 +36,8 @@
 #endif
 
 #include <curl/curl.h>
+#include <map>
+#include <mutex>
 #include <queue>
 #include <pthread.h>
 
@@ -73,6 +75,13 @@ namespace Online
      *  on first start of stk (which will trigger downloading of all addon
      *  icons) is it possible that actually a download request is running,
      *  which might take a bit before it can be deleted.
+     *  The transfers of http requests are run by a curl multi handle, so
+     *  several requests (up to max_http_requests in the user config) are
+     *  executed at the same time. Requests with at least HTTP_HIGH_PRIORITY
+     *  can use one more slot, so e.g. a server polling for connection
+     *  requests is never delayed by addon downloads or ranking submissions.
+     *  All requests share their connections, dns cache and tls sessions,
+     *  so requests to the same server reuse an open connection.
      * \ingroup online
      */
     class RequestManager : public CanBeDeleted
@@ -95,8 +104,19 @@ namespace Online
             /** Time passed since the last poll request. */
             float                     m_time_since_poll;
 
-            /** The current requested being worked on. */
-            Online::Request *         m_current_request;
+            /** The requests whose transfer is run by m_curl_multi, by their
+             *  curl handle. Only used by the RequestManager thread. */
+            std::map<CURL*, Online::Request*> m_running_requests;
+
+            /** The curl multi handle running the transfers. */
+            CURLM *                   m_curl_multi;
+
+            /** Shared connection cache, dns cache and tls sessions of all
+             *  requests. */
+            CURLSH *                  m_curl_share;
+
+            /** Protects the data shared in m_curl_share. */
+            std::mutex                m_share_mutex[CURL_LOCK_DATA_LAST];
 
             /** A conditional variable to wake up the main loop. */
             pthread_cond_t            m_cond_request;
@@ -129,8 +149,16 @@ namespace Online
 
             void addResult(Online::Request *request);
             void handleResultQueue();
+            bool canStartRequest(const Online::Request *request) const;
+            void startRequest(Online::Request *request);
+            void finishRequest(Online::Request *request);
+            void runTransfers();
 
             static void *mainLoop(void *obj);
+            static void lockShare(CURL *handle, curl_lock_data data,
+                                  curl_lock_access access, void *userptr);
+            static void unlockShare(CURL *handle, curl_lock_data data,
+                                    void *userptr);
 
             RequestManager(); //const std::string &url
             ~RequestManager();
@@ -140,6 +168,10 @@ namespace Online
         public:
             static const int HTTP_MAX_PRIORITY = 9999;
 
+            /** Requests with at least this priority can be started even if
+             *  the maximum number of requests are running. */
+            static const int HTTP_HIGH_PRIORITY = 100;
+
             // ----------------------------------------------------------------
             /** Singleton access function. Creates the RequestManager if
              * necessary. */
@@ -163,6 +195,10 @@ namespace Online
             bool getAbort() { return m_abort.getAtomic(); }
             void update(float dt);
 
+            // ----------------------------------------------------------------
+            /** Returns the curl share handle to be used by all requests. */
+            CURLSH* getCurlShare() const { return m_curl_share; }
+
             // ----------------------------------------------------------------
             /** Sets the interval with which poll requests are send to the
              *  server. This can happen from the news manager (i.e. info
@@ -43,6 +43,7 @@ namespace Online
         m_info     = "";
         m_success  = false;
         m_xml_data = NULL;
+        m_stream_depth = 0;
         m_exists = std::make_shared<bool>(true);
     }   // XMLRequest
 
@@ -54,11 +55,19 @@ namespace Online
     }   // ~XMLRequest
 
     // ------------------------------------------------------------------------
-    /** On a successful download converts the string into an XML tree.
+    /** On a successful download converts the string into an XML tree, or
+     *  streams the elements at the stream depth to onStreamedNode().
      */
     void XMLRequest::afterOperation()
     {
-        m_xml_data = file_manager->createXMLTreeFromString(getData());
+        if (m_stream_depth > 0)
+        {
+            m_xml_data = file_manager->createXMLTreeFromString(getData(),
+                m_stream_depth,
+                [this](const XMLNode &node) { onStreamedNode(node); });
+        }
+        else
+            m_xml_data = file_manager->createXMLTreeFromString(getData());
         if (hadDownloadError())
         {
             Log::error("XMLRequest::afterOperation",
@@ -44,6 +44,10 @@ namespace Online
         /** On a successful download contains the converted XML tree. */
         XMLNode *m_xml_data;
 
+        /** If not 0, the elements at this depth of the answer are passed to
+         *  onStreamedNode() instead of being stored in m_xml_data. */
+        unsigned m_stream_depth;
+
         std::shared_ptr<bool> m_exists;
     protected:
 
@@ -55,6 +59,17 @@ namespace Online
         bool m_success;
 
         virtual void afterOperation() OVERRIDE;
+        // --------------------------------------------------------------------
+        /** Requests that the elements at the given depth of the answer (e.g.
+         *  2 for the entries of a list inside the root element) are passed
+         *  one at a time to onStreamedNode(), so that long answers are never
+         *  converted into a complete XML tree. */
+        void setStreamDepth(unsigned depth)         { m_stream_depth = depth; }
+        // --------------------------------------------------------------------
+        /** Called from the request thread for each element at the stream
+         *  depth while the answer is parsed. The node is deleted afterwards,
+         *  so it must not be stored. */
+        virtual void onStreamedNode(const XMLNode &node) {}
 
     public :
         XMLRequest(bool manage_memory = false, int priority = 1);
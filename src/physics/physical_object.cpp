@@ -844,6 +844,17 @@ BareNetworkString* PhysicalObject::saveState(std::vector<std::string>* ru)
     return buffer;
 }   // saveState
 
+// ----------------------------------------------------------------------------
+/** Saves the current values of the body without the check in saveState if
+ *  it moved. Unlike saveState the body is not rounded to the sent values.
+ */
+BareNetworkString* PhysicalObject::savePredictedState()
+{
+    BareNetworkString* buffer = new BareNetworkString();
+    CompressNetworkBody::write(m_body, buffer);
+    return buffer;
+}   // savePredictedState
+
 // ----------------------------------------------------------------------------
 void PhysicalObject::restoreState(BareNetworkString *buffer, int count)
 {
@@ -286,6 +286,8 @@ public:
     virtual void saveTransform();
     virtual void computeError();
     virtual BareNetworkString* saveState(std::vector<std::string>* ru);
+    // ------------------------------------------------------------------------
+    virtual BareNetworkString* savePredictedState();
     virtual void undoEvent(BareNetworkString *buffer) {}
     virtual void rewindToEvent(BareNetworkString *buffer) {}
     virtual void restoreState(BareNetworkString *buffer, int count);
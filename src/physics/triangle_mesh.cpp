@@ -25,8 +25,10 @@
 #include "utils/time.hpp"
 
 #include "btBulletDynamicsCommon.h"
+#include "BulletCollision/NarrowPhaseCollision/btRaycastCallback.h"
 
 #include <fstream>
+#include <random>
 
 // -----------------------------------------------------------------------------
 /** Constructor: Initialises all data structures with zero.
@@ -320,90 +322,240 @@ btVector3 TriangleMesh::getInterpolatedNormal(unsigned int index,
 bool TriangleMesh::castRay(const btVector3 &from, const btVector3 &to,
                            btVector3 *xyz, const Material **material,
                            btVector3 *normal, bool interpolate_normal) const
+{
+    RayQuery ray;
+    ray.m_from = from;
+    ray.m_to   = to;
+    castRays(&ray, 1, interpolate_normal);
+    *material = ray.m_material;
+    if (ray.m_hit)
+        *xyz = ray.m_hit_point;
+    if (normal)
+        *normal = ray.m_normal;
+    return ray.m_hit;
+}   // castRay
+
+// ----------------------------------------------------------------------------
+/** Casts a batch of rays against this mesh. The transform of the mesh is
+ *  only computed once for all rays, and the bounding volume hierarchy of the
+ *  mesh is traversed directly, which avoids the overhead of a separate
+ *  btCollisionWorld::rayTestSingle call for each ray. The results are
+ *  identical to btCollisionWorld::rayTestSingle, which unitTesting()
+ *  checks. Only bulk queries known in advance use it, e.g.
+ *  Track::buildHeightMap. The terrain rays of karts depend on the state
+ *  computed earlier in the same update, so they still use castRay one ray
+ *  at a time.
+ *  \param rays The rays to cast, on return their results.
+ *  \param count Number of rays.
+ *  \param interpolate_normal If true, the returned normals are interpolated
+ *         based on the three normals of the triangle and the location of the
+ *         hit point.
+ */
+void TriangleMesh::castRays(RayQuery *rays, unsigned int count,
+                            bool interpolate_normal) const
 {
     if(!m_collision_shape)
     {
-        *material=NULL;
-        return false;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            rays[i].m_hit      = false;
+            rays[i].m_material = NULL;
+            rays[i].m_normal.setValue(0, 1, 0);
+        }
+        return;
     }
 
-    btTransform trans_from;
-    trans_from.setIdentity();
-    trans_from.setOrigin(from);
-
-    btTransform trans_to;
-    trans_to.setIdentity();
-    trans_to.setOrigin(to);
-
     btTransform world_trans;
     // If there is a body, take the current transform from the body.
     if(m_body)
         world_trans = m_body->getWorldTransform();
     else
         world_trans.setIdentity();
+    const btTransform world_to_mesh = world_trans.inverse();
 
-    btCollisionWorld::ClosestRayResultCallback result(from, to);
+    /** A ray callback that stores the index and world space normal of the
+     *  closest triangle hit, in the same way btCollisionWorld does. */
+    class MaterialRayResult : public btTriangleRaycastCallback
+    {
+    public:
+        /** Stores the index of the triangle that was hit. */
+        int m_index;
+        /** The normal of the triangle hit in world space. */
+        btVector3 m_normal;
+        /** Rotation of the mesh to convert the normal to world space. */
+        const btMatrix3x3 &m_basis;
+        // --------------------------------------------------------------------
+        MaterialRayResult(const btVector3 &from, const btVector3 &to,
+                          const btMatrix3x3 &basis)
+            : btTriangleRaycastCallback(from, to), m_basis(basis)
+        {
+            m_index = -1;
+        }   // MaterialRayResult
+        // --------------------------------------------------------------------
+        virtual btScalar reportHit(const btVector3 &normal, btScalar fraction,
+                                   int part_id, int triangle_index)
+        {
+            m_index  = triangle_index;
+            m_normal = m_basis * normal;
+            return fraction;
+        }   // reportHit
+    };   // MaterialRayResult
+
+    // createCollisionShape always creates a btBvhTriangleMeshShape
+    assert(m_collision_shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE);
+    btBvhTriangleMeshShape *shape =
+        static_cast<btBvhTriangleMeshShape*>(m_collision_shape);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        RayQuery &ray = rays[i];
+        MaterialRayResult ray_callback(world_to_mesh * ray.m_from,
+                                       world_to_mesh * ray.m_to,
+                                       world_trans.getBasis());
+        shape->performRaycast(&ray_callback, ray_callback.m_from,
+                              ray_callback.m_to);
+        ray.m_hit = ray_callback.m_index != -1;
+        if (!ray.m_hit)
+        {
+            ray.m_material = NULL;
+            ray.m_normal.setValue(0, 1, 0);
+            continue;
+        }
 
-    /** A special ray result class that stores the index of the triangle
-     *  that was hit. */
+        ray.m_hit_point.setInterpolate3(ray.m_from, ray.m_to,
+                                        ray_callback.m_hitFraction);
+        ray.m_hit_point.setW(0.0f);
+        ray.m_material = m_triangleIndex2Material[ray_callback.m_index];
+        // If requested interpolate the normal. I.e. instead of using
+        // the normal of the triangle interpolate the normal at the
+        // hit position based on the three normals of the triangle.
+        if(interpolate_normal)
+            ray.m_normal = getInterpolatedNormal(ray_callback.m_index,
+                                                 ray.m_hit_point);
+        else
+            ray.m_normal = ray_callback.m_normal;
+        ray.m_normal.normalize();
+    }   // for i < count
+}   // castRays
+
+// ----------------------------------------------------------------------------
+/** Compares castRays with a ray cast using btCollisionWorld::rayTestSingle,
+ *  which castRay used before, for random rays against a random mesh, with
+ *  and without a transformed body.
+ */
+void TriangleMesh::unitTesting()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> coord(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+    auto random_point = [&]()
+    {
+        return btVector3(coord(random), coord(random), coord(random));
+    };
+    // The materials are only compared, so any distinct pointers will do
+    static const char materials[500] = { 0 };
+
+    /** Stores the index of the triangle hit, like castRay did. */
     class MaterialRayResult : public btCollisionWorld::ClosestRayResultCallback
     {
     public:
-        /** Stores the index of the triangle that was hit. */
         int m_index;
         // --------------------------------------------------------------------
-        MaterialRayResult(const btVector3 &p1, const btVector3 &p2,
-                          const TriangleMesh *me)
-                        : btCollisionWorld::ClosestRayResultCallback(p1,p2)
+        MaterialRayResult(const btVector3 &from, const btVector3 &to)
+            : btCollisionWorld::ClosestRayResultCallback(from, to)
         {
-            m_index = -1;;
+            m_index = -1;
         }   // MaterialRayResult
         // --------------------------------------------------------------------
-        virtual btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult,
-                                         bool normalInWorldSpace)
+        virtual btScalar addSingleResult(
+            btCollisionWorld::LocalRayResult& ray_result,
+            bool normal_in_world_space)
         {
-            m_index = rayResult.m_localShapeInfo->m_triangleIndex;
+            m_index = ray_result.m_localShapeInfo->m_triangleIndex;
             return btCollisionWorld::ClosestRayResultCallback
-                    ::addSingleResult(rayResult, normalInWorldSpace);
-        }   // AddSingleResult
-        // --------------------------------------------------------------------
-    };   // myCollision
-
-    MaterialRayResult ray_callback(from, to, this);
-
-    // If this is a rigid body, m_collision_object is NULL, and the
-    // rigid body is the actual collision object.
-    btCollisionWorld::rayTestSingle(trans_from, trans_to,
-                                    m_collision_object ? m_collision_object : m_body,
-                                    m_collision_shape, world_trans,
-                                    ray_callback);
-    // Get the index of the triangle hit
-    int index = ray_callback.m_index;
-    if(ray_callback.hasHit())
+                ::addSingleResult(ray_result, normal_in_world_space);
+        }   // addSingleResult
+    };   // MaterialRayResult
+
+    for (int transformed = 0; transformed < 2; transformed++)
     {
-        *xyz      = ray_callback.m_hitPointWorld;
-        xyz->setW(0.0f);
-        *material = m_triangleIndex2Material[index];
+        TriangleMesh mesh(/*can_be_transformed*/transformed == 1);
+        for (unsigned int i = 0; i < sizeof(materials); i++)
+        {
+            btVector3 p1 = random_point();
+            btVector3 p2 = p1 + btVector3(offset(random), offset(random),
+                                          offset(random));
+            btVector3 p3 = p1 + btVector3(offset(random), offset(random),
+                                          offset(random));
+            btVector3 normal = (p2 - p1).cross(p3 - p1).normalized();
+            mesh.addTriangle(p1, p2, p3, normal, normal, normal,
+                             (const Material*)(materials + i));
+        }
+        mesh.createCollisionShape(/*create_collision_object*/transformed == 0);
+        btRigidBody *body = NULL;
+        if (transformed == 1)
+        {
+            btRigidBody::btRigidBodyConstructionInfo info(0.0f, NULL,
+                mesh.m_collision_shape);
+            info.m_startWorldTransform.setRotation(
+                btQuaternion(btVector3(1, 2, 3).normalized(), 0.7f));
+            info.m_startWorldTransform.setOrigin(btVector3(3, -4, 5));
+            body = new btRigidBody(info);
+            mesh.setBody(body);
+        }
+        btCollisionObject *object = mesh.m_collision_object ?
+            mesh.m_collision_object : mesh.m_body;
+        btTransform world_trans = object->getWorldTransform();
 
-        if(normal)
+        std::vector<RayQuery> rays(2000);
+        for (unsigned int i = 0; i < rays.size(); i++)
         {
-            // If requested interpolate the normal. I.e. instead of using
-            // the normal of the triangle interpolate the normal at the
-            // hit position based on the three normals of the triangle.
-            if(interpolate_normal)
-                *normal = getInterpolatedNormal(ray_callback.m_index,
-                                                ray_callback.m_hitPointWorld);
+            rays[i].m_from = random_point();
+            // Half of the rays go straight down like the terrain rays
+            if (i % 2 == 0)
+                rays[i].m_to = rays[i].m_from - btVector3(0, 100, 0);
             else
-                *normal = ray_callback.m_hitNormalWorld;
-            normal->normalize();
+                rays[i].m_to = random_point();
         }
-    }
-    else
-    {
-        *material = NULL;
-        if(normal)
-            normal->setValue(0, 1, 0);
-    }
-    return ray_callback.hasHit();
 
-}   // castRay
+        unsigned int hits = 0;
+        for (int interpolate = 0; interpolate < 2; interpolate++)
+        {
+            mesh.castRays(rays.data(), (unsigned int)rays.size(),
+                          interpolate == 1);
+            for (const RayQuery &ray : rays)
+            {
+                btTransform trans_from, trans_to;
+                trans_from.setIdentity();
+                trans_from.setOrigin(ray.m_from);
+                trans_to.setIdentity();
+                trans_to.setOrigin(ray.m_to);
+                MaterialRayResult result(ray.m_from, ray.m_to);
+                btCollisionWorld::rayTestSingle(trans_from, trans_to,
+                    object, mesh.m_collision_shape, world_trans, result);
+                assert(ray.m_hit == result.hasHit());
+                if (!ray.m_hit)
+                {
+                    assert(ray.m_material == NULL);
+                    continue;
+                }
+                hits++;
+                assert(ray.m_material ==
+                       mesh.m_triangleIndex2Material[result.m_index]);
+                btVector3 hit_point = result.m_hitPointWorld;
+                hit_point.setW(0.0f);
+                assert(ray.m_hit_point == hit_point);
+                btVector3 normal = interpolate == 1 ?
+                    mesh.getInterpolatedNormal(result.m_index, hit_point) :
+                    result.m_hitNormalWorld;
+                normal.normalize();
+                assert((ray.m_normal - normal).length2() < 1e-10f);
+                (void)normal;   // avoid compiler warnings without asserts
+            }
+        }
+        // Make sure the test is not trivial
+        assert(hits > rays.size() / 4);
+        (void)hits;
+        delete body;
+    }
+}   // unitTesting
@@ -58,6 +58,20 @@ private:
     bool m_can_be_transformed;
 
 public:
+    /** A ray for castRays, which also stores the result of the ray. */
+    struct RayQuery
+    {
+        btVector3       m_from;
+        btVector3       m_to;
+        /** The position where the ray hit, only set if m_hit is true. */
+        btVector3       m_hit_point;
+        /** The normal at the hit point, (0,1,0) if nothing was hit. */
+        btVector3       m_normal;
+        /** The material that was hit, NULL if nothing was hit. */
+        const Material *m_material;
+        bool            m_hit;
+    };
+
     class RigidBodyTriangleMesh : public btRigidBody
     {
     public:
@@ -113,6 +127,11 @@ public:
                  btVector3 *xyz, const Material **material,
                  btVector3 *normal=NULL, bool interpolate_normal=false) const;
     // ------------------------------------------------------------------------
+    void castRays(RayQuery *rays, unsigned int count,
+                  bool interpolate_normal=false) const;
+    // ------------------------------------------------------------------------
+    static void unitTesting();
+    // ------------------------------------------------------------------------
     /** Returns the points of the 'indx' triangle.
      *  \param indx Index of the triangle to get.
      *  \param p1,p2,p3 On return the three points of the triangle. */
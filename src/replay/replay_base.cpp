@@ -18,6 +18,11 @@
 #include "replay/replay_base.hpp"
 
 #include "io/file_manager.hpp"
+#include "network/network_string.hpp"
+#include "utils/mini_glm.hpp"
+
+#include <cmath>
+#include <stdexcept>
 
 // -----------------------------------------------------------------------------
 ReplayBase::ReplayBase()
@@ -33,7 +38,7 @@ FILE* ReplayBase::openReplayFile(bool writeable, bool full_path, int replay_file
 {
     FILE *fd = fopen(full_path ? getReplayFilename(replay_file_number).c_str() :
         (file_manager->getReplayDir() + getReplayFilename(replay_file_number)).c_str(),
-        writeable ? "w" : "r");
+        writeable ? "wb" : "rb");
     if (!fd)
     {
         return NULL;
@@ -41,3 +46,129 @@ FILE* ReplayBase::openReplayFile(bool writeable, bool full_path, int replay_file
     return fd;
 
 }   // openReplayFile
+
+// -----------------------------------------------------------------------------
+/** Adds a signed integer using as few bytes as possible: small values (e.g.
+ *  the difference to the previous event) need only one byte.
+ *  \param buffer The buffer to add the value to.
+ *  \param value The value to add.
+ */
+void ReplayBase::addVarInt(BareNetworkString* buffer, int32_t value)
+{
+    // Zigzag encoding, so small negative values are small as well
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (v >= 0x80)
+    {
+        buffer->addUInt8((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    buffer->addUInt8((uint8_t)v);
+}   // addVarInt
+
+// -----------------------------------------------------------------------------
+/** Reads a signed integer added with addVarInt.
+ *  \param buffer The buffer to read from.
+ *  \throw std::out_of_range or std::runtime_error if the data is invalid.
+ */
+int32_t ReplayBase::getVarInt(const BareNetworkString* buffer)
+{
+    uint32_t v = 0;
+    for (unsigned shift = 0; shift < 35; shift += 7)
+    {
+        const uint8_t byte = buffer->getUInt8();
+        v |= (uint32_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+    }
+    throw std::runtime_error("Invalid integer in replay data");
+}   // getVarInt
+
+// -----------------------------------------------------------------------------
+/** Adds one event of a kart in the binary replay format. Transforms are
+ *  quantized like in CompressNetworkBody, and time, position and distance
+ *  are stored as difference to the previous event of the same kart.
+ *  \param buffer The buffer to add the event to.
+ *  \param previous The quantized previous event of this kart (all 0 for
+ *         the first event), which is updated.
+ */
+void ReplayBase::encodeEvent(BareNetworkString* buffer,
+                             const TransformEvent& te, const PhysicInfo& pi,
+                             const BonusInfo& bi, const KartReplayEvent& kre,
+                             QuantizedEvent* previous)
+{
+    QuantizedEvent q;
+    q.m_time = (int32_t)lroundf(te.m_time * 1000.0f);
+    const btVector3& xyz = te.m_transform.getOrigin();
+    for (unsigned i = 0; i < 3; i++)
+        q.m_position[i] = (int32_t)lroundf(xyz[i] * 1000.0f);
+    q.m_distance = (int32_t)lroundf(kre.m_distance * 100.0f);
+
+    addVarInt(buffer, q.m_time - previous->m_time);
+    for (unsigned i = 0; i < 3; i++)
+        addVarInt(buffer, q.m_position[i] - previous->m_position[i]);
+    buffer->addUInt32(
+        MiniGLM::compressQuaternion(te.m_transform.getRotation()));
+
+    buffer->addUInt16(MiniGLM::toFloat16(pi.m_speed));
+    buffer->addUInt16(MiniGLM::toFloat16(pi.m_steer));
+    for (unsigned i = 0; i < 4; i++)
+        buffer->addUInt16(MiniGLM::toFloat16(pi.m_suspension_length[i]));
+    addVarInt(buffer, pi.m_skidding_state);
+
+    addVarInt(buffer, bi.m_attachment);
+    buffer->addUInt16(MiniGLM::toFloat16(bi.m_nitro_amount));
+    addVarInt(buffer, bi.m_item_amount);
+    addVarInt(buffer, bi.m_item_type);
+    addVarInt(buffer, bi.m_special_value);
+
+    addVarInt(buffer, q.m_distance - previous->m_distance);
+    addVarInt(buffer, kre.m_nitro_usage);
+    addVarInt(buffer, kre.m_skidding_effect);
+    buffer->addUInt8((kre.m_zipper_usage ? 1 : 0) |
+                     (kre.m_red_skidding ? 2 : 0) |
+                     (kre.m_jumping      ? 4 : 0));
+    *previous = q;
+}   // encodeEvent
+
+// -----------------------------------------------------------------------------
+/** Reads one event of a kart added with encodeEvent.
+ *  \param buffer The buffer to read from.
+ *  \param previous The quantized previous event of this kart (all 0 for
+ *         the first event), which is updated.
+ *  \throw std::out_of_range or std::runtime_error if the data is invalid.
+ */
+void ReplayBase::decodeEvent(const BareNetworkString* buffer,
+                             TransformEvent* te, PhysicInfo* pi,
+                             BonusInfo* bi, KartReplayEvent* kre,
+                             QuantizedEvent* previous)
+{
+    previous->m_time += getVarInt(buffer);
+    for (unsigned i = 0; i < 3; i++)
+        previous->m_position[i] += getVarInt(buffer);
+    const btQuaternion q = MiniGLM::decompressbtQuaternion(buffer->getUInt32());
+    te->m_time = previous->m_time / 1000.0f;
+    te->m_transform = btTransform(q, btVector3(
+        previous->m_position[0] / 1000.0f, previous->m_position[1] / 1000.0f,
+        previous->m_position[2] / 1000.0f));
+
+    pi->m_speed = MiniGLM::toFloat32(buffer->getUInt16());
+    pi->m_steer = MiniGLM::toFloat32(buffer->getUInt16());
+    for (unsigned i = 0; i < 4; i++)
+        pi->m_suspension_length[i] = MiniGLM::toFloat32(buffer->getUInt16());
+    pi->m_skidding_state = getVarInt(buffer);
+
+    bi->m_attachment = getVarInt(buffer);
+    bi->m_nitro_amount = MiniGLM::toFloat32(buffer->getUInt16());
+    bi->m_item_amount = getVarInt(buffer);
+    bi->m_item_type = getVarInt(buffer);
+    bi->m_special_value = getVarInt(buffer);
+
+    previous->m_distance += getVarInt(buffer);
+    kre->m_distance = previous->m_distance / 100.0f;
+    kre->m_nitro_usage = getVarInt(buffer);
+    kre->m_skidding_effect = getVarInt(buffer);
+    const uint8_t flags = buffer->getUInt8();
+    kre->m_zipper_usage = (flags & 1) != 0;
+    kre->m_red_skidding = (flags & 2) != 0;
+    kre->m_jumping      = (flags & 4) != 0;
+}   // decodeEvent
@@ -22,10 +22,13 @@
 #include "LinearMath/btTransform.h"
 #include "utils/no_copy.hpp"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <string>
 #include <vector>
 
+class BareNetworkString;
+
 /**
   * \ingroup race
   */
@@ -97,15 +100,43 @@ protected:
         bool        m_jumping;
     };   // KartReplayEvent
 
+    // ------------------------------------------------------------------------
+    /** The quantized values of the previous event of a kart, which are
+     *  stored as differences in the binary replay format. */
+    struct QuantizedEvent
+    {
+        /** Time in milliseconds. */
+        int32_t m_time;
+        /** Position in millimetres. */
+        int32_t m_position[3];
+        /** Distance on track in centimetres. */
+        int32_t m_distance;
+    };   // QuantizedEvent
+
     // ------------------------------------------------------------------------
     FILE *openReplayFile(bool writeable, bool full_path = false, int replay_file_number=1);
     // ------------------------------------------------------------------------
+    static void addVarInt(BareNetworkString* buffer, int32_t value);
+    // ------------------------------------------------------------------------
+    static int32_t getVarInt(const BareNetworkString* buffer);
+    // ------------------------------------------------------------------------
+    static void encodeEvent(BareNetworkString* buffer,
+                            const TransformEvent& te, const PhysicInfo& pi,
+                            const BonusInfo& bi, const KartReplayEvent& kre,
+                            QuantizedEvent* previous);
+    // ------------------------------------------------------------------------
+    static void decodeEvent(const BareNetworkString* buffer,
+                            TransformEvent* te, PhysicInfo* pi,
+                            BonusInfo* bi, KartReplayEvent* kre,
+                            QuantizedEvent* previous);
+    // ------------------------------------------------------------------------
     /** Returns the filename that was opened. */
     virtual const std::string& getReplayFilename(int replay_file_number = 1) const = 0;
     // ------------------------------------------------------------------------
     /** Returns the version number of the replay file recorderd by this executable.
-     *  This is also used as a maximum supported version by this exexcutable. */
-    unsigned int getCurrentReplayVersion() const { return 4; }
+     *  This is also used as a maximum supported version by this exexcutable.
+     *  Version 5 stores the events in a binary format after the header. */
+    unsigned int getCurrentReplayVersion() const { return 5; }
 
     // ------------------------------------------------------------------------
     /** This is used to check that a loaded replay file can still
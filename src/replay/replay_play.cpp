@@ -20,15 +20,20 @@
 
 #include "config/stk_config.hpp"
 #include "io/file_manager.hpp"
+#include "io/utf_writer.hpp"
+#include "io/xml_node.hpp"
 #include "karts/ghost_kart.hpp"
 #include "karts/controller/ghost_controller.hpp"
 #include "modes/world.hpp"
+#include "network/network_string.hpp"
 #include "race/race_manager.hpp"
 #include "tracks/track.hpp"
 #include "tracks/track_manager.hpp"
+#include "utils/string_utils.hpp"
 
 #include <irrlicht.h>
 #include <stdio.h>
+#include <stdexcept>
 #include <string>
 #include <cinttypes>
 
@@ -43,6 +48,8 @@ ReplayPlay::ReplayPlay()
     m_current_replay_file   = 0;
     m_second_replay_file    = 0;
     m_second_replay_enabled = false;
+    m_replay_index_loaded   = false;
+    m_replay_index_changed  = false;
 }   // ReplayPlay
 
 //-----------------------------------------------------------------------------
@@ -63,9 +70,15 @@ void ReplayPlay::reset()
 }   // reset
 
 //-----------------------------------------------------------------------------
+/** Reads the header of all replay files. Headers of files which didn't
+ *  change since they were read before are taken from the replay index, so
+ *  only new replay files have to be opened.
+ */
 void ReplayPlay::loadAllReplayFile()
 {
     m_replay_file_list.clear();
+    loadReplayIndex();
+    std::set<std::string> all_paths;
 
     // Load stock replay first
     std::set<std::string> pre_record;
@@ -74,6 +87,7 @@ void ReplayPlay::loadAllReplayFile()
     for (std::set<std::string>::iterator i  = pre_record.begin();
                                          i != pre_record.end(); ++i)
     {
+        all_paths.insert(*i);
         if (!addReplayFile(*i, /*custom_replay*/ true))
         {
             // Skip invalid replay file
@@ -91,6 +105,7 @@ void ReplayPlay::loadAllReplayFile()
     for (std::set<std::string>::iterator i  = files.begin();
                                          i != files.end(); ++i)
     {
+        all_paths.insert(file_manager->getReplayDir() + *i);
         if (!addReplayFile(*i, false, j))
         {
             // Skip invalid replay file
@@ -99,22 +114,265 @@ void ReplayPlay::loadAllReplayFile()
         j++;
     }
 
+    // Remove deleted replay files from the index
+    for (auto it = m_replay_index.begin(); it != m_replay_index.end();)
+    {
+        if (all_paths.find(it->first) == all_paths.end())
+        {
+            it = m_replay_index.erase(it);
+            m_replay_index_changed = true;
+        }
+        else
+            it++;
+    }
+    for (auto it = m_invalid_replay_files.begin();
+         it != m_invalid_replay_files.end();)
+    {
+        if (all_paths.find(it->first) == all_paths.end())
+        {
+            it = m_invalid_replay_files.erase(it);
+            m_replay_index_changed = true;
+        }
+        else
+            it++;
+    }
+    saveReplayIndex();
+
 }   // loadAllReplayFile
 
 //-----------------------------------------------------------------------------
-bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int call_index)
+/** Returns the name of the file storing the replay index. */
+std::string ReplayPlay::getReplayIndexFilename() const
 {
+    return file_manager->getReplayDir() + "replay_index.xml";
+}   // getReplayIndexFilename
 
-    char s[1024], s1[1024];
+//-----------------------------------------------------------------------------
+/** Reads the replay index, which caches the header of all replay files read
+ *  before together with the modification time of the file, and the
+ *  modification time of files which could not be read. It is only read
+ *  once, afterwards it's kept up to date in memory.
+ */
+void ReplayPlay::loadReplayIndex()
+{
+    if (m_replay_index_loaded) return;
+    m_replay_index_loaded = true;
+
+    const std::string filename = getReplayIndexFilename();
+    if (!file_manager->fileExists(filename)) return;
+    XMLNode* root = file_manager->createXMLTree(filename);
+    if (!root) return;
+
+    unsigned int version = 0;
+    root->get("version", &version);
+    if (root->getName() != "replay-index" ||
+        version != getCurrentReplayVersion())
+    {
+        // Rebuild the index from scratch if it was written by another
+        // version of STK
+        delete root;
+        return;
+    }
+
+    for (unsigned int i = 0; i < root->getNumNodes(); i++)
+    {
+        const XMLNode* node = root->getNode(i);
+        core::stringw path;
+        int64_t mtime = 0, uid = 0;
+        if (node->getName() == "invalid")
+        {
+            if (node->get("path", &path) && node->get("mtime", &mtime))
+            {
+                m_invalid_replay_files[StringUtils::wideToUtf8(path)] =
+                    (uint64_t)mtime;
+            }
+            continue;
+        }
+        ReplayData rd;
+        rd.m_track = NULL;
+        rd.m_custom_replay_file = false;
+        if (!node->get("path", &path) || !node->get("mtime", &mtime) ||
+            !node->get("version", &rd.m_replay_version) ||
+            !node->get("stk-version", &rd.m_stk_version) ||
+            !node->get("user", &rd.m_user_name) ||
+            !node->get("track", &rd.m_track_name) ||
+            !node->get("mode", &rd.m_minor_mode) ||
+            !node->get("reverse", &rd.m_reverse) ||
+            !node->get("difficulty", &rd.m_difficulty) ||
+            !node->get("laps", &rd.m_laps) ||
+            !node->get("min-time", &rd.m_min_time) ||
+            !node->get("uid", &uid))
+        {
+            Log::warn("Replay", "Invalid entry in replay index '%s'.",
+                      filename.c_str());
+            continue;
+        }
+        rd.m_replay_uid = (uint64_t)uid;
+        for (unsigned int k = 0; k < node->getNumNodes(); k++)
+        {
+            const XMLNode* kart = node->getNode(k);
+            std::string ident;
+            core::stringw name;
+            float color = 0.0f;
+            kart->get("ident", &ident);
+            kart->get("name", &name);
+            kart->get("color", &color);
+            rd.m_kart_list.push_back(ident);
+            rd.m_name_list.push_back(name);
+            rd.m_kart_color.push_back(color);
+        }
+        m_replay_index[StringUtils::wideToUtf8(path)] =
+            std::make_pair((uint64_t)mtime, rd);
+    }
+    delete root;
+}   // loadReplayIndex
+
+//-----------------------------------------------------------------------------
+/** Writes the replay index if it was changed since it was read.
+ */
+void ReplayPlay::saveReplayIndex()
+{
+    if (!m_replay_index_changed) return;
+    m_replay_index_changed = false;
+
+    const std::string filename = getReplayIndexFilename();
+    try
+    {
+        UTFWriter index_file(filename.c_str(), false);
+        index_file << "<?xml version=\"1.0\"?>\n";
+        index_file << "<replay-index version=\"" << getCurrentReplayVersion()
+                   << "\">\n";
+        for (auto& entry : m_replay_index)
+        {
+            const ReplayData& rd = entry.second.second;
+            // Same precision as in the replay file
+            char min_time[32];
+            snprintf(min_time, 32, "%f", rd.m_min_time);
+            index_file << "    <replay path=\""
+                << StringUtils::xmlEncode(StringUtils::utf8ToWide(entry.first))
+                << "\" mtime=\"" << (int64_t)entry.second.first
+                << "\" version=\"" << rd.m_replay_version
+                << "\"\n            stk-version=\""
+                << StringUtils::xmlEncode(rd.m_stk_version)
+                << "\" user=\"" << StringUtils::xmlEncode(rd.m_user_name)
+                << "\" track=\""
+                << StringUtils::xmlEncode(
+                                 StringUtils::utf8ToWide(rd.m_track_name))
+                << "\" mode=\""
+                << StringUtils::xmlEncode(
+                                 StringUtils::utf8ToWide(rd.m_minor_mode))
+                << "\"\n            reverse=\"" << rd.m_reverse
+                << "\" difficulty=\"" << rd.m_difficulty
+                << "\" laps=\"" << rd.m_laps
+                << "\" min-time=\"" << min_time
+                << "\" uid=\"" << (int64_t)rd.m_replay_uid << "\">\n";
+            for (unsigned int k = 0; k < rd.m_kart_list.size(); k++)
+            {
+                index_file << "        <kart ident=\""
+                    << StringUtils::xmlEncode(
+                                 StringUtils::utf8ToWide(rd.m_kart_list[k]))
+                    << "\" name=\"" << StringUtils::xmlEncode(rd.m_name_list[k])
+                    << "\" color=\"" << rd.m_kart_color[k] << "\"/>\n";
+            }
+            index_file << "    </replay>\n";
+        }
+        for (auto& entry : m_invalid_replay_files)
+        {
+            index_file << "    <invalid path=\""
+                << StringUtils::xmlEncode(StringUtils::utf8ToWide(entry.first))
+                << "\" mtime=\"" << (int64_t)entry.second << "\"/>\n";
+        }
+        index_file << "</replay-index>\n";
+        index_file.close();
+    }
+    catch (std::exception& e)
+    {
+        Log::error("Replay", "Can't write replay index '%s': %s",
+                   filename.c_str(), e.what());
+    }
+}   // saveReplayIndex
+
+//-----------------------------------------------------------------------------
+bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int call_index)
+{
     if (StringUtils::getExtension(fn) != "replay") return false;
-    FILE *fd = fopen(custom_replay ? fn.c_str() :
-        (file_manager->getReplayDir() + fn).c_str(), "r");
-    if (fd == NULL) return false;
+    const std::string full_path = custom_replay ? fn
+                                : file_manager->getReplayDir() + fn;
+    const uint64_t mtime = file_manager->getFileModificationTime(full_path);
+    loadReplayIndex();
+
     ReplayData rd;
+    auto it = m_replay_index.find(full_path);
+    if (it != m_replay_index.end() && it->second.first == mtime)
+    {
+        // Unchanged since the header was read, the track might have been
+        // removed since then though
+        rd = it->second.second;
+        rd.m_track = track_manager->getTrack(rd.m_track_name);
+        if (rd.m_track == NULL)
+        {
+            Log::warn("Replay", "Track '%s' used in replay '%s' not found in STK!",
+            rd.m_track_name.c_str(), fn.c_str());
+            return false;
+        }
+        // No UID in old replay format
+        if (rd.m_replay_version < 4)
+            rd.m_replay_uid = call_index;
+    }
+    else
+    {
+        auto invalid = m_invalid_replay_files.find(full_path);
+        if (invalid != m_invalid_replay_files.end() &&
+            invalid->second == mtime)
+            return false;
+        FILE *fd = fopen(full_path.c_str(), "r");
+        if (fd == NULL) return false;
+        rd.m_track = NULL;
+        const bool success = readReplayHeader(fd, fn, call_index, rd);
+        fclose(fd);
+        if (!success)
+        {
+            // Don't read the file again until it changes, unless only its
+            // track is missing, which can be installed later
+            if (rd.m_track_name.empty() || rd.m_track != NULL)
+            {
+                m_invalid_replay_files[full_path] = mtime;
+                m_replay_index_changed = true;
+            }
+            return false;
+        }
+        if (invalid != m_invalid_replay_files.end())
+            m_invalid_replay_files.erase(invalid);
+        m_replay_index[full_path] = std::make_pair(mtime, rd);
+        m_replay_index_changed = true;
+    }
 
     // custom_replay is true when full path of filename is given
     rd.m_custom_replay_file = custom_replay;
     rd.m_filename = fn;
+    m_replay_file_list.push_back(rd);
+
+    assert(m_replay_file_list.size() > 0);
+    // Force to use custom replay file immediately
+    if (custom_replay)
+        m_current_replay_file = (unsigned int)m_replay_file_list.size() - 1;
+
+    return true;
+
+}   // addReplayFile
+
+//-----------------------------------------------------------------------------
+/** Reads the header of a replay file.
+ *  \param fd The file to read from.
+ *  \param fn The name of the replay file, used in messages.
+ *  \param call_index Used as UID of replay files without one.
+ *  \param rd Stores the data read.
+ *  \return False if the header is invalid or the track is not available.
+ */
+bool ReplayPlay::readReplayHeader(FILE *fd, const std::string& fn,
+                                  int call_index, ReplayData &rd)
+{
+    char s[1024], s1[1024];
 
     fgets(s, 1023, fd);
     unsigned int version;
@@ -122,7 +380,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     {
         Log::warn("Replay", "No Version information "
                   "found in replay file (bogus replay file).");
-        fclose(fd);
         return false;
     }
     if (version > getCurrentReplayVersion() ||
@@ -132,10 +389,9 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         Log::warn("Replay", "STK replay version is '%d'", getCurrentReplayVersion());
         Log::warn("Replay", "Minimum supported replay version is '%d'", getMinSupportedReplayVersion());
         Log::warn("Replay", "Skipped '%s'", fn.c_str());
-        fclose(fd);
         return false;
     }
-        rd.m_replay_version = version;
+    rd.m_replay_version = version;
 
     if (version >= 4)
     {
@@ -143,7 +399,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         if(sscanf(s, "stk_version: %s", s1) != 1)
         {
             Log::warn("Replay", "No STK release version found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
         rd.m_stk_version = s1;
@@ -192,7 +447,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
             if(sscanf(s, "kart_color: %f", &f) != 1)
             {
                 Log::warn("Replay", "Kart color missing in replay file, '%s'.", fn.c_str());
-                fclose(fd);
                 return false;
             }
             rd.m_kart_color.push_back(f);
@@ -206,7 +460,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if(sscanf(s, "reverse: %d", &reverse) != 1)
     {
         Log::warn("Replay", "No reverse info found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
     rd.m_reverse = reverse != 0;
@@ -215,7 +468,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if (sscanf(s, "difficulty: %u", &rd.m_difficulty) != 1)
     {
         Log::warn("Replay", " No difficulty found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
@@ -225,7 +477,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         if (sscanf(s, "mode: %s", s1) != 1)
         {
             Log::warn("Replay", "Replay mode not found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
         rd.m_minor_mode = s1;
@@ -239,7 +490,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if (sscanf(s, "track: %s", s1) != 1)
     {
         Log::warn("Replay", "Track info not found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
     rd.m_track_name = std::string(s1);
@@ -248,7 +498,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     {
         Log::warn("Replay", "Track '%s' used in replay '%s' not found in STK!",
         rd.m_track_name.c_str(), fn.c_str());
-        fclose(fd);
         return false;
     }
 
@@ -258,7 +507,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if (sscanf(s, "laps: %u", &rd.m_laps) != 1)
     {
         Log::warn("Replay", "No number of laps found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
@@ -266,7 +514,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     if (sscanf(s, "min_time: %f", &rd.m_min_time) != 1)
     {
         Log::warn("Replay", "Finish time not found in replay file, '%s'.", fn.c_str());
-        fclose(fd);
         return false;
     }
 
@@ -276,7 +523,6 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
         if (sscanf(s, "replay_uid: %" PRIu64, &rd.m_replay_uid) != 1)
         {
             Log::warn("Replay", "Replay UID not found in replay file, '%s'.", fn.c_str());
-            fclose(fd);
             return false;
         }
     }
@@ -284,17 +530,8 @@ bool ReplayPlay::addReplayFile(const std::string& fn, bool custom_replay, int ca
     else
         rd.m_replay_uid = call_index;
 
-    fclose(fd);
-    m_replay_file_list.push_back(rd);
-
-    assert(m_replay_file_list.size() > 0);
-    // Force to use custom replay file immediately
-    if (custom_replay)
-        m_current_replay_file = (unsigned int)m_replay_file_list.size() - 1;
-
     return true;
-
-}   // addReplayFile
+}   // readReplayHeader
 
 //-----------------------------------------------------------------------------
 void ReplayPlay::load()
@@ -340,6 +577,13 @@ void ReplayPlay::loadFile(bool second_replay)
     for (unsigned int i = 0; i < lines_to_skip; i++)
         fgets(s, 1023, fd);
 
+    if (rd.m_replay_version >= 5)
+    {
+        readBinaryKartData(fd, num_kart, second_replay);
+        fclose(fd);
+        return;
+    }
+
     // eof actually doesn't trigger here, since it requires first to try
     // reading behind eof, but still it's clearer this way.
     while(!feof(fd))
@@ -353,13 +597,12 @@ void ReplayPlay::loadFile(bool second_replay)
 }   // loadFile
 
 //-----------------------------------------------------------------------------
-/** Reads all data from a replay file for a specific kart.
- *  \param fd The file descriptor from which to read.
+/** Creates the next ghost kart of a replay file with its controller.
+ *  \param second_replay True if the kart belongs to the second replay.
+ *  \return The index of the new ghost kart.
  */
-void ReplayPlay::readKartData(FILE *fd, char *next_line, bool second_replay)
+unsigned int ReplayPlay::createGhostKart(bool second_replay)
 {
-    char s[1024];
-
     int replay_index = second_replay ? m_second_replay_file
                                      : m_current_replay_file;
 
@@ -378,6 +621,74 @@ void ReplayPlay::readKartData(FILE *fd, char *next_line, bool second_replay)
     Controller* controller = new GhostController(getGhostKart(kart_num).get(),
                                                  rd.m_name_list[kart_num-first_loaded_f_num]);
     getGhostKart(kart_num)->setController(controller);
+    return kart_num;
+}   // createGhostKart
+
+//-----------------------------------------------------------------------------
+/** Reads the events of all karts from the binary part of a replay file
+ *  (version 5 and later), which follows the header up to the end of the
+ *  file. The whole part is read at once and decoded from memory.
+ *  \param fd The file descriptor, positioned after the header.
+ *  \param num_kart Number of karts stored in the replay.
+ */
+void ReplayPlay::readBinaryKartData(FILE *fd, unsigned int num_kart,
+                                    bool second_replay)
+{
+    long start = ftell(fd);
+    fseek(fd, 0, SEEK_END);
+    long end = ftell(fd);
+    fseek(fd, start, SEEK_SET);
+    if (start < 0 || end < start)
+    {
+        Log::error("Replay", "Can't determine the size of replay file.");
+        return;
+    }
+
+    std::vector<char> data(end - start);
+    if (!data.empty() && fread(data.data(), 1, data.size(), fd) != data.size())
+    {
+        Log::error("Replay", "Can't read the events of replay file.");
+        return;
+    }
+
+    BareNetworkString buffer(data.data(), (int)data.size());
+    try
+    {
+        for (unsigned int k = 0; k < num_kart; k++)
+        {
+            const unsigned int kart_num = createGhostKart(second_replay);
+            const int32_t size = getVarInt(&buffer);
+            QuantizedEvent previous = {};
+            for (int32_t i = 0; i < size; i++)
+            {
+                TransformEvent te;
+                PhysicInfo pi       = {0};
+                BonusInfo bi        = {0};
+                KartReplayEvent kre = {0};
+                decodeEvent(&buffer, &te, &pi, &bi, &kre, &previous);
+                m_ghost_karts[kart_num]->addReplayEvent(te.m_time,
+                    te.m_transform, pi, bi, kre);
+            }   // for i
+        }   // for k
+    }
+    catch (std::exception& e)
+    {
+        Log::error("Replay", "Replay file is truncated: %s", e.what());
+    }
+}   // readBinaryKartData
+
+//-----------------------------------------------------------------------------
+/** Reads all data from a replay file for a specific kart.
+ *  \param fd The file descriptor from which to read.
+ */
+void ReplayPlay::readKartData(FILE *fd, char *next_line, bool second_replay)
+{
+    char s[1024];
+
+    int replay_index = second_replay ? m_second_replay_file
+                                     : m_current_replay_file;
+    ReplayData &rd = m_replay_file_list[replay_index];
+    const unsigned int kart_num = createGhostKart(second_replay);
 
     unsigned int size;
     if(sscanf(next_line,"size: %u",&size)!=1)
@@ -24,6 +24,7 @@
 
 #include "irrString.h"
 #include <algorithm>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
@@ -122,9 +123,31 @@ private:
     /** All ghost karts. */
     std::vector<std::shared_ptr<GhostKart> > m_ghost_karts;
 
+    /** The header of all replay files read, with the modification time of
+     *  the file, indexed by the full path of the file. */
+    std::map<std::string, std::pair<uint64_t, ReplayData> > m_replay_index;
+
+    /** The modification time of replay files which could not be read,
+     *  indexed by the full path of the file. They are not read again until
+     *  they are changed. */
+    std::map<std::string, uint64_t> m_invalid_replay_files;
+
+    bool                     m_replay_index_loaded;
+
+    /** True if the replay index needs to be written again. */
+    bool                     m_replay_index_changed;
+
           ReplayPlay();
          ~ReplayPlay();
+    unsigned int createGhostKart(bool second_replay);
+    bool  readReplayHeader(FILE *fd, const std::string& fn, int call_index,
+                           ReplayData &rd);
+    std::string getReplayIndexFilename() const;
+    void  loadReplayIndex();
+    void  saveReplayIndex();
     void  readKartData(FILE *fd, char *next_line, bool second_replay);
+    void  readBinaryKartData(FILE *fd, unsigned int num_kart,
+                             bool second_replay);
 public:
     void  reset();
     void  load();
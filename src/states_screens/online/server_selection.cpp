@@ -49,6 +49,8 @@ ServerSelection::ServerSelection() : Screen("online/server_selection.stkgui")
 {
     m_refreshing_server = false;
     m_refresh_timer = 0.0f;
+    m_received_servers = 0;
+    m_received_timer = 0.0f;
 }   // ServerSelection
 
 // ----------------------------------------------------------------------------
@@ -82,6 +84,8 @@ void ServerSelection::refresh(bool full_refresh)
         m_reload_widget->setActive(false);
         m_refreshing_server = true;
         m_refresh_timer = 0.0f;
+        m_received_servers = 0;
+        m_received_timer = 0.0f;
     }
 }   // refresh
 
@@ -314,7 +318,8 @@ void ServerSelection::onUpdate(float dt)
         sid->requestJoin();
     }
     
-    if (ServersManager::get()->getServers().empty() && !m_refreshing_server &&
+    if (ServersManager::get()->getNumReceivedServers() == 0 &&
+        !m_refreshing_server &&
         !NetworkConfig::get()->isWAN())
     {
         m_refresh_timer += dt;
@@ -351,9 +356,22 @@ void ServerSelection::onUpdate(float dt)
     }
     else
     {
-        m_server_list_widget->clear();
-        m_server_list_widget->addItem("loading",
-            StringUtils::loadingDots(_("Fetching servers")));
+        // Show the servers already received while the rest of the list is
+        // parsed, but not every frame since the whole list is sorted again
+        m_received_timer += dt;
+        unsigned received = ServersManager::get()->getNumReceivedServers();
+        if (received != m_received_servers && m_received_timer > 0.5f)
+        {
+            m_received_timer = 0.0f;
+            m_received_servers = received;
+            copyFromServersManager();
+        }
+        if (m_received_servers == 0)
+        {
+            m_server_list_widget->clear();
+            m_server_list_widget->addItem("loading",
+                StringUtils::loadingDots(_("Fetching servers")));
+        }
     }
 
 }   // onUpdate
@@ -361,7 +379,7 @@ void ServerSelection::onUpdate(float dt)
 // ----------------------------------------------------------------------------
 void ServerSelection::copyFromServersManager()
 {
-    m_servers = ServersManager::get()->getServers();
+    m_servers = ServersManager::get()->getReceivedServers();
     if (m_servers.empty())
         return;
     m_servers.erase(std::remove_if(m_servers.begin(), m_servers.end(),
@@ -77,6 +77,14 @@ private:
     
     float m_refresh_timer;
 
+    /** Number of servers received so far which are shown in the list while
+     *  the server list is still being refreshed. */
+    unsigned m_received_servers;
+
+    /** Time since the list was last updated with the servers received so
+     *  far during a refresh. */
+    float m_received_timer;
+
     /** Load the servers into the main list.*/
     void loadList();
 
@@ -21,6 +21,7 @@
 #include "config/user_config.hpp"
 #include "io/file_manager.hpp"
 #include "io/xml_node.hpp"
+#include "network/server_config.hpp"
 #include "race/race_manager.hpp"
 #include "tracks/arena_node.hpp"
 #include "tracks/track.hpp"
@@ -28,7 +29,25 @@
 #include "utils/log.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <queue>
+#include <thread>
+
+namespace
+{
+    /** Version of the shortest paths cache files, increase it if the format
+     *  or the computation of the shortest paths changes. */
+    const uint32_t SHORTEST_PATHS_CACHE_VERSION = 1;
+    /** Maximum number of threads used to compute the shortest paths, more
+     *  only compete with the other threads of the game or server instances
+     *  for little gain on the small arena graphs. */
+    const unsigned int MAX_SHORTEST_PATHS_THREADS = 4;
+    /** Minimum number of source nodes computed per thread, since starting a
+     *  thread costs more than computing a few nodes. */
+    const unsigned int MIN_NODES_PER_THREAD = 64;
+}   // namespace
 
 // -----------------------------------------------------------------------------
 ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node)
@@ -36,9 +55,18 @@ ArenaGraph::ArenaGraph(const std::string &navmesh, const XMLNode *node)
 {
     loadNavmesh(navmesh);
     buildGraph();
-    // Compute shortest distance from all nodes
-    for (unsigned int i = 0; i < getNumNodes(); i++)
-        computeDijkstra(i);
+    createNodeTree();
+    // Compute shortest distance from all nodes, unless they were computed
+    // for this navmesh before
+    const std::string cache_file = getShortestPathsCacheFile(navmesh);
+    if (cache_file.empty() || !loadShortestPaths(cache_file))
+    {
+        // A partially read file might have overwritten the graph
+        buildGraph();
+        computeAllShortestPaths();
+        if (!cache_file.empty())
+            saveShortestPaths(cache_file);
+    }
 
     setNearbyNodesOfAllNodes();
     if (node && race_manager->getMinorMode() == RaceManager::MINOR_MODE_SOCCER)
@@ -179,8 +207,7 @@ void ArenaGraph::buildGraph()
 {
     const unsigned int n_nodes = getNumNodes();
 
-    m_distance_matrix = std::vector<std::vector<float>>
-        (n_nodes, std::vector<float>(n_nodes, 9999.9f));
+    m_distance_matrix.assign(n_nodes * n_nodes, 9999.9f);
     for (unsigned int i = 0; i < n_nodes; i++)
     {
         ArenaNode* cur_node = getNode(i);
@@ -188,22 +215,21 @@ void ArenaGraph::buildGraph()
         {
             Vec3 diff = getNode(adjacent)->getCenter() - cur_node->getCenter();
             float distance = diff.length();
-            m_distance_matrix[i][adjacent] = distance;
+            m_distance_matrix[i * n_nodes + adjacent] = distance;
         }
-        m_distance_matrix[i][i] = 0.0f;
+        m_distance_matrix[i * n_nodes + i] = 0.0f;
     }
 
     // Allocate and initialise the previous node data structure:
-    m_parent_node = std::vector<std::vector<int16_t>>
-        (n_nodes, std::vector<int16_t>(n_nodes, Graph::UNKNOWN_SECTOR));
+    m_parent_node.assign(n_nodes * n_nodes, Graph::UNKNOWN_SECTOR);
     for (unsigned int i = 0; i < n_nodes; i++)
     {
         for (unsigned int j = 0; j < n_nodes; j++)
         {
-            if (i == j || m_distance_matrix[i][j] >= 9899.9f)
-                m_parent_node[i][j] = -1;
+            if (i == j || m_distance_matrix[i * n_nodes + j] >= 9899.9f)
+                m_parent_node[i * n_nodes + j] = -1;
             else
-                m_parent_node[i][j] = i;
+                m_parent_node[i * n_nodes + j] = i;
         }   // for j
     }   // for i
 
@@ -216,8 +242,13 @@ void ArenaGraph::buildGraph()
  *  source to j and m_parent_node[source][j] stores the last vertex visited on
  *  the shortest path from i to j before visiting j. Suppose the shortest path
  *  from i to j is i->......->k->j  then m_parent_node[i][j] = k
+ *  Only the row of 'source' is modified, so this can be called for different
+ *  nodes at the same time.
+ *  \param source The node to compute the shortest paths from.
+ *  \param edges For each node the adjacent nodes and their distance.
  */
-void ArenaGraph::computeDijkstra(int source)
+void ArenaGraph::computeDijkstra(int source,
+             const std::vector<std::vector<std::pair<int, float> > > &edges)
 {
     // Stores the distance (float) to 'source' from a specified node (int)
     typedef std::pair<int, float> IndDistPair;
@@ -235,6 +266,8 @@ void ArenaGraph::computeDijkstra(int source)
     IndDistPair begin(source, 0.0f);
     queue.push(begin);
     const unsigned int n = getNumNodes();
+    float *distance = &m_distance_matrix[source * n];
+    int16_t *parent_node = &m_parent_node[source * n];
     std::vector<bool> visited;
     visited.resize(n, false);
     while (!queue.empty())
@@ -246,17 +279,17 @@ void ArenaGraph::computeDijkstra(int source)
         if (visited[cur_index]) continue;
         visited[cur_index] = true;
 
-        for (const int& adjacent : getNode(cur_index)->getAdjacentNodes())
+        for (const std::pair<int, float> &edge : edges[cur_index])
         {
+            const int adjacent = edge.first;
             // Distance already computed, can be ignored
             if (visited[adjacent]) continue;
 
-            float new_dist =
-                current.second + m_distance_matrix[cur_index][adjacent];
-            if (new_dist < m_distance_matrix[source][adjacent])
+            float new_dist = current.second + edge.second;
+            if (new_dist < distance[adjacent])
             {
-                m_distance_matrix[source][adjacent] = new_dist;
-                m_parent_node[source][adjacent] = cur_index;
+                distance[adjacent] = new_dist;
+                parent_node[adjacent] = cur_index;
             }
             IndDistPair pair(adjacent, new_dist);
             queue.push(pair);
@@ -264,6 +297,154 @@ void ArenaGraph::computeDijkstra(int source)
     }
 }   // computeDijkstra
 
+// ----------------------------------------------------------------------------
+/** Computes the shortest paths from all nodes, using a few threads for
+ *  larger graphs. The result does not depend on the number of threads, since each node is
+ *  computed independently.
+ */
+void ArenaGraph::computeAllShortestPaths()
+{
+    const unsigned int n = getNumNodes();
+    // Copy the distances between adjacent nodes, since the distance matrix
+    // is changed while computing
+    std::vector<std::vector<std::pair<int, float> > > edges(n);
+    for (unsigned int i = 0; i < n; i++)
+    {
+        for (const int& adjacent : getNode(i)->getAdjacentNodes())
+            edges[i].emplace_back(adjacent, m_distance_matrix[i * n + adjacent]);
+    }
+
+    std::atomic<unsigned int> next_source(0);
+    auto compute = [this, &edges, &next_source, n]()
+    {
+        for (unsigned int i = next_source++; i < n; i = next_source++)
+            computeDijkstra(i, edges);
+    };
+
+    unsigned int num_threads = std::thread::hardware_concurrency();
+    num_threads = std::min(num_threads, MAX_SHORTEST_PATHS_THREADS);
+    num_threads = std::min(num_threads, n / MIN_NODES_PER_THREAD);
+    num_threads = std::max(1u, num_threads);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < num_threads; i++)
+        threads.emplace_back(compute);
+    compute();
+    for (std::thread &t : threads)
+        t.join();
+}   // computeAllShortestPaths
+
+// ----------------------------------------------------------------------------
+/** Returns the name of the file to cache the shortest paths of the navmesh
+ *  in, which contains a hash of the navmesh file. So any change to the
+ *  navmesh uses a new cache file. Returns "" if the navmesh can't be read.
+ *  \param navmesh Full path of the navmesh file.
+ */
+std::string ArenaGraph::getShortestPathsCacheFile(const std::string &navmesh)
+                                                                         const
+{
+    FILE *fd = fopen(navmesh.c_str(), "rb");
+    if (!fd)
+        return "";
+
+    // 64-bit FNV-1a hash of the navmesh file
+    uint64_t hash = 14695981039346656037ULL;
+    uint8_t buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), fd)) > 0)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= buffer[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    fclose(fd);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return file_manager->getCachedNavmeshDir() + name;
+}   // getShortestPathsCacheFile
+
+// ----------------------------------------------------------------------------
+/** Loads the shortest paths from the cache file if it exists and matches
+ *  this graph. The file contains a header (magic "STKP", UInt32 version,
+ *  UInt32 number of nodes), followed by the distance matrix and the parent
+ *  node matrix as stored in memory.
+ *  \param filename Name of the cache file.
+ *  \return True if the shortest paths were loaded.
+ */
+bool ArenaGraph::loadShortestPaths(const std::string &filename)
+{
+    FILE *fd = fopen(filename.c_str(), "rb");
+    if (!fd)
+        return false;
+
+    const uint32_t n = getNumNodes();
+    char magic[4];
+    uint32_t version = 0, num_nodes = 0;
+    bool ok =
+        fread(magic, 1, 4, fd) == 4 && memcmp(magic, "STKP", 4) == 0 &&
+        fread(&version, sizeof(version), 1, fd) == 1 &&
+        version == SHORTEST_PATHS_CACHE_VERSION &&
+        fread(&num_nodes, sizeof(num_nodes), 1, fd) == 1 && num_nodes == n &&
+        fread(m_distance_matrix.data(), sizeof(float), n * n, fd) == n * n &&
+        fread(m_parent_node.data(), sizeof(int16_t), n * n, fd) == n * n;
+    fclose(fd);
+    if (!ok)
+        return false;
+
+    // A corrupted file must not lead to out of bounds node indices
+    for (unsigned int i = 0; i < n * n; i++)
+    {
+        if (m_parent_node[i] < -1 || m_parent_node[i] >= (int)n ||
+            !(m_distance_matrix[i] >= 0.0f))
+        {
+            Log::warn("ArenaGraph", "Invalid shortest paths cache '%s'.",
+                      filename.c_str());
+            return false;
+        }
+    }
+    Log::info("ArenaGraph", "Loaded shortest paths from '%s'.",
+              filename.c_str());
+    return true;
+}   // loadShortestPaths
+
+// ----------------------------------------------------------------------------
+/** Saves the shortest paths to the cache file, see loadShortestPaths for the
+ *  format. The file is written under a temporary name first, so that
+ *  another process never reads an incomplete file.
+ *  \param filename Name of the cache file.
+ */
+void ArenaGraph::saveShortestPaths(const std::string &filename) const
+{
+    // Server instances can load the same arena at the same time
+    const std::string tmp_filename =
+        ServerConfig::getInstanceFileName(filename + ".tmp");
+    FILE *fd = fopen(tmp_filename.c_str(), "wb");
+    if (!fd)
+    {
+        Log::warn("ArenaGraph", "Can't open '%s' to cache shortest paths.",
+                  tmp_filename.c_str());
+        return;
+    }
+
+    const uint32_t n = getNumNodes();
+    const uint32_t version = SHORTEST_PATHS_CACHE_VERSION;
+    bool ok =
+        fwrite("STKP", 1, 4, fd) == 4 &&
+        fwrite(&version, sizeof(version), 1, fd) == 1 &&
+        fwrite(&n, sizeof(n), 1, fd) == 1 &&
+        fwrite(m_distance_matrix.data(), sizeof(float), n * n, fd) == n * n &&
+        fwrite(m_parent_node.data(), sizeof(int16_t), n * n, fd) == n * n;
+    ok = fclose(fd) == 0 && ok;
+    if (!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+        Log::warn("ArenaGraph", "Can't write shortest paths to '%s'.",
+                  filename.c_str());
+        remove(tmp_filename.c_str());
+    }
+}   // saveShortestPaths
+
 // ----------------------------------------------------------------------------
 /** THIS FUNCTION IS ONLY USED FOR UNIT-TESTING, to verify that the new
  *  Dijkstra algorithm gives the same results.
@@ -284,12 +465,12 @@ void ArenaGraph::computeFloydWarshall()
         {
             for (unsigned int j = 0; j < n; j++)
             {
-                if ((m_distance_matrix[i][k] + m_distance_matrix[k][j]) <
-                    m_distance_matrix[i][j])
+                if ((m_distance_matrix[i*n + k] + m_distance_matrix[k*n + j]) <
+                    m_distance_matrix[i*n + j])
                 {
-                    m_distance_matrix[i][j] =
-                        m_distance_matrix[i][k] + m_distance_matrix[k][j];
-                    m_parent_node[i][j] = m_parent_node[k][j];
+                    m_distance_matrix[i*n + j] =
+                        m_distance_matrix[i*n + k] + m_distance_matrix[k*n + j];
+                    m_parent_node[i*n + j] = m_parent_node[k*n + j];
                 }
             }
         }
@@ -341,7 +522,9 @@ void ArenaGraph::setNearbyNodesOfAllNodes()
         // Get the distance to all nodes at i
         ArenaNode* cur_node = getNode(i);
         std::vector<int> nearby_nodes;
-        std::vector<float> dist = m_distance_matrix[i];
+        std::vector<float>::const_iterator row =
+            m_distance_matrix.begin() + i * getNumNodes();
+        std::vector<float> dist(row, row + getNumNodes());
 
         // Skip the same node
         dist[i] = 999999.0f;
@@ -363,13 +546,14 @@ void ArenaGraph::setNearbyNodesOfAllNodes()
  *  std::vector (in reverse order). Used only for unit testing.
  */
 std::vector<int16_t> ArenaGraph::getPathFromTo(int from, int to,
-                      const std::vector< std::vector< int16_t > >& parent_node)
+                                  const std::vector<int16_t>& parent_node,
+                                  unsigned int num_nodes)
 {
     std::vector<int16_t> path;
     path.push_back(to);
     while(from!=to)
     {
-        to = parent_node[from][to];
+        to = parent_node[from * num_nodes + to];
         path.push_back(to);
     }
     return path;
@@ -393,8 +577,9 @@ void ArenaGraph::unitTesting()
     Log::error("Time", "Dijkstra       %lf", e-s);
 
     // Save the Dijkstra results
-    std::vector< std::vector< float > > distance_matrix = ag->m_distance_matrix;
-    std::vector< std::vector< int16_t > > parent_node = ag->m_parent_node;
+    std::vector< float > distance_matrix = ag->m_distance_matrix;
+    std::vector< int16_t > parent_node = ag->m_parent_node;
+    const unsigned int n = ag->getNumNodes();
     ag->buildGraph();
 
     // Now compute results with Floyd-Warshall
@@ -404,15 +589,15 @@ void ArenaGraph::unitTesting()
     Log::error("Time", "Floyd-Warshall %lf", e-s);
 
     int error_count = 0;
-    for(unsigned int i=0; i<ag->m_distance_matrix.size(); i++)
+    for(unsigned int i=0; i<n; i++)
     {
-        for(unsigned int j=0; j<ag->m_distance_matrix[i].size(); j++)
+        for(unsigned int j=0; j<n; j++)
         {
-            if(ag->m_distance_matrix[i][j] - distance_matrix[i][j] > 0.001f)
+            if(ag->m_distance_matrix[i*n+j] - distance_matrix[i*n+j] > 0.001f)
             {
                 Log::error("ArenaGraph",
                            "Incorrect distance %d, %d: Dijkstra: %f F.W.: %f",
-                           i, j, distance_matrix[i][j], ag->m_distance_matrix[i][j]);
+                           i, j, distance_matrix[i*n+j], ag->m_distance_matrix[i*n+j]);
                 error_count++;
             }    // if distance is too different
 
@@ -424,16 +609,16 @@ void ArenaGraph::unitTesting()
             // debugging in the feature
 #undef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
 #ifdef TEST_PARENT_POLY_EVEN_THOUGH_MANY_FALSE_POSITIVES
-            if(ag->m_parent_node[i][j] != parent_node[i][j])
+            if(ag->m_parent_node[i*n+j] != parent_node[i*n+j])
             {
                 error_count++;
-                std::vector<int16_t> dijkstra_path = getPathFromTo(i, j, parent_node);
-                std::vector<int16_t> floyd_path = getPathFromTo(i, j, ag->m_parent_node);
+                std::vector<int16_t> dijkstra_path = getPathFromTo(i, j, parent_node, n);
+                std::vector<int16_t> floyd_path = getPathFromTo(i, j, ag->m_parent_node, n);
                 if(dijkstra_path.size()!=floyd_path.size())
                 {
                     Log::error("ArenaGraph",
                                "Incorrect path length %d, %d: Dijkstra: %d F.W.: %d",
-                               i, j, parent_node[i][j], ag->m_parent_node[i][j]);
+                               i, j, parent_node[i*n+j], ag->m_parent_node[i*n+j]);
                     continue;
                 }
                 Log::error("ArenaGraph", "Path problems from %d to %d:",
@@ -22,7 +22,9 @@
 #include "tracks/graph.hpp"
 #include "utils/cpp2011.hpp"
 
+#include <cstdint>
 #include <set>
+#include <utility>
 
 class ArenaNode;
 class XMLNode;
@@ -34,11 +36,15 @@ class XMLNode;
 class ArenaGraph : public Graph
 {
 private:
-    /** The actual graph data structure, it is an adjacency matrix. */
-    std::vector<std::vector<float>> m_distance_matrix;
+    /** The actual graph data structure, it is an adjacency matrix stored in
+     *  one contiguous array: m_distance_matrix[i * getNumNodes() + j] is the
+     *  distance from node i to j. After computing the shortest paths it
+     *  contains the shortest path distance between any two nodes. */
+    std::vector<float> m_distance_matrix;
 
-    /** The matrix that is used to store computed shortest paths. */
-    std::vector<std::vector<int16_t>> m_parent_node;
+    /** The matrix that is used to store computed shortest paths, stored in
+     *  the same way as m_distance_matrix. */
+    std::vector<int16_t> m_parent_node;
 
     /** Used in soccer mode to colorize the goal lines in minimap. */
     std::set<int> m_red_node;
@@ -54,12 +60,22 @@ private:
     // ------------------------------------------------------------------------
     void setNearbyNodesOfAllNodes();
     // ------------------------------------------------------------------------
-    void computeDijkstra(int n);
+    void computeDijkstra(int source,
+           const std::vector<std::vector<std::pair<int, float> > > &edges);
+    // ------------------------------------------------------------------------
+    void computeAllShortestPaths();
     // ------------------------------------------------------------------------
     void computeFloydWarshall();
     // ------------------------------------------------------------------------
+    std::string getShortestPathsCacheFile(const std::string &navmesh) const;
+    // ------------------------------------------------------------------------
+    bool loadShortestPaths(const std::string &filename);
+    // ------------------------------------------------------------------------
+    void saveShortestPaths(const std::string &filename) const;
+    // ------------------------------------------------------------------------
     static std::vector<int16_t> getPathFromTo(int from, int to,
-                     const std::vector< std::vector< int16_t > >& parent_node);
+                                  const std::vector<int16_t>& parent_node,
+                                  unsigned int num_nodes);
     // ------------------------------------------------------------------------
     virtual bool hasLapLine() const OVERRIDE                  { return false; }
     // ------------------------------------------------------------------------
@@ -84,7 +100,7 @@ public:
     {
         if (i == Graph::UNKNOWN_SECTOR || j == Graph::UNKNOWN_SECTOR)
             return Graph::UNKNOWN_SECTOR;
-        return (int)(m_parent_node[j][i]);
+        return (int)(m_parent_node[j * getNumNodes() + i]);
     }
     // ------------------------------------------------------------------------
     /** Returns the distance between any two nodes */
@@ -92,7 +108,7 @@ public:
     {
         if (from == Graph::UNKNOWN_SECTOR || to == Graph::UNKNOWN_SECTOR)
             return 99999.0f;
-        return m_distance_matrix[from][to];
+        return m_distance_matrix[from * getNumNodes() + to];
     }
 
 };   // ArenaGraph
@@ -244,6 +244,7 @@ void DriveGraph::load(const std::string &quad_file_name,
     }
     delete xml;
 
+    createNodeTree();
     setDefaultSuccessors();
     computeDistanceFromStart(getStartNode(), 0.0f);
     computeDirectionData();
@@ -33,6 +33,9 @@
 #include "tracks/track.hpp"
 #include "utils/log.hpp"
 
+#include <algorithm>
+#include <limits>
+
 const int Graph::UNKNOWN_SECTOR = -1;
 const float Graph::MIN_HEIGHT_TESTING = -1.0f;
 const float Graph::MAX_HEIGHT_TESTING = 5.0f;
@@ -591,6 +594,245 @@ void Graph::createQuad(const Vec3 &p0, const Vec3 &p1, const Vec3 &p2,
 
 }   // createQuad
 
+//-----------------------------------------------------------------------------
+/** Creates the bounding volume hierarchy of all quads used to find the quad
+ *  at or closest to a point. Must be called after all quads are created.
+ */
+void Graph::createNodeTree()
+{
+    m_node_tree.clear();
+    m_tree_quads.clear();
+    if (m_all_nodes.empty())
+        return;
+
+    std::vector<NodeTreeNode> quad_bounds(m_all_nodes.size());
+    for (unsigned int i = 0; i < m_all_nodes.size(); i++)
+    {
+        const Quad *q = m_all_nodes[i];
+        NodeTreeNode &b = quad_bounds[i];
+        b.m_min_x = b.m_min_z =  std::numeric_limits<float>::max();
+        b.m_max_x = b.m_max_z = -std::numeric_limits<float>::max();
+        // Include the box used in pointInside of 3d quads, which extends
+        // along the normal of the quad
+        const Vec3 offset = q->getNormal() * 5.0f;
+        for (int j = 0; j < 4; j++)
+        {
+            for (int k = -1; k <= 1; k++)
+            {
+                const Vec3 p = (*q)[j] + offset * (float)k;
+                b.m_min_x = std::min(b.m_min_x, p.getX());
+                b.m_min_z = std::min(b.m_min_z, p.getZ());
+                b.m_max_x = std::max(b.m_max_x, p.getX());
+                b.m_max_z = std::max(b.m_max_z, p.getZ());
+            }
+        }
+        // Allow for rounding errors in the tests of the quads
+        b.m_min_x -= 0.01f; b.m_min_z -= 0.01f;
+        b.m_max_x += 0.01f; b.m_max_z += 0.01f;
+        m_tree_quads.push_back(i);
+    }
+    buildNodeTree(quad_bounds, 0, (int)m_tree_quads.size());
+}   // createNodeTree
+
+//-----------------------------------------------------------------------------
+/** Adds a node for the given quads to m_node_tree, and recursively splits
+ *  the quads along the longer side of the node.
+ *  \param quad_bounds The bounding box of each quad.
+ *  \param first Index of the first quad in m_tree_quads.
+ *  \param count Number of quads.
+ *  \return Index of the new node.
+ */
+int Graph::buildNodeTree(const std::vector<NodeTreeNode> &quad_bounds,
+                         int first, int count)
+{
+    NodeTreeNode node = quad_bounds[m_tree_quads[first]];
+    for (int i = first + 1; i < first + count; i++)
+    {
+        const NodeTreeNode &b = quad_bounds[m_tree_quads[i]];
+        node.m_min_x = std::min(node.m_min_x, b.m_min_x);
+        node.m_min_z = std::min(node.m_min_z, b.m_min_z);
+        node.m_max_x = std::max(node.m_max_x, b.m_max_x);
+        node.m_max_z = std::max(node.m_max_z, b.m_max_z);
+    }
+    const int index = (int)m_node_tree.size();
+    m_node_tree.push_back(node);
+    if (count <= 4)
+    {
+        m_node_tree[index].m_first_quad = first;
+        m_node_tree[index].m_num_quads  = count;
+        m_node_tree[index].m_right      = -1;
+        return index;
+    }
+
+    // Split at the median of the quad centers
+    const bool split_x =
+        node.m_max_x - node.m_min_x > node.m_max_z - node.m_min_z;
+    std::vector<int>::iterator begin = m_tree_quads.begin() + first;
+    std::nth_element(begin, begin + count / 2, begin + count,
+        [&quad_bounds, split_x](int a, int b)
+        {
+            const NodeTreeNode &qa = quad_bounds[a];
+            const NodeTreeNode &qb = quad_bounds[b];
+            const float ca = split_x ? qa.m_min_x + qa.m_max_x
+                                     : qa.m_min_z + qa.m_max_z;
+            const float cb = split_x ? qb.m_min_x + qb.m_max_x
+                                     : qb.m_min_z + qb.m_max_z;
+            return ca < cb || (ca == cb && a < b);
+        });
+    m_node_tree[index].m_first_quad = -1;
+    m_node_tree[index].m_num_quads  = 0;
+    buildNodeTree(quad_bounds, first, count / 2);
+    const int right = buildNodeTree(quad_bounds, first + count / 2,
+                                    count - count / 2);
+    m_node_tree[index].m_right = right;
+    return index;
+}   // buildNodeTree
+
+//-----------------------------------------------------------------------------
+/** Returns the square of the distance in the x/z plane between a point and
+ *  the bounding box of a node of the node tree. */
+static float getDistance2ToBox(float min_x, float min_z, float max_x,
+                               float max_z, const Vec3 &xyz)
+{
+    const float dx = std::max(std::max(min_x - xyz.getX(), 0.0f),
+                              xyz.getX() - max_x);
+    const float dz = std::max(std::max(min_z - xyz.getZ(), 0.0f),
+                              xyz.getZ() - max_z);
+    return dx * dx + dz * dz;
+}   // getDistance2ToBox
+
+//-----------------------------------------------------------------------------
+/** Finds the quad containing the point using the node tree. If more than
+ *  one quad contains the point, the first one when testing all quads in
+ *  order starting at first_sector is returned, same as a linear search.
+ *  \param xyz The point to test.
+ *  \param first_sector The quad a linear search would test first.
+ *  \param ignore_vertical Passed to Quad::pointInside.
+ *  \return The index of the quad, or UNKNOWN_SECTOR.
+ */
+int Graph::findQuadInTree(const Vec3 &xyz, int first_sector,
+                          bool ignore_vertical) const
+{
+    const int num_nodes = (int)m_all_nodes.size();
+    int sector = UNKNOWN_SECTOR;
+    int sector_rank = num_nodes;
+
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const int index = stack[--stack_size];
+        const NodeTreeNode &node = m_node_tree[index];
+        if (xyz.getX() < node.m_min_x || xyz.getX() > node.m_max_x ||
+            xyz.getZ() < node.m_min_z || xyz.getZ() > node.m_max_z)
+            continue;
+        if (node.m_num_quads == 0)
+        {
+            assert(stack_size + 2 <= 64);
+            stack[stack_size++] = node.m_right;
+            stack[stack_size++] = index + 1;
+            continue;
+        }
+        for (int i = node.m_first_quad;
+             i < node.m_first_quad + node.m_num_quads; i++)
+        {
+            const int indx = m_tree_quads[i];
+            int rank = indx - first_sector;
+            if (rank < 0) rank += num_nodes;
+            if (rank < sector_rank &&
+                m_all_nodes[indx]->pointInside(xyz, ignore_vertical))
+            {
+                sector      = indx;
+                sector_rank = rank;
+            }
+        }
+    }   // while stack_size > 0
+    return sector;
+}   // findQuadInTree
+
+//-----------------------------------------------------------------------------
+/** Finds the quad with the closest center line to the point using the node
+ *  tree, as findOutOfRoadSector does. Of quads with the same distance the
+ *  first one when testing all quads in order starting at first_sector is
+ *  returned, same as a linear search.
+ *  \param xyz The point to test.
+ *  \param first_sector The quad a linear search would test first.
+ *  \param test_height Only accept quads which are not too far away
+ *         vertically.
+ *  \param ignore_vertical Accept any quad even if test_height is set.
+ *  \return The index of the quad, or UNKNOWN_SECTOR.
+ */
+int Graph::findClosestQuadInTree(const Vec3 &xyz, int first_sector,
+                                 bool test_height, bool ignore_vertical) const
+{
+    const int num_nodes = (int)m_all_nodes.size();
+    int   min_sector = UNKNOWN_SECTOR;
+    int   min_rank   = num_nodes;
+    float min_dist_2 = 999999.0f*999999.0f;
+
+    int stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+    while (stack_size > 0)
+    {
+        const int index = stack[--stack_size];
+        const NodeTreeNode &node = m_node_tree[index];
+        // The distance to the bounding box is a lower bound of the
+        // distance to all center lines in it
+        if (getDistance2ToBox(node.m_min_x, node.m_min_z, node.m_max_x,
+                              node.m_max_z, xyz) > min_dist_2)
+            continue;
+        if (node.m_num_quads == 0)
+        {
+            // Test the closer child first, so that more nodes are skipped
+            const NodeTreeNode &left  = m_node_tree[index + 1];
+            const NodeTreeNode &right = m_node_tree[node.m_right];
+            const float left_2  = getDistance2ToBox(left.m_min_x,
+                left.m_min_z, left.m_max_x, left.m_max_z, xyz);
+            const float right_2 = getDistance2ToBox(right.m_min_x,
+                right.m_min_z, right.m_max_x, right.m_max_z, xyz);
+            assert(stack_size + 2 <= 64);
+            if (left_2 < right_2)
+            {
+                stack[stack_size++] = node.m_right;
+                stack[stack_size++] = index + 1;
+            }
+            else
+            {
+                stack[stack_size++] = index + 1;
+                stack[stack_size++] = node.m_right;
+            }
+            continue;
+        }
+        for (int i = node.m_first_quad;
+             i < node.m_first_quad + node.m_num_quads; i++)
+        {
+            const int indx = m_tree_quads[i];
+            const Quad *q = m_all_nodes[indx];
+            if (q->isIgnored())
+                continue;
+            int rank = indx - first_sector;
+            if (rank < 0) rank += num_nodes;
+            const float dist_2 = q->getDistance2FromPoint(xyz);
+            if (dist_2 < min_dist_2 ||
+                (dist_2 == min_dist_2 && min_sector != UNKNOWN_SECTOR &&
+                 rank < min_rank))
+            {
+                const float dist = xyz.getY() - q->getMinHeight();
+                if (!test_height || (dist < 5.0f && dist > -1.0f) ||
+                    q->is3DQuad() || ignore_vertical)
+                {
+                    min_dist_2 = dist_2;
+                    min_sector = indx;
+                    min_rank   = rank;
+                }
+            }
+        }
+    }   // while stack_size > 0
+    return min_sector;
+}   // findClosestQuadInTree
+
 //-----------------------------------------------------------------------------
 /** findRoadSector returns in which sector on the road the position
  *  xyz is. If xyz is not on top of the road, it sets UNKNOWN_SECTOR as sector.
@@ -632,6 +874,16 @@ void Graph::findRoadSector(const Vec3& xyz, int *sector,
                             ? (unsigned int)all_sectors->size()
                             : (unsigned int)m_all_nodes.size();
     *sector = UNKNOWN_SECTOR;
+
+    // Without a list of sectors use the node tree, which gives the same
+    // result as testing all quads starting after the current one.
+    if (!all_sectors && !m_node_tree.empty())
+    {
+        int first = indx < (int)m_all_nodes.size() - 1 ? indx + 1 : 0;
+        *sector = findQuadInTree(xyz, first, ignore_vertical);
+        return;
+    }
+
     for(unsigned int i=0; i<max_count; i++)
     {
         if(all_sectors)
@@ -693,10 +945,8 @@ int Graph::findOutOfRoadSector(const Vec3& xyz, const int curr_sector,
         // shortcut. If we only tested a limited number of quads to
         // improve the performance the crossing of a lap might not be
         // detected (because quad 0 is not tested, only quads on the
-        // shortcuts are tested). If this should become a performance
-        // bottleneck, we need to set up a graph of 'next' quads for each
-        // quad (similar to what the AI does), and only test the quads
-        // in this graph.
+        // shortcuts are tested). The node tree below is used to only
+        // test the quads close to xyz, which gives the same result.
         const int LIMIT = getNumNodes();
         count           = LIMIT;
         // Start 10 quads before the current quad, so the quads closest
@@ -705,6 +955,22 @@ int Graph::findOutOfRoadSector(const Vec3& xyz, const int curr_sector,
         if(current_sector<0) current_sector += getNumNodes();
     }
 
+    // Without a list of sectors use the node tree, which gives the same
+    // result as testing all quads starting after current_sector.
+    if (!all_sectors && !m_node_tree.empty())
+    {
+        const int first = (current_sector + 1) % (int)getNumNodes();
+        for (int phase = 0; phase < 2; phase++)
+        {
+            int sector = findClosestQuadInTree(xyz, first, phase == 0,
+                                               ignore_vertical);
+            if (sector != UNKNOWN_SECTOR)
+                return sector;
+        }
+        Log::info("Graph", "unknown sector found.");
+        return UNKNOWN_SECTOR;
+    }
+
     int   min_sector = UNKNOWN_SECTOR;
     float min_dist_2 = 999999.0f*999999.0f;
 
@@ -66,6 +66,8 @@ protected:
     // ------------------------------------------------------------------------
     /** Map 4 bounding box points to 4 closest graph nodes. */
     void loadBoundingBoxNodes();
+    // ------------------------------------------------------------------------
+    void createNodeTree();
 
 private:
     /** The 2d bounding box, used for hashing. */
@@ -75,6 +77,28 @@ private:
     /** The 4 closest graph nodes to the bounding box. */
     int m_bb_nodes[4];
 
+    /** A node of m_node_tree with its bounding box in the x/z plane. The
+     *  first child of an inner node directly follows it in m_node_tree. */
+    struct NodeTreeNode
+    {
+        float m_min_x, m_min_z, m_max_x, m_max_z;
+        /** Index of the first quad of a leaf in m_tree_quads. */
+        int   m_first_quad;
+        /** Number of quads of a leaf, 0 for inner nodes. */
+        int   m_num_quads;
+        /** Index of the second child of an inner node. */
+        int   m_right;
+    };
+
+    /** A bounding volume hierarchy of all quads, so that findRoadSector
+     *  and findOutOfRoadSector only need to test the quads close to a
+     *  point. Empty until createNodeTree is called. */
+    std::vector<NodeTreeNode> m_node_tree;
+
+    /** The indices of all quads, ordered so that the quads of each leaf
+     *  of m_node_tree are stored next to each other. */
+    std::vector<int> m_tree_quads;
+
     /** The node of the graph mesh. */
     scene::ISceneNode *m_node;
 
@@ -103,6 +127,15 @@ private:
     // ------------------------------------------------------------------------
     void cleanupDebugMesh();
     // ------------------------------------------------------------------------
+    int buildNodeTree(const std::vector<NodeTreeNode> &quad_bounds,
+                      int first, int count);
+    // ------------------------------------------------------------------------
+    int findQuadInTree(const Vec3 &xyz, int first_sector,
+                       bool ignore_vertical) const;
+    // ------------------------------------------------------------------------
+    int findClosestQuadInTree(const Vec3 &xyz, int first_sector,
+                              bool test_height, bool ignore_vertical) const;
+    // ------------------------------------------------------------------------
     virtual bool hasLapLine() const = 0;
     // ------------------------------------------------------------------------
     virtual void differentNodeColor(int n, video::SColor* c) const = 0;
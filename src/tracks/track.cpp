@@ -2715,9 +2715,9 @@ std::vector< std::vector<float> > Track::buildHeightMap()
     const float x_step = x_len/HEIGHT_MAP_RESOLUTION;
     const float z_step = z_len/HEIGHT_MAP_RESOLUTION;
 
-    btVector3 hitpoint;
-    const Material* material;
-    btVector3 normal;
+    btVector3 hitpoint(0, 0, 0);
+    // Cast all rays of one row in one batch
+    std::vector<TriangleMesh::RayQuery> rays(HEIGHT_MAP_RESOLUTION);
 
     for (int i=0; i<HEIGHT_MAP_RESOLUTION; i++)
     {
@@ -2726,13 +2726,18 @@ std::vector< std::vector<float> > Track::buildHeightMap()
 
         for (int j=0; j<HEIGHT_MAP_RESOLUTION; j++)
         {
-            btVector3 pos(x, 100.0f, z);
-            btVector3 to = pos;
-            to.setY(-100000.f);
-
-            m_track_mesh->castRay(pos, to, &hitpoint, &material, &normal);
+            rays[j].m_from = btVector3(x, 100.0f, z);
+            rays[j].m_to   = rays[j].m_from;
+            rays[j].m_to.setY(-100000.f);
             z += z_step;
+        }   // j<HEIGHT_MAP_RESOLUTION
+        m_track_mesh->castRays(rays.data(), HEIGHT_MAP_RESOLUTION);
 
+        for (int j=0; j<HEIGHT_MAP_RESOLUTION; j++)
+        {
+            // If nothing was hit use the height of the previous point
+            if (rays[j].m_hit)
+                hitpoint = rays[j].m_hit_point;
             out[i][j] = hitpoint.getY();
         }   // j<HEIGHT_MAP_RESOLUTION
         x += x_step;
@@ -29,6 +29,8 @@
 #include "tracks/track_object.hpp"
 #include "utils/log.hpp"
 
+#include "LinearMath/btAabbUtil2.h"
+
 #include <IMeshSceneNode.h>
 #include <ISceneManager.h>
 
@@ -238,6 +240,7 @@ bool TrackObjectManager::castRay(const btVector3 &from,
     {
         distance = hit_point->distance(from);
     }
+    const float ray_length = (to - from).length();
     for (const TrackObject* curr : m_driveable_objects)
     {
         if (!curr->isEnabled())
@@ -245,6 +248,24 @@ bool TrackObjectManager::castRay(const btVector3 &from,
             // For example jumping pad in cocoa temple
             continue;
         }
+        // Skip objects if the ray misses their bounding box, or only hits
+        // it behind the closest hit so far, before testing all triangles.
+        // This is still a linear scan over all driveable objects, which is
+        // cheap for the few driveable objects tracks have.
+        const PhysicalObject *po = curr->getPhysicalObject();
+        if (po && po->getBody())
+        {
+            btVector3 aabb_min, aabb_max, aabb_normal;
+            po->getBody()->getAabb(aabb_min, aabb_max);
+            // Allow for rounding errors in the triangle tests
+            aabb_min -= btVector3(0.01f, 0.01f, 0.01f);
+            aabb_max += btVector3(0.01f, 0.01f, 0.01f);
+            btScalar fraction = 1.0f;
+            if (!btRayAabb(from, to, aabb_min, aabb_max, fraction,
+                           aabb_normal) ||
+                fraction * ray_length >= distance)
+                continue;
+        }
         btVector3 new_hit_point;
         const Material *new_material;
         btVector3 new_normal;
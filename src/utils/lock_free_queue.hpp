@@ -0,0 +1,190 @@
+//
+//  SuperTuxKart - a fun racing game with go-kart
+//  Copyright (C) 2024 SuperTuxKart-Team
+//
+//  This program is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU General Public License
+//  as published by the Free Software Foundation; either version 3
+//  of the License, or (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+#ifndef HEADER_LOCK_FREE_QUEUE_HPP
+#define HEADER_LOCK_FREE_QUEUE_HPP
+
+#include "utils/no_copy.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/** A bounded lock-free queue which can be used by any number of producer and
+ *  consumer threads. Each slot carries a sequence number which tells a
+ *  producer if the slot is free and a consumer if it has been published, so
+ *  push and pop only need a single compare-and-swap on the shared position
+ *  in the common case. The capacity is rounded up to a power of two. Since
+ *  the queue is bounded push() can fail, it is up to the caller to decide
+ *  what to do in this case.
+ *  TYPE should be cheap to copy, e.g. a pointer.
+ */
+template<typename TYPE>
+class LockFreeQueue : public NoCopy
+{
+private:
+    struct Cell
+    {
+        std::atomic<size_t> m_sequence;
+        TYPE                m_data;
+    };
+
+    /** Padding to keep the producer and consumer positions in different
+     *  cache lines. */
+    static const size_t CACHE_LINE_SIZE = 64;
+
+    std::vector<Cell> m_buffer;
+
+    size_t m_mask;
+
+    char m_pad0[CACHE_LINE_SIZE];
+
+    std::atomic<size_t> m_enqueue_pos;
+
+    char m_pad1[CACHE_LINE_SIZE];
+
+    std::atomic<size_t> m_dequeue_pos;
+
+    char m_pad2[CACHE_LINE_SIZE];
+
+    // ------------------------------------------------------------------------
+    /** Reserves the next free cell for a producer.
+     *  \return The cell, or NULL if the queue is full. */
+    Cell* claimPushCell()
+    {
+        size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell* cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed))
+                    return cell;
+            }
+            else if (diff < 0)
+                return NULL;
+            else
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }   // claimPushCell
+
+    // ------------------------------------------------------------------------
+    /** Makes the data of a cell claimed with claimPushCell visible to
+     *  consumers. */
+    void publish(Cell* cell)
+    {
+        size_t seq = cell->m_sequence.load(std::memory_order_relaxed);
+        cell->m_sequence.store(seq + 1, std::memory_order_release);
+    }   // publish
+
+public:
+    // ------------------------------------------------------------------------
+    /** Creates the queue.
+     *  \param capacity Minimum number of elements the queue can hold, it
+     *         will be rounded up to the next power of two. */
+    LockFreeQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity)
+            size *= 2;
+        m_buffer = std::vector<Cell>(size);
+        m_mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+            m_buffer[i].m_sequence.store(i, std::memory_order_relaxed);
+        m_enqueue_pos.store(0, std::memory_order_relaxed);
+        m_dequeue_pos.store(0, std::memory_order_relaxed);
+    }   // LockFreeQueue
+
+    // ------------------------------------------------------------------------
+    /** Adds an element at the end of the queue.
+     *  \return False if the queue is full, in which case nothing is added. */
+    bool push(const TYPE& data)
+    {
+        Cell* cell = claimPushCell();
+        if (!cell)
+            return false;
+        cell->m_data = data;
+        publish(cell);
+        return true;
+    }   // push
+
+    // ------------------------------------------------------------------------
+    /** Moves an element at the end of the queue.
+     *  \return False if the queue is full, in which case data is left
+     *          untouched. */
+    bool push(TYPE&& data)
+    {
+        Cell* cell = claimPushCell();
+        if (!cell)
+            return false;
+        cell->m_data = std::move(data);
+        publish(cell);
+        return true;
+    }   // push
+
+    // ------------------------------------------------------------------------
+    /** Removes the first element of the queue.
+     *  \param data Will contain the removed element.
+     *  \return False if the queue is empty. */
+    bool pop(TYPE* data)
+    {
+        Cell* cell;
+        size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_buffer[pos & m_mask];
+            size_t seq = cell->m_sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+        }
+        *data = std::move(cell->m_data);
+        cell->m_sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }   // pop
+
+    // ------------------------------------------------------------------------
+    /** Returns the approximate number of elements in the queue. It is only
+     *  exact if no other thread is pushing or popping at the same time. */
+    size_t size() const
+    {
+        size_t tail = m_enqueue_pos.load(std::memory_order_relaxed);
+        size_t head = m_dequeue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }   // size
+
+    // ------------------------------------------------------------------------
+    /** Returns the maximum number of elements this queue can hold. */
+    size_t capacity() const                       { return m_buffer.size(); }
+
+};   // class LockFreeQueue
+
+#endif